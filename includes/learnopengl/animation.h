@@ -6,6 +6,7 @@
 #include <assimp/scene.h>
 #include <learnopengl/bone.h>
 #include <functional>
+#include <utility>
 #include <learnopengl/animdata.h>
 #include <learnopengl/model_animation.h>
 
@@ -17,6 +18,17 @@ struct AssimpNodeData
 	std::vector<AssimpNodeData> children;
 };
 
+// one node of the hierarchy as Animator evaluates it: the tree flattened with parents before children,
+// names resolved to indices once on load
+struct AnimationNode
+{
+	glm::mat4 transformation; // used when no channel animates the node
+	glm::mat4 offset;         // of the bone, when boneID isn't -1
+	int parent;               // index of the parent node, -1 for the root
+	int channel;              // index of the Bone animating the node, -1 if none does
+	int boneID;               // slot in the final bone matrices, -1 if the node isn't a bone
+};
+
 class Animation
 {
 public:
@@ -27,13 +39,15 @@ public:
 		Assimp::Importer importer;
 		const aiScene* scene = importer.ReadFile(animationPath, aiProcess_Triangulate);
 		assert(scene && scene->mRootNode);
-		auto animation = scene->mAnimations[0];
-		m_Duration = animation->mDuration;
-		m_TicksPerSecond = animation->mTicksPerSecond;
-		aiMatrix4x4 globalTransformation = scene->mRootNode->mTransformation;
-		globalTransformation = globalTransformation.Inverse();
-		ReadHierarchyData(m_RootNode, scene->mRootNode);
-		ReadMissingBones(animation, *model);
+		Load(scene, model->GetBoneInfoMap(), model->GetBoneCount());
+	}
+
+	// reads the first animation of a scene that is already in memory; bones the model doesn't know yet are added to
+	// boneInfoMap, numbered from boneCount on
+	Animation(const aiScene* scene, std::map<std::string, BoneInfo>& boneInfoMap, int& boneCount)
+	{
+		assert(scene && scene->mRootNode);
+		Load(scene, boneInfoMap, boneCount);
 	}
 
 	~Animation()
@@ -60,14 +74,25 @@ public:
 	{ 
 		return m_BoneInfoMap;
 	}
+	inline const std::vector<AnimationNode>& GetNodes() { return m_Nodes; }
+	inline std::vector<Bone>& GetBones() { return m_Bones; }
 
 private:
-	void ReadMissingBones(const aiAnimation* animation, Model& model)
+	void Load(const aiScene* scene, std::map<std::string, BoneInfo>& boneInfoMap, int& boneCount)
 	{
-		int size = animation->mNumChannels;
+		auto animation = scene->mAnimations[0];
+		m_Duration = animation->mDuration;
+		m_TicksPerSecond = animation->mTicksPerSecond;
+		aiMatrix4x4 globalTransformation = scene->mRootNode->mTransformation;
+		globalTransformation = globalTransformation.Inverse();
+		ReadHierarchyData(m_RootNode, scene->mRootNode);
+		ReadMissingBones(animation, boneInfoMap, boneCount);
+		CompileNodes();
+	}
 
-		auto& boneInfoMap = model.GetBoneInfoMap();//getting m_BoneInfoMap from Model class
-		int& boneCount = model.GetBoneCount(); //getting the m_BoneCounter from Model class
+	void ReadMissingBones(const aiAnimation* animation, std::map<std::string, BoneInfo>& boneInfoMap, int& boneCount)
+	{
+		int size = animation->mNumChannels;
 
 		//reading channels(bones engaged in an animation and their keyframes)
 		for (int i = 0; i < size; i++)
@@ -102,10 +127,46 @@ private:
 			dest.children.push_back(newData);
 		}
 	}
+	// flattens m_RootNode into m_Nodes in depth first order, so every parent precedes its children, and looks up
+	// the channel and bone of every node by name here instead of every frame
+	void CompileNodes()
+	{
+		m_Nodes.clear();
+		std::vector<std::pair<const AssimpNodeData*, int>> stack;
+		stack.push_back({ &m_RootNode, -1 });
+		while (!stack.empty())
+		{
+			const AssimpNodeData* node = stack.back().first;
+			AnimationNode compiled;
+			compiled.transformation = node->transformation;
+			compiled.offset = glm::mat4(1.0f);
+			compiled.parent = stack.back().second;
+			compiled.channel = -1;
+			compiled.boneID = -1;
+			stack.pop_back();
+
+			Bone* bone = FindBone(node->name);
+			if (bone)
+				compiled.channel = static_cast<int>(bone - m_Bones.data());
+			auto boneInfo = m_BoneInfoMap.find(node->name);
+			if (boneInfo != m_BoneInfoMap.end())
+			{
+				compiled.boneID = boneInfo->second.id;
+				compiled.offset = boneInfo->second.offset;
+			}
+
+			const int index = static_cast<int>(m_Nodes.size());
+			m_Nodes.push_back(compiled);
+			for (int i = node->childrenCount - 1; i >= 0; i--)
+				stack.push_back({ &node->children[i], index });
+		}
+	}
+
 	float m_Duration;
 	int m_TicksPerSecond;
 	std::vector<Bone> m_Bones;
 	AssimpNodeData m_RootNode;
 	std::map<std::string, BoneInfo> m_BoneInfoMap;
+	std::vector<AnimationNode> m_Nodes;
 };
 
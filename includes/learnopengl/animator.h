@@ -29,7 +29,7 @@ public:
 		{
 			m_CurrentTime += m_CurrentAnimation->GetTicksPerSecond() * dt;
 			m_CurrentTime = fmod(m_CurrentTime, m_CurrentAnimation->GetDuration());
-			CalculateBoneTransform(&m_CurrentAnimation->GetRootNode(), glm::mat4(1.0f));
+			CalculateBoneTransforms();
 		}
 	}
 
@@ -39,40 +39,41 @@ public:
 		m_CurrentTime = 0.0f;
 	}
 
-	void CalculateBoneTransform(const AssimpNodeData* node, glm::mat4 parentTransform)
+	// one forward pass over the nodes Animation compiled on load: parents come first, so the global transform of a
+	// node's parent is always ready when the node is reached
+	void CalculateBoneTransforms()
 	{
-		std::string nodeName = node->name;
-		glm::mat4 nodeTransform = node->transformation;
+		const std::vector<AnimationNode>& nodes = m_CurrentAnimation->GetNodes();
+		std::vector<Bone>& bones = m_CurrentAnimation->GetBones();
+		if (m_GlobalTransforms.size() < nodes.size())
+			m_GlobalTransforms.resize(nodes.size());
 
-		Bone* Bone = m_CurrentAnimation->FindBone(nodeName);
-
-		if (Bone)
+		for (size_t i = 0; i < nodes.size(); i++)
 		{
-			Bone->Update(m_CurrentTime);
-			nodeTransform = Bone->GetLocalTransform();
-		}
+			const AnimationNode& node = nodes[i];
+			glm::mat4 nodeTransform = node.transformation;
+			if (node.channel >= 0)
+			{
+				Bone& bone = bones[node.channel];
+				bone.Update(m_CurrentTime);
+				nodeTransform = bone.GetLocalTransform();
+			}
 
-		glm::mat4 globalTransformation = parentTransform * nodeTransform;
+			m_GlobalTransforms[i] = node.parent >= 0 ? m_GlobalTransforms[node.parent] * nodeTransform : nodeTransform;
 
-		auto boneInfoMap = m_CurrentAnimation->GetBoneIDMap();
-		if (boneInfoMap.find(nodeName) != boneInfoMap.end())
-		{
-			int index = boneInfoMap[nodeName].id;
-			glm::mat4 offset = boneInfoMap[nodeName].offset;
-			m_FinalBoneMatrices[index] = globalTransformation * offset;
+			if (node.boneID >= 0 && node.boneID < static_cast<int>(m_FinalBoneMatrices.size()))
+				m_FinalBoneMatrices[node.boneID] = m_GlobalTransforms[i] * node.offset;
 		}
-
-		for (int i = 0; i < node->childrenCount; i++)
-			CalculateBoneTransform(&node->children[i], globalTransformation);
 	}
 
-	std::vector<glm::mat4> GetFinalBoneMatrices()
+	const std::vector<glm::mat4>& GetFinalBoneMatrices()
 	{
 		return m_FinalBoneMatrices;
 	}
 
 private:
 	std::vector<glm::mat4> m_FinalBoneMatrices;
+	std::vector<glm::mat4> m_GlobalTransforms; // per compiled node, scratch of CalculateBoneTransforms()
 	Animation* m_CurrentAnimation;
 	float m_CurrentTime;
 	float m_DeltaTime;
@@ -0,0 +1,209 @@
+#ifndef BATCH_CULLING_H
+#define BATCH_CULLING_H
+
+#include <glm/glm.hpp>
+
+#include <learnopengl/frustum.h>
+#include <learnopengl/simd.h>
+
+#include <cmath>
+#include <cstdint>
+#include <cstring>
+#include <vector>
+
+// world space bounding volumes as structure of arrays, the layout the batch tests below read 4 or 8 at a time.
+// Boxes use the extent arrays, spheres the radius array; a batch usually holds only one kind.
+struct VolumeBatch
+{
+    std::vector<float> centerX, centerY, centerZ;
+    std::vector<float> extentX, extentY, extentZ;
+    std::vector<float> radius;
+
+    size_t Size() const { return centerX.size(); }
+
+    void Clear()
+    {
+        centerX.clear(); centerY.clear(); centerZ.clear();
+        extentX.clear(); extentY.clear(); extentZ.clear();
+        radius.clear();
+    }
+
+    void AddBox(const glm::vec3 &center, const glm::vec3 &extents)
+    {
+        centerX.push_back(center.x); centerY.push_back(center.y); centerZ.push_back(center.z);
+        extentX.push_back(extents.x); extentY.push_back(extents.y); extentZ.push_back(extents.z);
+    }
+
+    void AddSphere(const glm::vec3 &center, float sphereRadius)
+    {
+        centerX.push_back(center.x); centerY.push_back(center.y); centerZ.push_back(center.z);
+        radius.push_back(sphereRadius);
+    }
+};
+
+// frustum tests over whole arrays of volumes. The result is a bitmask, bit i % 64 of word i / 64 set when volume i
+// is at least partly inside; use MaskWords() to size it. Each plane is broadcast once per call and every iteration
+// tests 8 volumes with AVX2 or 4 with SSE2 against all six planes, the rest goes through the scalar loop.
+// The tests are the ones of AABB::isOnFrustum() and Sphere::isOnFrustum() in entity.h, so results are identical.
+class BatchCulling
+{
+public:
+    static size_t MaskWords(size_t count) { return (count + 63) / 64; }
+
+    static bool IsVisible(const uint64_t *mask, size_t i) { return (mask[i / 64] >> (i % 64)) & 1u; }
+
+    // box i is visible when for every plane: dot(n, c) - d >= -dot(|n|, e)
+    static void CullBoxes(const Frustum &frustum, const VolumeBatch &batch, uint64_t *mask)
+    {
+        const size_t count = batch.Size();
+        std::memset(mask, 0, MaskWords(count) * sizeof(uint64_t));
+        float planes[6][7];
+        loadPlanes(frustum, planes);
+        const float *cx = batch.centerX.data(), *cy = batch.centerY.data(), *cz = batch.centerZ.data();
+        const float *ex = batch.extentX.data(), *ey = batch.extentY.data(), *ez = batch.extentZ.data();
+        size_t i = 0;
+#if defined(LOGL_AVX2)
+        __m256 n[6][7];
+        for (int p = 0; p < 6; p++)
+            for (int k = 0; k < 7; k++)
+                n[p][k] = _mm256_set1_ps(planes[p][k]);
+        for (; i + 8 <= count; i += 8)
+        {
+            const __m256 x = _mm256_loadu_ps(cx + i), y = _mm256_loadu_ps(cy + i), z = _mm256_loadu_ps(cz + i);
+            const __m256 a = _mm256_loadu_ps(ex + i), b = _mm256_loadu_ps(ey + i), c = _mm256_loadu_ps(ez + i);
+            __m256 visible = _mm256_castsi256_ps(_mm256_set1_epi32(-1));
+            for (int p = 0; p < 6; p++)
+            {
+                __m256 distance = _mm256_add_ps(_mm256_add_ps(_mm256_mul_ps(n[p][0], x), _mm256_mul_ps(n[p][1], y)),
+                                                _mm256_mul_ps(n[p][2], z));
+                distance = _mm256_sub_ps(distance, n[p][3]);
+                const __m256 r = _mm256_add_ps(_mm256_add_ps(_mm256_mul_ps(n[p][4], a), _mm256_mul_ps(n[p][5], b)),
+                                               _mm256_mul_ps(n[p][6], c));
+                visible = _mm256_and_ps(visible, _mm256_cmp_ps(distance, _mm256_sub_ps(_mm256_setzero_ps(), r), _CMP_GE_OQ));
+            }
+            setBits(mask, i, static_cast<uint64_t>(_mm256_movemask_ps(visible)));
+        }
+#elif defined(LOGL_SSE2)
+        __m128 n[6][7];
+        for (int p = 0; p < 6; p++)
+            for (int k = 0; k < 7; k++)
+                n[p][k] = _mm_set1_ps(planes[p][k]);
+        for (; i + 4 <= count; i += 4)
+        {
+            const __m128 x = _mm_loadu_ps(cx + i), y = _mm_loadu_ps(cy + i), z = _mm_loadu_ps(cz + i);
+            const __m128 a = _mm_loadu_ps(ex + i), b = _mm_loadu_ps(ey + i), c = _mm_loadu_ps(ez + i);
+            __m128 visible = _mm_castsi128_ps(_mm_set1_epi32(-1));
+            for (int p = 0; p < 6; p++)
+            {
+                __m128 distance = _mm_add_ps(_mm_add_ps(_mm_mul_ps(n[p][0], x), _mm_mul_ps(n[p][1], y)), _mm_mul_ps(n[p][2], z));
+                distance = _mm_sub_ps(distance, n[p][3]);
+                const __m128 r = _mm_add_ps(_mm_add_ps(_mm_mul_ps(n[p][4], a), _mm_mul_ps(n[p][5], b)), _mm_mul_ps(n[p][6], c));
+                visible = _mm_and_ps(visible, _mm_cmpge_ps(distance, _mm_sub_ps(_mm_setzero_ps(), r)));
+            }
+            setBits(mask, i, static_cast<uint64_t>(_mm_movemask_ps(visible)));
+        }
+#endif
+        for (; i < count; i++)
+        {
+            bool visible = true;
+            for (int p = 0; p < 6 && visible; p++)
+            {
+                const float distance = planes[p][0] * cx[i] + planes[p][1] * cy[i] + planes[p][2] * cz[i] - planes[p][3];
+                const float r = planes[p][4] * ex[i] + planes[p][5] * ey[i] + planes[p][6] * ez[i];
+                visible = distance >= -r;
+            }
+            if (visible)
+                setBits(mask, i, 1);
+        }
+    }
+
+    // sphere i is visible when for every plane: dot(n, c) - d > -radius
+    static void CullSpheres(const Frustum &frustum, const VolumeBatch &batch, uint64_t *mask)
+    {
+        const size_t count = batch.Size();
+        std::memset(mask, 0, MaskWords(count) * sizeof(uint64_t));
+        float planes[6][7];
+        loadPlanes(frustum, planes);
+        const float *cx = batch.centerX.data(), *cy = batch.centerY.data(), *cz = batch.centerZ.data();
+        const float *radius = batch.radius.data();
+        size_t i = 0;
+#if defined(LOGL_AVX2)
+        __m256 n[6][4];
+        for (int p = 0; p < 6; p++)
+            for (int k = 0; k < 4; k++)
+                n[p][k] = _mm256_set1_ps(planes[p][k]);
+        for (; i + 8 <= count; i += 8)
+        {
+            const __m256 x = _mm256_loadu_ps(cx + i), y = _mm256_loadu_ps(cy + i), z = _mm256_loadu_ps(cz + i);
+            const __m256 minusRadius = _mm256_sub_ps(_mm256_setzero_ps(), _mm256_loadu_ps(radius + i));
+            __m256 visible = _mm256_castsi256_ps(_mm256_set1_epi32(-1));
+            for (int p = 0; p < 6; p++)
+            {
+                __m256 distance = _mm256_add_ps(_mm256_add_ps(_mm256_mul_ps(n[p][0], x), _mm256_mul_ps(n[p][1], y)),
+                                                _mm256_mul_ps(n[p][2], z));
+                distance = _mm256_sub_ps(distance, n[p][3]);
+                visible = _mm256_and_ps(visible, _mm256_cmp_ps(distance, minusRadius, _CMP_GT_OQ));
+            }
+            setBits(mask, i, static_cast<uint64_t>(_mm256_movemask_ps(visible)));
+        }
+#elif defined(LOGL_SSE2)
+        __m128 n[6][4];
+        for (int p = 0; p < 6; p++)
+            for (int k = 0; k < 4; k++)
+                n[p][k] = _mm_set1_ps(planes[p][k]);
+        for (; i + 4 <= count; i += 4)
+        {
+            const __m128 x = _mm_loadu_ps(cx + i), y = _mm_loadu_ps(cy + i), z = _mm_loadu_ps(cz + i);
+            const __m128 minusRadius = _mm_sub_ps(_mm_setzero_ps(), _mm_loadu_ps(radius + i));
+            __m128 visible = _mm_castsi128_ps(_mm_set1_epi32(-1));
+            for (int p = 0; p < 6; p++)
+            {
+                __m128 distance = _mm_add_ps(_mm_add_ps(_mm_mul_ps(n[p][0], x), _mm_mul_ps(n[p][1], y)), _mm_mul_ps(n[p][2], z));
+                distance = _mm_sub_ps(distance, n[p][3]);
+                visible = _mm_and_ps(visible, _mm_cmpgt_ps(distance, minusRadius));
+            }
+            setBits(mask, i, static_cast<uint64_t>(_mm_movemask_ps(visible)));
+        }
+#endif
+        for (; i < count; i++)
+        {
+            bool visible = true;
+            for (int p = 0; p < 6 && visible; p++)
+                visible = planes[p][0] * cx[i] + planes[p][1] * cy[i] + planes[p][2] * cz[i] - planes[p][3] > -radius[i];
+            if (visible)
+                setBits(mask, i, 1);
+        }
+    }
+
+    // world space box of a model space box: the centre is transformed, the extents go through the absolute
+    // value of the upper 3x3, which is what projecting the rotated axes onto x, y and z amounts to
+    static void TransformBox(const glm::mat4 &world, const glm::vec3 &center, const glm::vec3 &extents,
+                             glm::vec3 &worldCenter, glm::vec3 &worldExtents)
+    {
+        worldCenter = glm::vec3(world * glm::vec4(center, 1.0f));
+        worldExtents = glm::abs(glm::vec3(world[0])) * extents.x + glm::abs(glm::vec3(world[1])) * extents.y +
+                       glm::abs(glm::vec3(world[2])) * extents.z;
+    }
+
+private:
+    // normal, distance and the absolute normal of every plane, in the order the scalar tests in entity.h use
+    static void loadPlanes(const Frustum &frustum, float planes[6][7])
+    {
+        const Plane *faces[6] = { &frustum.leftFace, &frustum.rightFace, &frustum.topFace,
+                                  &frustum.bottomFace, &frustum.nearFace, &frustum.farFace };
+        for (int p = 0; p < 6; p++)
+        {
+            const glm::vec3 &normal = faces[p]->normal;
+            planes[p][0] = normal.x; planes[p][1] = normal.y; planes[p][2] = normal.z;
+            planes[p][3] = faces[p]->distance;
+            planes[p][4] = std::abs(normal.x); planes[p][5] = std::abs(normal.y); planes[p][6] = std::abs(normal.z);
+        }
+    }
+
+    // bits never straddle two words: batches start at multiples of their width, which divides 64
+    static void setBits(uint64_t *mask, size_t first, uint64_t bits)
+    {
+        mask[first / 64] |= bits << (first % 64);
+    }
+};
+#endif
@@ -0,0 +1,162 @@
+#ifndef BOUNDS_H
+#define BOUNDS_H
+
+#include <glm/glm.hpp>
+
+#include <learnopengl/simd.h>
+
+#include <algorithm>
+#include <cmath>
+#include <cstddef>
+#include <limits>
+
+struct BoundingBox
+{
+    glm::vec3 min = glm::vec3(0.0f);
+    glm::vec3 max = glm::vec3(0.0f);
+
+    glm::vec3 Center() const { return (min + max) * 0.5f; }
+    glm::vec3 Extents() const { return (max - min) * 0.5f; }
+};
+
+struct BoundingSphere
+{
+    glm::vec3 center = glm::vec3(0.0f);
+    float radius = 0.0f;
+};
+
+// the box and sphere of one point set, in the space of its points
+struct MeshBounds
+{
+    BoundingBox box;
+    BoundingSphere sphere;
+};
+
+class Bounds
+{
+public:
+    // min/max reduction over the Position member of an array of vertices. With SSE2 each position is loaded as one
+    // vector (the fourth lane reads the next member and is ignored) into two independent min/max pairs.
+    template<typename VertexT>
+    static BoundingBox ComputeBox(const VertexT *vertices, size_t count)
+    {
+        BoundingBox box;
+        if (count == 0)
+            return box;
+        const float big = std::numeric_limits<float>::max();
+#ifdef LOGL_SSE2
+        static_assert(offsetof(VertexT, Position) + 4 * sizeof(float) <= sizeof(VertexT), "a 16 byte load at Position must stay inside the vertex");
+        __m128 min0 = _mm_set1_ps(big), min1 = min0;
+        __m128 max0 = _mm_set1_ps(-big), max1 = max0;
+        size_t i = 0;
+        for (; i + 1 < count; i += 2)
+        {
+            const __m128 a = _mm_loadu_ps(&vertices[i].Position.x);
+            const __m128 b = _mm_loadu_ps(&vertices[i + 1].Position.x);
+            min0 = _mm_min_ps(min0, a);
+            max0 = _mm_max_ps(max0, a);
+            min1 = _mm_min_ps(min1, b);
+            max1 = _mm_max_ps(max1, b);
+        }
+        if (i < count)
+        {
+            const __m128 a = _mm_loadu_ps(&vertices[i].Position.x);
+            min0 = _mm_min_ps(min0, a);
+            max0 = _mm_max_ps(max0, a);
+        }
+        float minimum[4], maximum[4];
+        _mm_storeu_ps(minimum, _mm_min_ps(min0, min1));
+        _mm_storeu_ps(maximum, _mm_max_ps(max0, max1));
+        box.min = glm::vec3(minimum[0], minimum[1], minimum[2]);
+        box.max = glm::vec3(maximum[0], maximum[1], maximum[2]);
+#else
+        box.min = glm::vec3(big);
+        box.max = glm::vec3(-big);
+        for (size_t i = 0; i < count; i++)
+        {
+            box.min = glm::min(box.min, vertices[i].Position);
+            box.max = glm::max(box.max, vertices[i].Position);
+        }
+#endif
+        return box;
+    }
+
+    // the smallest box containing both
+    static BoundingBox Merge(const BoundingBox &a, const BoundingBox &b)
+    {
+        return BoundingBox{ glm::min(a.min, b.min), glm::max(a.max, b.max) };
+    }
+
+    // Ritter's sphere: the farthest apart pair of the six axis extremes seeds it and one more pass grows it over the
+    // points left outside. The sphere around the box centre is kept instead when it happens to be smaller.
+    // forEachPoint(f) has to call f(const glm::vec3&) for every point; it is called three times.
+    template<typename ForEachPoint>
+    static BoundingSphere ComputeSphere(ForEachPoint forEachPoint, const BoundingBox &box)
+    {
+        glm::vec3 extremes[6] = { box.max, box.min, box.max, box.min, box.max, box.min }; // min x, max x, min y, ...
+        forEachPoint([&](const glm::vec3 &p)
+        {
+            for (int axis = 0; axis < 3; axis++)
+            {
+                if (p[axis] < extremes[axis * 2][axis])
+                    extremes[axis * 2] = p;
+                if (p[axis] > extremes[axis * 2 + 1][axis])
+                    extremes[axis * 2 + 1] = p;
+            }
+        });
+        int seed = 0;
+        float seedLength2 = -1.0f;
+        for (int axis = 0; axis < 3; axis++)
+        {
+            glm::vec3 span = extremes[axis * 2 + 1] - extremes[axis * 2];
+            if (glm::dot(span, span) > seedLength2)
+            {
+                seedLength2 = glm::dot(span, span);
+                seed = axis;
+            }
+        }
+
+        BoundingSphere ritter;
+        ritter.center = (extremes[seed * 2] + extremes[seed * 2 + 1]) * 0.5f;
+        ritter.radius = std::sqrt(std::max(seedLength2, 0.0f)) * 0.5f;
+        forEachPoint([&](const glm::vec3 &p)
+        {
+            glm::vec3 offset = p - ritter.center;
+            float distance2 = glm::dot(offset, offset);
+            if (distance2 <= ritter.radius * ritter.radius)
+                return;
+            // move the far side of the sphere out to the point
+            float distance = std::sqrt(distance2);
+            float radius = (ritter.radius + distance) * 0.5f;
+            ritter.center += offset * ((radius - ritter.radius) / distance);
+            ritter.radius = radius;
+        });
+
+        BoundingSphere centered;
+        centered.center = box.Center();
+        float radius2 = 0.0f;
+        forEachPoint([&](const glm::vec3 &p)
+        {
+            glm::vec3 offset = p - centered.center;
+            radius2 = std::max(radius2, glm::dot(offset, offset));
+        });
+        centered.radius = std::sqrt(radius2);
+        return centered.radius < ritter.radius ? centered : ritter;
+    }
+
+    template<typename VertexT>
+    static MeshBounds Compute(const VertexT *vertices, size_t count)
+    {
+        MeshBounds bounds;
+        if (count == 0)
+            return bounds;
+        bounds.box = ComputeBox(vertices, count);
+        bounds.sphere = ComputeSphere([vertices, count](auto &&f)
+        {
+            for (size_t i = 0; i < count; i++)
+                f(vertices[i].Position);
+        }, bounds.box);
+        return bounds;
+    }
+};
+#endif
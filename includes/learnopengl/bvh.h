@@ -0,0 +1,434 @@
+#ifndef BVH_H
+#define BVH_H
+
+#include <glm/glm.hpp>
+
+#include <learnopengl/bounds.h>
+#include <learnopengl/frustum.h>
+
+#include <algorithm>
+#include <cstdint>
+#include <limits>
+#include <vector>
+
+// dynamic bounding volume hierarchy with one object per leaf. Build() creates it top down with a binned surface area
+// heuristic; Insert(), Remove() and Move() keep it up to date afterwards, refitting the ancestors of a changed leaf
+// and rotating subtrees on the way up when that shrinks them (Kopta et al. 2012), so quality holds without rebuilds.
+// Cull() descends with a mask of the frustum planes that still have to be tested: a node fully inside a plane
+// clears its bit for the whole subtree, and once no bit is left the subtree is accepted without further tests.
+class DynamicBVH
+{
+public:
+    static const int32_t None = -1;
+
+    // builds the tree over the given boxes, replacing its contents. Leaf i stores userData[i] and has proxy id i.
+    void Build(const std::vector<BoundingBox> &boxes, const std::vector<uint32_t> &userData)
+    {
+        nodes.clear();
+        freeList = None;
+        root = None;
+        leafCount = boxes.size();
+        if (boxes.empty())
+            return;
+        nodes.resize(boxes.size());
+        for (size_t i = 0; i < boxes.size(); i++)
+            nodes[i] = Node{ boxes[i], None, None, None, userData[i] };
+        std::vector<int32_t> leaves(boxes.size());
+        for (size_t i = 0; i < leaves.size(); i++)
+            leaves[i] = static_cast<int32_t>(i);
+        root = buildRange(leaves.data(), leaves.size());
+        nodes[root].parent = None;
+    }
+
+    // adds a leaf and returns its proxy id
+    int32_t Insert(const BoundingBox &box, uint32_t userData)
+    {
+        int32_t leaf = allocate();
+        nodes[leaf] = Node{ box, None, None, None, userData };
+        insertLeaf(leaf);
+        leafCount++;
+        return leaf;
+    }
+
+    void Remove(int32_t proxy)
+    {
+        removeLeaf(proxy);
+        release(proxy);
+        leafCount--;
+    }
+
+    // gives a leaf a new box: the ancestors are refitted, and rotated where that lowers their surface area
+    void Move(int32_t proxy, const BoundingBox &box)
+    {
+        nodes[proxy].box = box;
+        refitFrom(nodes[proxy].parent);
+    }
+
+    // gives a leaf a new box without touching its ancestors, Refit() has to follow before the next Cull()
+    void SetBox(int32_t proxy, const BoundingBox &box) { nodes[proxy].box = box; }
+
+    // recomputes every internal box bottom up in one pass, cheaper than Move() once a large part of the leaves moved
+    // but without rotations, so the tree keeps its shape
+    void Refit()
+    {
+        if (root == None)
+            return;
+        // children are pushed after their parent, so walking the order backwards visits them first
+        std::vector<int32_t> order(1, root);
+        for (size_t i = 0; i < order.size(); i++)
+        {
+            if (!isLeaf(order[i]))
+            {
+                order.push_back(nodes[order[i]].left);
+                order.push_back(nodes[order[i]].right);
+            }
+        }
+        for (size_t i = order.size(); i-- > 0;)
+        {
+            Node &node = nodes[order[i]];
+            if (node.left != None)
+                node.box = Bounds::Merge(nodes[node.left].box, nodes[node.right].box);
+        }
+    }
+
+    const BoundingBox& Box(int32_t proxy) const { return nodes[proxy].box; }
+    uint32_t UserData(int32_t proxy) const { return nodes[proxy].userData; }
+    size_t LeafCount() const { return leafCount; }
+
+    // sum of the internal node surface areas relative to the root's, the usual measure of tree quality (lower is better)
+    float Cost() const
+    {
+        if (root == None || isLeaf(root))
+            return 0.0f;
+        float total = 0.0f;
+        forEachNode(root, [&](int32_t node)
+        {
+            if (!isLeaf(node))
+                total += area(nodes[node].box);
+        });
+        return total / area(nodes[root].box);
+    }
+
+    // calls visit(userData) for every leaf whose box is not completely outside one of the frustum planes
+    template<typename Visit>
+    void Cull(const Frustum &frustum, Visit visit) const
+    {
+        if (root == None)
+            return;
+        const Plane planes[6] = { frustum.leftFace, frustum.rightFace, frustum.nearFace, frustum.farFace, frustum.topFace, frustum.bottomFace };
+        struct Entry { int32_t node; uint32_t mask; };
+        std::vector<Entry> stack;
+        stack.reserve(64);
+        stack.push_back(Entry{ root, 0x3fu });
+        while (!stack.empty())
+        {
+            const Entry entry = stack.back();
+            stack.pop_back();
+            const Node &node = nodes[entry.node];
+            uint32_t mask = entry.mask;
+            if (mask != 0)
+            {
+                const glm::vec3 center = node.box.Center(), extents = node.box.Extents();
+                bool outside = false;
+                for (int p = 0; p < 6; p++)
+                {
+                    if (!(mask & (1u << p)))
+                        continue;
+                    const float distance = planes[p].getSignedDistanceToPlane(center);
+                    const float radius = glm::dot(extents, glm::abs(planes[p].normal));
+                    if (distance < -radius)
+                    {
+                        outside = true;
+                        break;
+                    }
+                    if (distance >= radius)
+                        mask &= ~(1u << p); // the whole subtree is inside this plane
+                }
+                if (outside)
+                    continue;
+            }
+            if (node.left == None)
+                visit(node.userData);
+            else
+            {
+                // with an empty mask the subtree is accepted, its nodes are only walked down to the leaves
+                stack.push_back(Entry{ node.right, mask });
+                stack.push_back(Entry{ node.left, mask });
+            }
+        }
+    }
+
+private:
+    struct Node
+    {
+        BoundingBox box;
+        int32_t parent;
+        int32_t left;  // None for leaves
+        int32_t right; // next free node while on the free list
+        uint32_t userData;
+    };
+
+    std::vector<Node> nodes;
+    int32_t root = None;
+    int32_t freeList = None;
+    size_t leafCount = 0;
+
+    static float area(const BoundingBox &box)
+    {
+        glm::vec3 d = glm::max(box.max - box.min, glm::vec3(0.0f));
+        return 2.0f * (d.x * d.y + d.y * d.z + d.z * d.x);
+    }
+
+    bool isLeaf(int32_t node) const { return nodes[node].left == None; }
+
+    template<typename F>
+    void forEachNode(int32_t start, F f) const
+    {
+        std::vector<int32_t> stack(1, start);
+        while (!stack.empty())
+        {
+            int32_t node = stack.back();
+            stack.pop_back();
+            f(node);
+            if (!isLeaf(node))
+            {
+                stack.push_back(nodes[node].right);
+                stack.push_back(nodes[node].left);
+            }
+        }
+    }
+
+    int32_t allocate()
+    {
+        if (freeList != None)
+        {
+            int32_t node = freeList;
+            freeList = nodes[node].right;
+            return node;
+        }
+        nodes.push_back(Node());
+        return static_cast<int32_t>(nodes.size() - 1);
+    }
+
+    void release(int32_t node)
+    {
+        nodes[node].left = None;
+        nodes[node].right = freeList;
+        freeList = node;
+    }
+
+    int32_t makeParent(int32_t left, int32_t right)
+    {
+        int32_t node = allocate();
+        nodes[node] = Node{ Bounds::Merge(nodes[left].box, nodes[right].box), None, left, right, 0 };
+        nodes[left].parent = node;
+        nodes[right].parent = node;
+        return node;
+    }
+
+    // top down build: split at the cheapest of 12 centroid bins along the widest axis
+    int32_t buildRange(int32_t *leaves, size_t count)
+    {
+        if (count == 1)
+            return leaves[0];
+
+        BoundingBox centroids{ nodes[leaves[0]].box.Center(), nodes[leaves[0]].box.Center() };
+        for (size_t i = 1; i < count; i++)
+        {
+            glm::vec3 c = nodes[leaves[i]].box.Center();
+            centroids.min = glm::min(centroids.min, c);
+            centroids.max = glm::max(centroids.max, c);
+        }
+        glm::vec3 size = centroids.max - centroids.min;
+        int axis = size.x > size.y ? (size.x > size.z ? 0 : 2) : (size.y > size.z ? 1 : 2);
+
+        size_t split = count / 2;
+        if (size[axis] > 0.0f)
+        {
+            const int BinCount = 12;
+            struct Bin { BoundingBox box; size_t count = 0; } bins[BinCount];
+            const float scale = BinCount / size[axis];
+            auto binOf = [&](int32_t leaf)
+            {
+                int b = static_cast<int>((nodes[leaf].box.Center()[axis] - centroids.min[axis]) * scale);
+                return std::min(b, BinCount - 1);
+            };
+            for (size_t i = 0; i < count; i++)
+            {
+                Bin &bin = bins[binOf(leaves[i])];
+                bin.box = bin.count == 0 ? nodes[leaves[i]].box : Bounds::Merge(bin.box, nodes[leaves[i]].box);
+                bin.count++;
+            }
+            // sweep from the right for the suffix areas, then from the left evaluating every boundary
+            float rightArea[BinCount];
+            size_t rightCount[BinCount];
+            BoundingBox accumulated;
+            size_t accumulatedCount = 0;
+            for (int b = BinCount - 1; b > 0; b--)
+            {
+                if (bins[b].count > 0)
+                    accumulated = accumulatedCount == 0 ? bins[b].box : Bounds::Merge(accumulated, bins[b].box);
+                accumulatedCount += bins[b].count;
+                rightArea[b] = accumulatedCount > 0 ? area(accumulated) : 0.0f;
+                rightCount[b] = accumulatedCount;
+            }
+            float bestCost = std::numeric_limits<float>::max();
+            int bestBin = -1;
+            accumulatedCount = 0;
+            for (int b = 0; b < BinCount - 1; b++)
+            {
+                if (bins[b].count > 0)
+                    accumulated = accumulatedCount == 0 ? bins[b].box : Bounds::Merge(accumulated, bins[b].box);
+                accumulatedCount += bins[b].count;
+                if (accumulatedCount == 0 || rightCount[b + 1] == 0)
+                    continue;
+                float cost = area(accumulated) * accumulatedCount + rightArea[b + 1] * rightCount[b + 1];
+                if (cost < bestCost)
+                {
+                    bestCost = cost;
+                    bestBin = b;
+                }
+            }
+            if (bestBin >= 0)
+            {
+                int32_t *middle = std::partition(leaves, leaves + count, [&](int32_t leaf) { return binOf(leaf) <= bestBin; });
+                split = static_cast<size_t>(middle - leaves);
+            }
+        }
+        if (split == 0 || split == count)
+        {
+            // all centroids in one bin: split by median
+            split = count / 2;
+            std::nth_element(leaves, leaves + split, leaves + count, [&](int32_t a, int32_t b)
+            {
+                return nodes[a].box.Center()[axis] < nodes[b].box.Center()[axis];
+            });
+        }
+        int32_t left = buildRange(leaves, split);
+        int32_t right = buildRange(leaves + split, count - split);
+        return makeParent(left, right);
+    }
+
+    // descends to the sibling whose box grows least (Box2D style), then refits and rotates on the way back up
+    void insertLeaf(int32_t leaf)
+    {
+        if (root == None)
+        {
+            root = leaf;
+            nodes[leaf].parent = None;
+            return;
+        }
+        const BoundingBox box = nodes[leaf].box;
+        int32_t sibling = root;
+        while (!isLeaf(sibling))
+        {
+            const Node &node = nodes[sibling];
+            const float combined = area(Bounds::Merge(node.box, box));
+            // pushing the leaf further down costs the growth of this node at least
+            const float inheritance = combined - area(node.box);
+            auto descendCost = [&](int32_t child)
+            {
+                float grown = area(Bounds::Merge(nodes[child].box, box));
+                return isLeaf(child) ? grown + inheritance : grown - area(nodes[child].box) + inheritance;
+            };
+            const float here = 2.0f * combined;
+            const float left = descendCost(node.left), right = descendCost(node.right);
+            if (here < left && here < right)
+                break;
+            sibling = left < right ? node.left : node.right;
+        }
+
+        int32_t oldParent = nodes[sibling].parent;
+        int32_t parent = makeParent(sibling, leaf);
+        nodes[parent].parent = oldParent;
+        if (oldParent == None)
+            root = parent;
+        else if (nodes[oldParent].left == sibling)
+            nodes[oldParent].left = parent;
+        else
+            nodes[oldParent].right = parent;
+        refitFrom(oldParent);
+    }
+
+    void removeLeaf(int32_t leaf)
+    {
+        if (leaf == root)
+        {
+            root = None;
+            return;
+        }
+        int32_t parent = nodes[leaf].parent;
+        int32_t grandParent = nodes[parent].parent;
+        int32_t sibling = nodes[parent].left == leaf ? nodes[parent].right : nodes[parent].left;
+        if (grandParent == None)
+        {
+            root = sibling;
+            nodes[sibling].parent = None;
+        }
+        else
+        {
+            if (nodes[grandParent].left == parent)
+                nodes[grandParent].left = sibling;
+            else
+                nodes[grandParent].right = sibling;
+            nodes[sibling].parent = grandParent;
+        }
+        release(parent);
+        refitFrom(grandParent);
+    }
+
+    // recomputes the boxes from node up to the root, trying a rotation at every level
+    void refitFrom(int32_t node)
+    {
+        while (node != None)
+        {
+            rotate(node);
+            nodes[node].box = Bounds::Merge(nodes[nodes[node].left].box, nodes[nodes[node].right].box);
+            node = nodes[node].parent;
+        }
+    }
+
+    // swaps a child of node with a grandchild on the other side when that shrinks the child it moves into
+    void rotate(int32_t node)
+    {
+        const int32_t children[2] = { nodes[node].left, nodes[node].right };
+        float bestGain = 0.0f;
+        int32_t bestChild = None, bestGrandChild = None;
+        for (int c = 0; c < 2; c++)
+        {
+            const int32_t child = children[c], other = children[1 - c];
+            if (isLeaf(other))
+                continue;
+            // move child down into other, in place of one of other's children
+            const int32_t grandChildren[2] = { nodes[other].left, nodes[other].right };
+            for (int g = 0; g < 2; g++)
+            {
+                const float after = area(Bounds::Merge(nodes[child].box, nodes[grandChildren[1 - g]].box));
+                const float gain = area(nodes[other].box) - after;
+                if (gain > bestGain)
+                {
+                    bestGain = gain;
+                    bestChild = child;
+                    bestGrandChild = grandChildren[g];
+                }
+            }
+        }
+        if (bestChild == None)
+            return;
+
+        // bestChild and bestGrandChild trade places
+        const int32_t other = nodes[node].left == bestChild ? nodes[node].right : nodes[node].left;
+        if (nodes[node].left == bestChild)
+            nodes[node].left = bestGrandChild;
+        else
+            nodes[node].right = bestGrandChild;
+        if (nodes[other].left == bestGrandChild)
+            nodes[other].left = bestChild;
+        else
+            nodes[other].right = bestChild;
+        nodes[bestGrandChild].parent = node;
+        nodes[bestChild].parent = other;
+        nodes[other].box = Bounds::Merge(nodes[nodes[other].left].box, nodes[nodes[other].right].box);
+    }
+};
+#endif
@@ -2,113 +2,135 @@
 #define ENTITY_H
 
 #include <glm/glm.hpp> //glm::mat4
-#include <list> //std::list
+#include <vector> //std::vector
 #include <array> //std::array
 #include <memory> //std::unique_ptr
-
+#include <string> //std::string
+#include <unordered_map> //std::unordered_map
+#include <iostream> //std::cout
+
+#include <learnopengl/frustum.h> //Plane, Frustum
+#include <learnopengl/bvh.h> //DynamicBVH
+#include <learnopengl/batch_culling.h> //VolumeBatch, BatchCulling
+#include <learnopengl/occlusion_culling.h> //OcclusionCuller
+#include <learnopengl/render_queue.h> //RenderQueue
+#include <learnopengl/scene_file.h> //SceneFile
+#include <learnopengl/spatial_hash.h> //SpatialHash
+#include <learnopengl/transform_hierarchy.h> //TransformHierarchy
+
+//Handle to one node of a TransformHierarchy, which stores the data
+//References returned by the getters are invalidated when nodes are added to the hierarchy
 class Transform
 {
 protected:
-	//Local space information
-	glm::vec3 m_pos = { 0.0f, 0.0f, 0.0f };
-	glm::vec3 m_eulerRot = { 0.0f, 0.0f, 0.0f }; //In degrees
-	glm::vec3 m_scale = { 1.0f, 1.0f, 1.0f };
-
-	//Global space information concatenate in matrix
-	glm::mat4 m_modelMatrix = glm::mat4(1.0f);
-
-	//Dirty flag
-	bool m_isDirty = true;
+	TransformHierarchy* m_hierarchy = nullptr;
+	uint32_t m_node = TransformHierarchy::None;
 
 protected:
-	glm::mat4 getLocalModelMatrix()
+	//Cached by the hierarchy, only rebuilt after the local TRS changed
+	const glm::mat4& getLocalModelMatrix() const
 	{
-		const glm::mat4 transformX = glm::rotate(glm::mat4(1.0f), glm::radians(m_eulerRot.x), glm::vec3(1.0f, 0.0f, 0.0f));
-		const glm::mat4 transformY = glm::rotate(glm::mat4(1.0f), glm::radians(m_eulerRot.y), glm::vec3(0.0f, 1.0f, 0.0f));
-		const glm::mat4 transformZ = glm::rotate(glm::mat4(1.0f), glm::radians(m_eulerRot.z), glm::vec3(0.0f, 0.0f, 1.0f));
+		return m_hierarchy->LocalMatrix(m_node);
+	}
+public:
+	Transform() = default;
 
-		// Y * X * Z
-		const glm::mat4 rotationMatrix = transformY * transformX * transformZ;
+	Transform(TransformHierarchy& hierarchy, uint32_t node)
+		: m_hierarchy{ &hierarchy }, m_node{ node }
+	{}
 
-		// translation * rotation * scale (also know as TRS matrix)
-		return glm::translate(glm::mat4(1.0f), m_pos) * rotationMatrix * glm::scale(glm::mat4(1.0f), m_scale);
+	TransformHierarchy& getHierarchy() const
+	{
+		return *m_hierarchy;
+	}
+
+	uint32_t getNode() const
+	{
+		return m_node;
 	}
-public:
 
 	void computeModelMatrix()
 	{
-		m_modelMatrix = getLocalModelMatrix();
-		m_isDirty = false;
+		m_hierarchy->world[m_node] = getLocalModelMatrix();
+		m_hierarchy->dirty[m_node] = 0;
 	}
 
 	void computeModelMatrix(const glm::mat4& parentGlobalModelMatrix)
 	{
-		m_modelMatrix = parentGlobalModelMatrix * getLocalModelMatrix();
-		m_isDirty = false;
+		m_hierarchy->world[m_node] = parentGlobalModelMatrix * getLocalModelMatrix();
+		m_hierarchy->dirty[m_node] = 0;
 	}
 
 	void setLocalPosition(const glm::vec3& newPosition)
 	{
-		m_pos = newPosition;
-		m_isDirty = true;
+		m_hierarchy->SetLocalPosition(m_node, newPosition);
 	}
 
 	void setLocalRotation(const glm::vec3& newRotation)
 	{
-		m_eulerRot = newRotation;
-		m_isDirty = true;
+		m_hierarchy->SetLocalRotation(m_node, newRotation);
+	}
+
+	void setLocalOrientation(const glm::quat& newOrientation)
+	{
+		m_hierarchy->SetLocalOrientation(m_node, newOrientation);
 	}
 
 	void setLocalScale(const glm::vec3& newScale)
 	{
-		m_scale = newScale;
-		m_isDirty = true;
+		m_hierarchy->SetLocalScale(m_node, newScale);
 	}
 
-	const glm::vec3& getGlobalPosition() const
+	glm::vec3 getGlobalPosition() const
 	{
-		return m_modelMatrix[3];
+		return m_hierarchy->world[m_node][3];
 	}
 
 	const glm::vec3& getLocalPosition() const
 	{
-		return m_pos;
+		return m_hierarchy->localPosition[m_node];
 	}
 
+	//Euler angles in degrees, kept for editing; the rotation itself is stored as a quaternion
 	const glm::vec3& getLocalRotation() const
 	{
-		return m_eulerRot;
+		return m_hierarchy->localRotation[m_node];
+	}
+
+	const glm::quat& getLocalOrientation() const
+	{
+		return m_hierarchy->localOrientation[m_node];
 	}
 
 	const glm::vec3& getLocalScale() const
 	{
-		return m_scale;
+		return m_hierarchy->localScale[m_node];
 	}
 
 	const glm::mat4& getModelMatrix() const
 	{
-		return m_modelMatrix;
+		return m_hierarchy->world[m_node];
 	}
 
 	glm::vec3 getRight() const
 	{
-		return m_modelMatrix[0];
+		return getModelMatrix()[0];
 	}
 
 
 	glm::vec3 getUp() const
 	{
-		return m_modelMatrix[1];
+		return getModelMatrix()[1];
 	}
 
 	glm::vec3 getBackward() const
 	{
-		return m_modelMatrix[2];
+		return getModelMatrix()[2];
 	}
 
 	glm::vec3 getForward() const
 	{
-		return -m_modelMatrix[2];
+		return -getModelMatrix()[2];
 	}
 
 	glm::vec3 getGlobalScale() const
@@ -118,40 +140,10 @@ public:
 
 	bool isDirty() const
 	{
-		return m_isDirty;
-	}
-};
-
-struct Plane
-{
-	glm::vec3 normal = { 0.f, 1.f, 0.f }; // unit vector
-	float     distance = 0.f;        // Distance with origin
-
-	Plane() = default;
-
-	Plane(const glm::vec3& p1, const glm::vec3& norm)
-		: normal(glm::normalize(norm)),
-		distance(glm::dot(normal, p1))
-	{}
-
-	float getSignedDistanceToPlane(const glm::vec3& point) const
-	{
-		return glm::dot(normal, point) - distance;
+		return m_hierarchy->dirty[m_node] != 0;
 	}
 };
 
-struct Frustum
-{
-	Plane topFace;
-	Plane bottomFace;
-
-	Plane rightFace;
-	Plane leftFace;
-
-	Plane farFace;
-	Plane nearFace;
-};
-
 struct BoundingVolume
 {
 	virtual bool isOnFrustum(const Frustum& camFrustum, const Transform& transform) const = 0;
@@ -194,8 +186,8 @@ struct Sphere : public BoundingVolume
 		//To wrap correctly our shape, we need the maximum scale scalar.
 		const float maxScale = std::max(std::max(globalScale.x, globalScale.y), globalScale.z);
 
-		//Max scale is assuming for the diameter. So, we need the half to apply it to our radius
-		Sphere globalSphere(globalCenter, radius * (maxScale * 0.5f));
+		//The radius scales with the largest axis scale
+		Sphere globalSphere(globalCenter, radius * maxScale);
 
 		//Check Firstly the result that have the most chance to failure to avoid to call all functions.
 		return (globalSphere.isOnOrForwardPlane(camFrustum.leftFace) &&
@@ -283,6 +275,14 @@ struct AABB : public BoundingVolume
 		return vertice;
 	}
 
+	//Box around this one after transforming it, the extents are projected through the absolute rotation and scale
+	AABB toWorld(const glm::mat4& world) const
+	{
+		glm::vec3 globalCenter, globalExtents;
+		BatchCulling::TransformBox(world, center, extents, globalCenter, globalExtents);
+		return AABB(globalCenter, globalExtents.x, globalExtents.y, globalExtents.z);
+	}
+
 	//see https://gdbooks.gitbooks.io/3dcollisions/content/Chapter2/static_aabb_plane.html
 	bool isOnOrForwardPlane(const Plane& plane) const final
 	{
@@ -295,27 +295,7 @@ struct AABB : public BoundingVolume
 
 	bool isOnFrustum(const Frustum& camFrustum, const Transform& transform) const final
 	{
-		//Get global scale thanks to our transform
-		const glm::vec3 globalCenter{ transform.getModelMatrix() * glm::vec4(center, 1.f) };
-
-		// Scaled orientation
-		const glm::vec3 right = transform.getRight() * extents.x;
-		const glm::vec3 up = transform.getUp() * extents.y;
-		const glm::vec3 forward = transform.getForward() * extents.z;
-
-		const float newIi = std::abs(glm::dot(glm::vec3{ 1.f, 0.f, 0.f }, right)) +
-			std::abs(glm::dot(glm::vec3{ 1.f, 0.f, 0.f }, up)) +
-			std::abs(glm::dot(glm::vec3{ 1.f, 0.f, 0.f }, forward));
-
-		const float newIj = std::abs(glm::dot(glm::vec3{ 0.f, 1.f, 0.f }, right)) +
-			std::abs(glm::dot(glm::vec3{ 0.f, 1.f, 0.f }, up)) +
-			std::abs(glm::dot(glm::vec3{ 0.f, 1.f, 0.f }, forward));
-
-		const float newIk = std::abs(glm::dot(glm::vec3{ 0.f, 0.f, 1.f }, right)) +
-			std::abs(glm::dot(glm::vec3{ 0.f, 0.f, 1.f }, up)) +
-			std::abs(glm::dot(glm::vec3{ 0.f, 0.f, 1.f }, forward));
-
-		const AABB globalAABB(globalCenter, newIi, newIj, newIk);
+		const AABB globalAABB = toWorld(transform.getModelMatrix());
 
 		return (globalAABB.isOnOrForwardPlane(camFrustum.leftFace) &&
 			globalAABB.isOnOrForwardPlane(camFrustum.rightFace) &&
@@ -342,133 +322,151 @@ Frustum createFrustumFromCamera(const Camera& cam, float aspect, float fovY, flo
 	return frustum;
 }
 
+//Bounds are computed once when the model loads, these only wrap the cached values
 AABB generateAABB(const Model& model)
 {
-	glm::vec3 minAABB = glm::vec3(std::numeric_limits<float>::max());
-	glm::vec3 maxAABB = glm::vec3(std::numeric_limits<float>::min());
-	for (auto&& mesh : model.meshes)
-	{
-		for (auto&& vertex : mesh.vertices)
-		{
-			minAABB.x = std::min(minAABB.x, vertex.Position.x);
-			minAABB.y = std::min(minAABB.y, vertex.Position.y);
-			minAABB.z = std::min(minAABB.z, vertex.Position.z);
-
-			maxAABB.x = std::max(maxAABB.x, vertex.Position.x);
-			maxAABB.y = std::max(maxAABB.y, vertex.Position.y);
-			maxAABB.z = std::max(maxAABB.z, vertex.Position.z);
-		}
-	}
-	return AABB(minAABB, maxAABB);
+	return AABB(model.bounds.box.min, model.bounds.box.max);
 }
 
 Sphere generateSphereBV(const Model& model)
 {
-	glm::vec3 minAABB = glm::vec3(std::numeric_limits<float>::max());
-	glm::vec3 maxAABB = glm::vec3(std::numeric_limits<float>::min());
-	for (auto&& mesh : model.meshes)
-	{
-		for (auto&& vertex : mesh.vertices)
-		{
-			minAABB.x = std::min(minAABB.x, vertex.Position.x);
-			minAABB.y = std::min(minAABB.y, vertex.Position.y);
-			minAABB.z = std::min(minAABB.z, vertex.Position.z);
-
-			maxAABB.x = std::max(maxAABB.x, vertex.Position.x);
-			maxAABB.y = std::max(maxAABB.y, vertex.Position.y);
-			maxAABB.z = std::max(maxAABB.z, vertex.Position.z);
-		}
-	}
-
-	return Sphere((maxAABB + minAABB) * 0.5f, glm::length(minAABB - maxAABB));
+	return Sphere(model.bounds.sphere.center, model.bounds.sphere.radius);
 }
 
 class Entity
 {
 public:
 	//Scene graph
-	std::list<std::unique_ptr<Entity>> children;
+	std::vector<std::unique_ptr<Entity>> children;
 	Entity* parent = nullptr;
 
-	//Space information
+	//Space information, stored in the hierarchy shared by the whole tree
+	std::shared_ptr<TransformHierarchy> hierarchy;
 	Transform transform;
 
 	Model* pModel = nullptr;
-	std::unique_ptr<AABB> boundingVolume;
+	//Model space box, copied from the bounds the model cached on load
+	AABB boundingVolume;
 
 
-	// constructor, expects a filepath to a 3D model.
-	Entity(Model& model) : pModel{ &model }
+	// constructor, expects a filepath to a 3D model. The entity is the root of a new tree.
+	Entity(Model& model)
+		: hierarchy{ std::make_shared<TransformHierarchy>() }, pModel{ &model }, boundingVolume{ generateAABB(model) }
 	{
-		boundingVolume = std::make_unique<AABB>(generateAABB(model));
-		//boundingVolume = std::make_unique<Sphere>(generateSphereBV(model));
+		transform = Transform(*hierarchy, hierarchy->Create());
 	}
 
-	AABB getGlobalAABB()
+	// constructor of a child, its node is appended to the parent's hierarchy
+	Entity(Entity& parentEntity, Model& model)
+		: parent{ &parentEntity }, hierarchy{ parentEntity.hierarchy }, pModel{ &model }, boundingVolume{ generateAABB(model) }
 	{
-		//Get global scale thanks to our transform
-		const glm::vec3 globalCenter{ transform.getModelMatrix() * glm::vec4(boundingVolume->center, 1.f) };
+		transform = Transform(*hierarchy, hierarchy->Create(parentEntity.transform.getNode()));
+	}
 
-		// Scaled orientation
-		const glm::vec3 right = transform.getRight() * boundingVolume->extents.x;
-		const glm::vec3 up = transform.getUp() * boundingVolume->extents.y;
-		const glm::vec3 forward = transform.getForward() * boundingVolume->extents.z;
+	// constructor adopting a node that already exists in sharedHierarchy, used by loadScene()
+	Entity(Entity* parentEntity, const std::shared_ptr<TransformHierarchy>& sharedHierarchy, uint32_t node, Model& model, const AABB& bounds)
+		: parent{ parentEntity }, hierarchy{ sharedHierarchy }, transform{ *sharedHierarchy, node }, pModel{ &model }, boundingVolume{ bounds }
+	{}
 
-		const float newIi = std::abs(glm::dot(glm::vec3{ 1.f, 0.f, 0.f }, right)) +
-			std::abs(glm::dot(glm::vec3{ 1.f, 0.f, 0.f }, up)) +
-			std::abs(glm::dot(glm::vec3{ 1.f, 0.f, 0.f }, forward));
+	//Write the whole tree to a binary scene file (see scene_file.h) in one pass over the entities; models are stored
+	//by path in order of first use. Only a root whose hierarchy holds nothing but this tree can be saved.
+	bool saveScene(const std::string& path)
+	{
+		if (parent != nullptr || transform.getNode() != 0)
+		{
+			std::cout << "ERROR::SCENE::SAVE: only the root of a tree can be saved" << std::endl;
+			return false;
+		}
+		const size_t count = hierarchy->Size();
+		std::vector<uint32_t> models(count, 0);
+		std::vector<BoundingBox> bounds(count);
+		std::vector<std::string> modelPaths;
+		std::unordered_map<const Model*, uint32_t> modelIndex;
+		size_t visited = 0;
+		collectScene(models, bounds, modelPaths, modelIndex, visited);
+		if (visited != count)
+		{
+			std::cout << "ERROR::SCENE::SAVE: the hierarchy holds nodes outside of this tree" << std::endl;
+			return false;
+		}
+		return SceneFile::Write(path, *hierarchy, models, bounds, modelPaths);
+	}
 
-		const float newIj = std::abs(glm::dot(glm::vec3{ 0.f, 1.f, 0.f }, right)) +
-			std::abs(glm::dot(glm::vec3{ 0.f, 1.f, 0.f }, up)) +
-			std::abs(glm::dot(glm::vec3{ 0.f, 1.f, 0.f }, forward));
+	//Rebuild a tree saved by saveScene(). models[i] is the model stored under scene.modelPath(i).
+	//The transforms are taken over as whole arrays; the entities themselves are created parent before child.
+	static std::unique_ptr<Entity> loadScene(const SceneFile& scene, const std::vector<Model*>& models)
+	{
+		const uint32_t count = scene.nodeCount();
+		const uint32_t* parents = scene.parents();
+		if (count == 0 || parents[0] != TransformHierarchy::None || models.size() < scene.modelCount())
+		{
+			std::cout << "ERROR::SCENE::LOAD: expected one root and a model for every model path" << std::endl;
+			return nullptr;
+		}
+		std::vector<uint32_t> childCount(count, 0);
+		for (uint32_t i = 1; i < count; i++)
+		{
+			if (parents[i] == TransformHierarchy::None)
+			{
+				std::cout << "ERROR::SCENE::LOAD: expected one root and a model for every model path" << std::endl;
+				return nullptr;
+			}
+			childCount[parents[i]]++;
+		}
 
-		const float newIk = std::abs(glm::dot(glm::vec3{ 0.f, 0.f, 1.f }, right)) +
-			std::abs(glm::dot(glm::vec3{ 0.f, 0.f, 1.f }, up)) +
-			std::abs(glm::dot(glm::vec3{ 0.f, 0.f, 1.f }, forward));
+		auto sharedHierarchy = std::make_shared<TransformHierarchy>();
+		scene.assignTo(*sharedHierarchy);
+		const uint32_t* modelIds = scene.models();
+		const BoundingBox* bounds = scene.bounds();
+		auto entityBounds = [&](uint32_t i) { return AABB(bounds[i].min, bounds[i].max); };
 
-		return AABB(globalCenter, newIi, newIj, newIk);
+		std::vector<Entity*> byNode(count);
+		std::unique_ptr<Entity> root = std::make_unique<Entity>(nullptr, sharedHierarchy, 0, *models[modelIds[0]], entityBounds(0));
+		byNode[0] = root.get();
+		for (uint32_t i = 0; i < count; i++)
+		{
+			if (i > 0)
+			{
+				Entity& parentEntity = *byNode[parents[i]];
+				parentEntity.children.emplace_back(std::make_unique<Entity>(&parentEntity, sharedHierarchy, i, *models[modelIds[i]], entityBounds(i)));
+				byNode[i] = parentEntity.children.back().get();
+			}
+			byNode[i]->children.reserve(childCount[i]);
+		}
+		root->forceUpdateSelfAndChild();
+		return root;
+	}
+
+	AABB getGlobalAABB()
+	{
+		return boundingVolume.toWorld(transform.getModelMatrix());
 	}
 
-	//Add child. Argument input is argument of any constructor that you create. By default you can use the default constructor and don't put argument input.
+	//Add child. Argument input is argument of any constructor that you create, the new entity's parent is passed in front of them.
 	template<typename... TArgs>
 	void addChild(TArgs&... args)
 	{
-		children.emplace_back(std::make_unique<Entity>(args...));
-		children.back()->parent = this;
+		children.emplace_back(std::make_unique<Entity>(*this, args...));
 	}
 
-	//Update transform if it was changed
+	//Update transforms that were changed in this entity and everything below it. On the root that is one pass over the
+	//whole tree, updated level by level on the shared job system when it is large; on any other entity only its
+	//subtree, the rest of the tree keeps its pending changes and this entity's parent is used as it is.
 	void updateSelfAndChild()
 	{
-		if (transform.isDirty()) {
-			forceUpdateSelfAndChild();
-			return;
-		}
-			
-		for (auto&& child : children)
-		{
-			child->updateSelfAndChild();
-		}
+		update(false);
 	}
 
 	//Force update of transform even if local space don't change
 	void forceUpdateSelfAndChild()
 	{
-		if (parent)
-			transform.computeModelMatrix(parent->transform.getModelMatrix());
-		else
-			transform.computeModelMatrix();
-
-		for (auto&& child : children)
-		{
-			child->forceUpdateSelfAndChild();
-		}
+		update(true);
 	}
 
 
 	void drawSelfAndChild(const Frustum& frustum, Shader& ourShader, unsigned int& display, unsigned int& total)
 	{
-		if (boundingVolume->isOnFrustum(frustum, transform))
+		if (boundingVolume.isOnFrustum(frustum, transform))
 		{
 			ourShader.setMat4("model", transform.getModelMatrix());
 			pModel->Draw(ourShader);
@@ -481,5 +479,339 @@ public:
 			child->drawSelfAndChild(frustum, ourShader, display, total);
 		}
 	}
+
+	//Same culling as drawSelfAndChild(), but the visible meshes go into the queue to be sorted and submitted later
+	void queueSelfAndChild(const Frustum& frustum, Shader& ourShader, RenderQueue& queue, unsigned int& display, unsigned int& total)
+	{
+		if (boundingVolume.isOnFrustum(frustum, transform))
+		{
+			queue.Push(0, ourShader, *pModel, transform.getModelMatrix());
+			display++;
+		}
+		total++;
+
+		for (auto&& child : children)
+		{
+			child->queueSelfAndChild(frustum, ourShader, queue, display, total);
+		}
+	}
+
+private:
+	//Below this many nodes the threads cost more than they save
+	static const size_t parallelThreshold = 16384;
+
+	void collectScene(std::vector<uint32_t>& models, std::vector<BoundingBox>& bounds, std::vector<std::string>& modelPaths,
+		std::unordered_map<const Model*, uint32_t>& modelIndex, size_t& visited) const
+	{
+		auto found = modelIndex.find(pModel);
+		if (found == modelIndex.end())
+		{
+			found = modelIndex.emplace(pModel, static_cast<uint32_t>(modelPaths.size())).first;
+			modelPaths.push_back(pModel->path);
+		}
+		const uint32_t node = transform.getNode();
+		models[node] = found->second;
+		bounds[node] = BoundingBox{ boundingVolume.center - boundingVolume.extents, boundingVolume.center + boundingVolume.extents };
+		visited++;
+		for (auto&& child : children)
+			child->collectScene(models, bounds, modelPaths, modelIndex, visited);
+	}
+
+	void update(bool force)
+	{
+		if (parent != nullptr)
+			hierarchy->UpdateSubtree(transform.getNode(), force);
+		else if (hierarchy->Size() >= parallelThreshold)
+			hierarchy->Update(JobSystem::Instance(), force);
+		else
+			hierarchy->Update(force);
+	}
+};
+
+//Bounding volume hierarchy over the world boxes of every entity of a tree. Culling descends it instead of testing
+//each entity, so whole groups outside the frustum are skipped at once.
+//Call refit() after every updateSelfAndChild(), and rebuild() after entities were added or removed.
+class EntityBVH
+{
+public:
+	EntityBVH(Entity& root)
+	{
+		rebuild(root);
+	}
+
+	void rebuild(Entity& root)
+	{
+		entities.clear();
+		hierarchy = root.hierarchy.get();
+		slots.assign(hierarchy->Size(), -1);
+		gather(root);
+		build();
+	}
+
+	//Refit the leaves of the entities whose world matrix the last update changed, found in the hierarchy's list of
+	//changed nodes. Few moves are refitted path by path with rotations, when much of the scene moved one pass over
+	//the whole tree is cheaper.
+	void refit()
+	{
+		moved.clear();
+		for (uint32_t node : hierarchy->ChangedNodes())
+		{
+			if (node < slots.size() && slots[node] >= 0)
+				moved.push_back(static_cast<uint32_t>(slots[node]));
+		}
+		if (moved.size() > entities.size() / 32)
+		{
+			for (uint32_t i : moved)
+				bvh.SetBox(static_cast<int32_t>(i), worldBox(*entities[i]));
+			bvh.Refit();
+			return;
+		}
+		for (uint32_t i : moved)
+			bvh.Move(static_cast<int32_t>(i), worldBox(*entities[i]));
+	}
+
+	void drawVisible(const Frustum& frustum, Shader& ourShader, unsigned int& display, unsigned int& total)
+	{
+		bvh.Cull(frustum, [&](uint32_t i)
+		{
+			ourShader.setMat4("model", entities[i]->transform.getModelMatrix());
+			entities[i]->pModel->Draw(ourShader);
+			display++;
+		});
+		total += static_cast<unsigned int>(entities.size());
+	}
+
+	//Same as above, and entities hidden behind the occluders rasterised into occlusion this frame are skipped too
+	void drawVisible(const Frustum& frustum, const OcclusionCuller& occlusion, Shader& ourShader, unsigned int& display, unsigned int& total)
+	{
+		bvh.Cull(frustum, [&](uint32_t i)
+		{
+			const BoundingBox& box = bvh.Box(static_cast<int32_t>(i));
+			if (!occlusion.IsVisible(box.min, box.max))
+				return;
+			ourShader.setMat4("model", entities[i]->transform.getModelMatrix());
+			entities[i]->pModel->Draw(ourShader);
+			display++;
+		});
+		total += static_cast<unsigned int>(entities.size());
+	}
+
+	//Same as above but the visible entities go into queue, which draws the ones sharing a model instanced
+	void queueVisible(const Frustum& frustum, const OcclusionCuller& occlusion, Shader& ourShader, RenderQueue& queue, unsigned int& display, unsigned int& total)
+	{
+		bvh.Cull(frustum, [&](uint32_t i)
+		{
+			const BoundingBox& box = bvh.Box(static_cast<int32_t>(i));
+			if (!occlusion.IsVisible(box.min, box.max))
+				return;
+			queue.Push(0, ourShader, *entities[i]->pModel, entities[i]->transform.getModelMatrix());
+			display++;
+		});
+		total += static_cast<unsigned int>(entities.size());
+	}
+
+	const DynamicBVH& getTree() const
+	{
+		return bvh;
+	}
+
+private:
+	DynamicBVH bvh;
+	std::vector<Entity*> entities;
+	const TransformHierarchy* hierarchy = nullptr;
+	std::vector<int32_t> slots; //hierarchy node -> index into entities, -1 for nodes outside the tree
+	std::vector<uint32_t> moved;
+
+	//leaf i holds entity i
+	void build()
+	{
+		std::vector<BoundingBox> boxes(entities.size());
+		std::vector<uint32_t> indices(entities.size());
+		for (size_t i = 0; i < entities.size(); i++)
+		{
+			boxes[i] = worldBox(*entities[i]);
+			indices[i] = static_cast<uint32_t>(i);
+		}
+		bvh.Build(boxes, indices);
+	}
+
+	void gather(Entity& entity)
+	{
+		slots[entity.transform.getNode()] = static_cast<int32_t>(entities.size());
+		entities.push_back(&entity);
+		for (auto&& child : entity.children)
+			gather(*child);
+	}
+
+	static BoundingBox worldBox(Entity& entity)
+	{
+		const AABB box = entity.getGlobalAABB();
+		return BoundingBox{ box.center - box.extents, box.center + box.extents };
+	}
+};
+//World boxes of every entity of a tree kept as structure of arrays, so culling tests them in SIMD batches.
+//Same visibility as drawSelfAndChild(). Call refit() after every updateSelfAndChild(), and rebuild() after entities were added or removed.
+class EntityBatch
+{
+public:
+	EntityBatch(Entity& root)
+	{
+		rebuild(root);
+	}
+
+	void rebuild(Entity& root)
+	{
+		entities.clear();
+		boxes.Clear();
+		hierarchy = root.hierarchy.get();
+		slots.assign(hierarchy->Size(), -1);
+		gather(root);
+	}
+
+	//Recompute the boxes of the entities whose world matrix the last update changed
+	void refit()
+	{
+		for (uint32_t node : hierarchy->ChangedNodes())
+		{
+			if (node >= slots.size() || slots[node] < 0)
+				continue;
+			const size_t i = static_cast<size_t>(slots[node]);
+			const AABB box = entities[i]->getGlobalAABB();
+			boxes.centerX[i] = box.center.x; boxes.centerY[i] = box.center.y; boxes.centerZ[i] = box.center.z;
+			boxes.extentX[i] = box.extents.x; boxes.extentY[i] = box.extents.y; boxes.extentZ[i] = box.extents.z;
+		}
+	}
+
+	void drawVisible(const Frustum& frustum, Shader& ourShader, unsigned int& display, unsigned int& total)
+	{
+		visible.resize(BatchCulling::MaskWords(entities.size()));
+		BatchCulling::CullBoxes(frustum, boxes, visible.data());
+		for (size_t word = 0; word < visible.size(); word++)
+		{
+			//Most words are empty when little is visible
+			if (visible[word] == 0)
+				continue;
+			for (size_t bit = 0; bit < 64; bit++)
+			{
+				if (!((visible[word] >> bit) & 1u))
+					continue;
+				Entity& entity = *entities[word * 64 + bit];
+				ourShader.setMat4("model", entity.transform.getModelMatrix());
+				entity.pModel->Draw(ourShader);
+				display++;
+			}
+		}
+		total += static_cast<unsigned int>(entities.size());
+	}
+
+private:
+	VolumeBatch boxes;
+	std::vector<Entity*> entities;
+	const TransformHierarchy* hierarchy = nullptr;
+	std::vector<int32_t> slots; //hierarchy node -> index into entities, -1 for nodes outside the tree
+	std::vector<uint64_t> visible;
+
+	void gather(Entity& entity)
+	{
+		const AABB box = entity.getGlobalAABB();
+		slots[entity.transform.getNode()] = static_cast<int32_t>(entities.size());
+		entities.push_back(&entity);
+		boxes.AddBox(box.center, box.extents);
+		for (auto&& child : entity.children)
+			gather(*child);
+	}
+};
+
+//Loose hashed grid over the world boxes of every entity of a tree, for proximity and picking queries.
+//Call update() after every updateSelfAndChild(): only the entities in the hierarchy's list of changed nodes are moved,
+//so a frame costs nothing for entities that stayed put, and a move inside the same cell costs no more than storing
+//the new box. Call rebuild() after entities were added or removed.
+class EntityGrid
+{
+public:
+	EntityGrid(Entity& root, float cellSize = 4.f)
+	{
+		rebuild(root, cellSize);
+	}
+
+	void rebuild(Entity& root, float cellSize = 4.f)
+	{
+		entities.clear();
+		hierarchy = root.hierarchy.get();
+		slots.assign(hierarchy->Size(), -1);
+		gather(root);
+		grid.Clear(cellSize);
+		proxies.resize(entities.size());
+		for (size_t i = 0; i < entities.size(); i++)
+			proxies[i] = grid.Insert(worldBox(*entities[i]), static_cast<uint32_t>(i));
+	}
+
+	void update()
+	{
+		for (uint32_t node : hierarchy->ChangedNodes())
+		{
+			if (node < slots.size() && slots[node] >= 0)
+				grid.Move(proxies[slots[node]], worldBox(*entities[slots[node]]));
+		}
+	}
+
+	//entities whose world box overlaps box
+	void queryBox(const BoundingBox& box, std::vector<Entity*>& result) const
+	{
+		result.clear();
+		grid.Query(box, [&](uint32_t i) { result.push_back(entities[i]); });
+	}
+
+	//entities whose world box is within radius of center
+	void querySphere(const glm::vec3& center, float radius, std::vector<Entity*>& result) const
+	{
+		result.clear();
+		grid.QuerySphere(center, radius, [&](uint32_t i) { result.push_back(entities[i]); });
+	}
+
+	//the k entities whose world box is closest to point, closest first
+	void nearest(const glm::vec3& point, size_t k, std::vector<Entity*>& result) const
+	{
+		grid.Nearest(point, k, indices);
+		result.clear();
+		for (uint32_t i : indices)
+			result.push_back(entities[i]);
+	}
+
+	//first entity whose world box the ray hits within maxDistance, nullptr if none
+	Entity* raycast(const glm::vec3& origin, const glm::vec3& direction, float maxDistance, float& distance) const
+	{
+		uint32_t i;
+		if (!grid.Raycast(origin, direction, maxDistance, i, distance))
+			return nullptr;
+		return entities[i];
+	}
+
+	const SpatialHash& getGrid() const
+	{
+		return grid;
+	}
+
+private:
+	SpatialHash grid;
+	std::vector<Entity*> entities;
+	const TransformHierarchy* hierarchy = nullptr;
+	std::vector<int32_t> slots; //hierarchy node -> index into entities, -1 for nodes outside the tree
+	std::vector<int32_t> proxies;
+	mutable std::vector<uint32_t> indices;
+
+	void gather(Entity& entity)
+	{
+		slots[entity.transform.getNode()] = static_cast<int32_t>(entities.size());
+		entities.push_back(&entity);
+		for (auto&& child : entity.children)
+			gather(*child);
+	}
+
+	static BoundingBox worldBox(Entity& entity)
+	{
+		const AABB box = entity.getGlobalAABB();
+		return BoundingBox{ box.center - box.extents, box.center + box.extents };
+	}
 };
 #endif
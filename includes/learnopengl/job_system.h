@@ -0,0 +1,169 @@
+#ifndef JOB_SYSTEM_H
+#define JOB_SYSTEM_H
+
+#include <algorithm>
+#include <atomic>
+#include <condition_variable>
+#include <deque>
+#include <functional>
+#include <memory>
+#include <mutex>
+#include <thread>
+#include <vector>
+
+// a pool of worker threads with one task queue each. ParallelFor() deals the chunks of a range out over all queues;
+// a thread takes work from the back of its own queue and, once that is empty, steals from the front of the others,
+// so uneven chunks even out without a central queue everybody contends on. The calling thread works along until
+// the whole range is done. ParallelFor() must not be called from inside a job, or from two threads at once.
+class JobSystem
+{
+public:
+    static JobSystem& Instance()
+    {
+        static JobSystem jobs;
+        return jobs;
+    }
+
+    // threadCount workers besides the calling thread, by default one per remaining hardware thread
+    explicit JobSystem(unsigned int threadCount = ~0u)
+    {
+        if (threadCount == ~0u)
+            threadCount = std::max(1u, std::thread::hardware_concurrency()) - 1;
+        for (unsigned int i = 0; i <= threadCount; i++)
+            queues.emplace_back(new Queue());
+        for (unsigned int i = 0; i < threadCount; i++)
+            workers.emplace_back(&JobSystem::workerLoop, this, i);
+    }
+
+    JobSystem(const JobSystem&) = delete;
+    JobSystem& operator=(const JobSystem&) = delete;
+
+    ~JobSystem()
+    {
+        {
+            std::lock_guard<std::mutex> lock(sleepMutex);
+            stopping = true;
+        }
+        wake.notify_all();
+        for (std::thread &worker : workers)
+            worker.join();
+    }
+
+    unsigned int ThreadCount() const { return static_cast<unsigned int>(workers.size()) + 1; }
+
+    // calls body(begin, end) for consecutive chunks of at most grain elements covering [0, count) and returns once
+    // every chunk has run. Chunks run concurrently and in no particular order.
+    void ParallelFor(size_t count, size_t grain, const std::function<void(size_t, size_t)> &body)
+    {
+        if (count == 0)
+            return;
+        grain = std::max<size_t>(grain, 1);
+        const size_t chunks = (count + grain - 1) / grain;
+        if (workers.empty() || chunks == 1)
+        {
+            body(0, count);
+            return;
+        }
+
+        Batch batch{ &body, chunks };
+        for (size_t c = 0; c < chunks; c++)
+        {
+            Queue &queue = *queues[c % queues.size()];
+            std::lock_guard<std::mutex> lock(queue.mutex);
+            queue.tasks.push_back(Task{ &batch, c * grain, std::min(count, (c + 1) * grain) });
+        }
+        {
+            std::lock_guard<std::mutex> lock(sleepMutex);
+            available += chunks;
+        }
+        wake.notify_all();
+
+        // the caller owns the last queue
+        const size_t self = queues.size() - 1;
+        while (batch.remaining.load(std::memory_order_acquire) > 0)
+        {
+            Task task;
+            if (take(self, task))
+                run(task);
+            else
+                std::this_thread::yield(); // the last chunks are running elsewhere
+        }
+    }
+
+private:
+    struct Batch
+    {
+        const std::function<void(size_t, size_t)> *body;
+        std::atomic<size_t> remaining;
+    };
+
+    struct Task
+    {
+        Batch *batch = nullptr;
+        size_t begin = 0, end = 0;
+    };
+
+    struct Queue
+    {
+        std::mutex mutex;
+        std::deque<Task> tasks;
+    };
+
+    std::vector<std::unique_ptr<Queue>> queues; // one per worker plus one for the calling thread
+    std::vector<std::thread> workers;
+    size_t available = 0; // queued tasks, guarded by sleepMutex
+    bool stopping = false;
+    std::mutex sleepMutex;
+    std::condition_variable wake;
+
+    // own queue first (newest task, still warm in cache), then the oldest task of every other queue
+    bool take(size_t self, Task &task)
+    {
+        for (size_t k = 0; k < queues.size(); k++)
+        {
+            Queue &queue = *queues[(self + k) % queues.size()];
+            std::lock_guard<std::mutex> lock(queue.mutex);
+            if (queue.tasks.empty())
+                continue;
+            if (k == 0)
+            {
+                task = queue.tasks.back();
+                queue.tasks.pop_back();
+            }
+            else
+            {
+                task = queue.tasks.front();
+                queue.tasks.pop_front();
+            }
+            std::lock_guard<std::mutex> sleepLock(sleepMutex);
+            available--;
+            return true;
+        }
+        return false;
+    }
+
+    static void run(const Task &task)
+    {
+        (*task.batch->body)(task.begin, task.end);
+        // the caller may return and destroy the batch as soon as this reaches 0
+        task.batch->remaining.fetch_sub(1, std::memory_order_release);
+    }
+
+    void workerLoop(size_t self)
+    {
+        for (;;)
+        {
+            Task task;
+            if (take(self, task))
+            {
+                run(task);
+                continue;
+            }
+            std::unique_lock<std::mutex> lock(sleepMutex);
+            wake.wait(lock, [this] { return stopping || available > 0; });
+            if (stopping)
+                return;
+        }
+    }
+};
+#endif
@@ -0,0 +1,140 @@
+#ifndef MAPPED_FILE_H
+#define MAPPED_FILE_H
+
+#include <atomic>
+#include <cstddef>
+#include <cstdio>
+#include <string>
+
+#ifdef _WIN32
+#ifndef NOMINMAX
+#define NOMINMAX
+#endif
+#include <windows.h>
+#else
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+#endif
+
+// read-only memory mapping of a whole file. The mapping lives as long as the object does.
+class MappedFile
+{
+public:
+    MappedFile() = default;
+    MappedFile(const MappedFile&) = delete;
+    MappedFile& operator=(const MappedFile&) = delete;
+    ~MappedFile() { close(); }
+
+    bool open(const std::string &path)
+    {
+        close();
+#ifdef _WIN32
+        file = CreateFileA(path.c_str(), GENERIC_READ, FILE_SHARE_READ, NULL, OPEN_EXISTING, FILE_ATTRIBUTE_NORMAL, NULL);
+        if (file == INVALID_HANDLE_VALUE)
+            return false;
+        LARGE_INTEGER fileSize;
+        if (!GetFileSizeEx(file, &fileSize) || fileSize.QuadPart == 0)
+        {
+            close();
+            return false;
+        }
+        mapping = CreateFileMappingA(file, NULL, PAGE_READONLY, 0, 0, NULL);
+        if (mapping == NULL)
+        {
+            close();
+            return false;
+        }
+        bytes = static_cast<const unsigned char*>(MapViewOfFile(mapping, FILE_MAP_READ, 0, 0, 0));
+        if (bytes == nullptr)
+        {
+            close();
+            return false;
+        }
+        length = static_cast<size_t>(fileSize.QuadPart);
+#else
+        fd = ::open(path.c_str(), O_RDONLY);
+        if (fd < 0)
+            return false;
+        struct stat st;
+        if (fstat(fd, &st) != 0 || st.st_size == 0)
+        {
+            close();
+            return false;
+        }
+        void* ptr = mmap(nullptr, static_cast<size_t>(st.st_size), PROT_READ, MAP_PRIVATE, fd, 0);
+        if (ptr == MAP_FAILED)
+        {
+            close();
+            return false;
+        }
+        bytes = static_cast<const unsigned char*>(ptr);
+        length = static_cast<size_t>(st.st_size);
+#endif
+        return true;
+    }
+
+    void close()
+    {
+#ifdef _WIN32
+        if (bytes)
+            UnmapViewOfFile(bytes);
+        if (mapping != NULL)
+            CloseHandle(mapping);
+        if (file != INVALID_HANDLE_VALUE)
+            CloseHandle(file);
+        mapping = NULL;
+        file = INVALID_HANDLE_VALUE;
+#else
+        if (bytes)
+            munmap(const_cast<unsigned char*>(bytes), length);
+        if (fd >= 0)
+            ::close(fd);
+        fd = -1;
+#endif
+        bytes = nullptr;
+        length = 0;
+    }
+
+    const unsigned char* data() const { return bytes; }
+    size_t size() const { return length; }
+
+private:
+    const unsigned char* bytes = nullptr;
+    size_t length = 0;
+#ifdef _WIN32
+    HANDLE file = INVALID_HANDLE_VALUE;
+    HANDLE mapping = NULL;
+#else
+    int fd = -1;
+#endif
+};
+
+// a name next to path for writing a replacement of it. Unique per process and call, so concurrent writers of the
+// same file never share one.
+inline std::string TemporaryPath(const std::string &path)
+{
+    static std::atomic<unsigned int> counter{ 0 };
+#ifdef _WIN32
+    const unsigned long process = GetCurrentProcessId();
+#else
+    const unsigned long process = static_cast<unsigned long>(getpid());
+#endif
+    return path + "." + std::to_string(process) + "." + std::to_string(counter++) + ".tmp";
+}
+
+// moves the finished temporary file over path. A reader opening path sees the old file or the new one, never
+// neither; the temporary file is deleted if the move fails.
+inline bool RenameReplacing(const std::string &tempPath, const std::string &path)
+{
+#ifdef _WIN32
+    const bool moved = MoveFileExA(tempPath.c_str(), path.c_str(), MOVEFILE_REPLACE_EXISTING) != 0;
+#else
+    const bool moved = std::rename(tempPath.c_str(), path.c_str()) == 0;
+#endif
+    if (!moved)
+        std::remove(tempPath.c_str());
+    return moved;
+}
+#endif
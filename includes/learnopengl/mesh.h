@@ -6,29 +6,24 @@
 #include <glm/glm.hpp>
 #include <glm/gtc/matrix_transform.hpp>
 
+#include <learnopengl/mesh_arena.h>
+#include <learnopengl/meshlet.h>
 #include <learnopengl/shader.h>
+#include <learnopengl/vertex_format.h>
 
+#include <cstddef>
+#include <cstdint>
+#include <iterator>
 #include <string>
+#include <utility>
 #include <vector>
 using namespace std;
 
-#define MAX_BONE_INFLUENCE 4
-
-struct Vertex {
-    // position
-    glm::vec3 Position;
-    // normal
-    glm::vec3 Normal;
-    // texCoords
-    glm::vec2 TexCoords;
-    // tangent
-    glm::vec3 Tangent;
-    // bitangent
-    glm::vec3 Bitangent;
-	//bone indexes which will influence this vertex
-	int m_BoneIDs[MAX_BONE_INFLUENCE];
-	//weights from each bone
-	float m_Weights[MAX_BONE_INFLUENCE];
+// one level of detail: a range of the mesh's element buffer. level 0 is the full resolution mesh.
+struct MeshLod {
+    unsigned int firstIndex;
+    unsigned int indexCount;
+    float        error; // largest geometric error against level 0, in object space units
 };
 
 struct Texture {
@@ -37,36 +32,246 @@ struct Texture {
     string path;
 };
 
-class Mesh {
+template<typename VertexT>
+class BasicMesh {
 public:
+    typedef VertexT VertexType;
+
     // mesh Data
-    vector<Vertex>       vertices;
+    vector<VertexT>      vertices;
     vector<unsigned int> indices;
     vector<Texture>      textures;
     unsigned int VAO;
+    // element type of the GPU copy of indices: 16-bit whenever the mesh has at most 65536 vertices
+    GLenum indexType = GL_UNSIGNED_INT;
+    // dequantisation of QuantizedVertex positions: position = positionOffset + stored * positionScale
+    glm::vec3 positionOffset = glm::vec3(0.0f);
+    glm::vec3 positionScale = glm::vec3(1.0f);
+    // levels of detail, see SetLods(). Empty until LODs are generated, level 0 is then always the full mesh.
+    vector<MeshLod> lods;
+    // clusters of the full resolution mesh for per-cluster culling, see BuildMeshlets()
+    MeshletSet meshlets;
+    // where the mesh lives in MeshArena<VertexT> after MoveToArena(); all zero while it owns its buffers
+    bool inArena = false;
+    ArenaRange arenaRange;
 
     // constructor
-    Mesh(vector<Vertex> vertices, vector<unsigned int> indices, vector<Texture> textures)
+    BasicMesh(vector<VertexT> vertices, vector<unsigned int> indices, vector<Texture> textures)
     {
-        this->vertices = vertices;
-        this->indices = indices;
-        this->textures = textures;
+        this->vertices = std::move(vertices);
+        this->indices = std::move(indices);
+        this->textures = std::move(textures);
 
         // now that we have all the required data, set the vertex buffers and its attribute pointers.
-        setupMesh();
+        setupMesh(this->vertices.data(), this->indices.data());
+    }
+
+    // constructor for data that is already in GPU-ready layout (e.g. a memory mapped mesh cache).
+    // the buffers are uploaded straight from the given memory, but this is not zero-copy: vertices and indices still
+    // get a CPU copy of it, since LODs, meshlets, the arena, occluders and bounds all read them.
+    BasicMesh(const VertexT *vertexData, size_t vertexCount, const unsigned int *indexData, size_t indexCount, vector<Texture> textures)
+        : vertices(vertexData, vertexData + vertexCount), indices(indexData, indexData + indexCount), textures(textures)
+    {
+        setupMesh(vertexData, indexData);
+    }
+
+    // replaces the element buffer with the full index list followed by the given coarser levels,
+    // which index the same vertices. errors holds one entry per level.
+    void SetLods(const vector<vector<unsigned int>> &levels, const vector<float> &errors)
+    {
+        lods.assign(1, MeshLod{ 0, static_cast<unsigned int>(indices.size()), 0.0f });
+        vector<unsigned int> elements(indices);
+        for(size_t i = 0; i < levels.size(); i++)
+        {
+            lods.push_back(MeshLod{ static_cast<unsigned int>(elements.size()), static_cast<unsigned int>(levels[i].size()), errors[i] });
+            elements.insert(elements.end(), levels[i].begin(), levels[i].end());
+        }
+
+        vector<GLushort> packed;
+        if(inArena)
+        {
+            // the range no longer fits, move to a new one
+            MeshArena<VertexT> &arena = MeshArena<VertexT>::Instance();
+            ArenaRange range = arena.Allocate(vertices.size(), elements.size(), indexType);
+            arena.Upload(range, vertices.data(), packIndices(elements.data(), elements.size(), packed));
+            arena.Free(arenaRange);
+            arenaRange = range;
+            return;
+        }
+        glBindVertexArray(VAO);
+        glBindBuffer(GL_ELEMENT_ARRAY_BUFFER, EBO);
+        glBufferData(GL_ELEMENT_ARRAY_BUFFER, elements.size() * IndexSize(indexType), packIndices(elements.data(), elements.size(), packed), GL_STATIC_DRAW);
+        glBindVertexArray(0);
+    }
+
+    // moves the vertex and element data (including LODs) into the arena shared by every mesh of this vertex format and
+    // deletes the mesh's own buffers. VAO then names the arena's VAO, which must not be given extra attributes.
+    void MoveToArena()
+    {
+        if(inArena)
+            return;
+        MeshArena<VertexT> &arena = MeshArena<VertexT>::Instance();
+        GLint elementBytes = 0;
+        glBindBuffer(GL_COPY_READ_BUFFER, EBO);
+        glGetBufferParameteriv(GL_COPY_READ_BUFFER, GL_BUFFER_SIZE, &elementBytes);
+        glBindBuffer(GL_COPY_READ_BUFFER, 0);
+        arenaRange = arena.Allocate(vertices.size(), elementBytes / IndexSize(indexType), indexType);
+        arena.Copy(arenaRange, VBO, EBO);
+
+        glDeleteVertexArrays(1, &VAO);
+        glDeleteBuffers(1, &VBO);
+        glDeleteBuffers(1, &EBO);
+        VAO = arena.VertexArray();
+        VBO = EBO = 0;
+        inArena = true;
+    }
+
+    // CPU side only, the arena may outlive the GL context
+    void ReleaseArena()
+    {
+        if(!inArena)
+            return;
+        MeshArena<VertexT>::Instance().Free(arenaRange);
+        inArena = false;
+        arenaRange = ArenaRange();
+        VAO = 0;
+    }
+
+    // the indirect command that draws this mesh at the given level of detail
+    DrawElementsIndirectCommand IndirectCommand(GLuint baseInstance, unsigned int lod = 0) const
+    {
+        unsigned int first = 0, count = static_cast<unsigned int>(indices.size());
+        if(lod > 0 && lod < lods.size())
+        {
+            first = lods[lod].firstIndex;
+            count = lods[lod].indexCount;
+        }
+        return DrawElementsIndirectCommand{ count, 1, arenaRange.firstIndex + first, static_cast<GLint>(arenaRange.baseVertex), baseInstance };
+    }
+
+    // splits the full resolution triangles into meshlets for Draw(shader, drawList). CPU only, the buffers don't change.
+    void BuildMeshlets(unsigned int maxVertices = MeshletSet::MaxVertices, unsigned int maxTriangles = MeshletSet::MaxTriangles)
+    {
+        meshlets.Build(vertices, indices, maxVertices, maxTriangles);
+    }
+
+    // drops the compiled materials; call after changing textures or when a shader program was deleted and its name
+    // may be reused. Tables are otherwise built on the first draw with each program and kept.
+    void InvalidateMaterials()
+    {
+        materials.clear();
+    }
+
+    // render the mesh, optionally at a coarser level of detail
+    void Draw(Shader &shader, unsigned int lod = 0) 
+    {
+        BindMaterial(shader);
+
+        // draw mesh
+        glBindVertexArray(VAO);
+        DrawElements(lod);
+        glBindVertexArray(0);
+
+        // always good practice to set everything back to defaults once configured.
+        glActiveTexture(GL_TEXTURE0);
+    }
+
+    // only the draw call, for callers that already bound VAO and the material themselves (see RenderQueue)
+    void DrawElements(unsigned int lod = 0) const
+    {
+        unsigned int first = 0, count = static_cast<unsigned int>(indices.size());
+        if(lod > 0 && lod < lods.size())
+        {
+            first = lods[lod].firstIndex;
+            count = lods[lod].indexCount;
+        }
+        glDrawElementsBaseVertex(GL_TRIANGLES, count, indexType, (void*)((arenaRange.firstIndex + first) * IndexSize(indexType)), arenaRange.baseVertex);
+    }
+
+    // same as above, instanceCount times in one call; per instance data comes from attributes with a divisor
+    void DrawElementsInstanced(GLsizei instanceCount, unsigned int lod = 0) const
+    {
+        unsigned int first = 0, count = static_cast<unsigned int>(indices.size());
+        if(lod > 0 && lod < lods.size())
+        {
+            first = lods[lod].firstIndex;
+            count = lods[lod].indexCount;
+        }
+        glDrawElementsInstancedBaseVertex(GL_TRIANGLES, count, indexType, (void*)((arenaRange.firstIndex + first) * IndexSize(indexType)),
+                                          instanceCount, arenaRange.baseVertex);
+    }
+
+    // render only the index ranges that survived MeshletSet::Cull (given this mesh's arenaRange), in a single multi-draw
+    void Draw(Shader &shader, const MeshletDrawList &drawList)
+    {
+        if(drawList.counts.empty())
+            return;
+        BindMaterial(shader);
+        glBindVertexArray(VAO);
+        glMultiDrawElementsBaseVertex(GL_TRIANGLES, drawList.counts.data(), indexType, drawList.offsets.data(),
+                                      static_cast<GLsizei>(drawList.counts.size()), drawList.baseVertices.data());
+        glBindVertexArray(0);
+        glActiveTexture(GL_TEXTURE0);
+    }
+
+    // binds the mesh's textures to the samplers of the given program (and the dequantisation uniforms)
+    void BindMaterial(Shader &shader)
+    {
+        const MaterialTable &table = material(shader);
+        for(const MaterialBinding &binding : table.bindings)
+        {
+            glActiveTexture(binding.unit); // active proper texture unit before binding
+            // now set the sampler to the correct texture unit
+            glUniform1i(binding.location, binding.unit - GL_TEXTURE0);
+            // and finally bind the texture
+            glBindTexture(GL_TEXTURE_2D, binding.texture);
+        }
+
+        if constexpr (VertexFormat<VertexT>::quantizedPosition)
+        {
+            glUniform3fv(table.positionOffsetLocation, 1, &positionOffset[0]);
+            glUniform3fv(table.positionScaleLocation, 1, &positionScale[0]);
+        }
     }
 
-    // render the mesh
-    void Draw(Shader &shader) 
+private:
+    // render data 
+    unsigned int VBO, EBO;
+
+    // one texture of a compiled material: where its sampler lives in the program and what to bind
+    struct MaterialBinding {
+        GLint  location;
+        GLenum unit;
+        GLuint texture;
+    };
+
+    // the material compiled for one shader program
+    struct MaterialTable {
+        GLuint program;
+        vector<MaterialBinding> bindings;
+        GLint positionOffsetLocation;
+        GLint positionScaleLocation;
+    };
+
+    // almost always a single entry, a mesh is rarely drawn with more than a couple of programs
+    vector<MaterialTable> materials;
+
+    // resolves the sampler names (texture_diffuseN, ...) of this mesh's textures in the given program once,
+    // so drawing doesn't build strings or look up uniform locations.
+    const MaterialTable& material(const Shader &shader)
     {
-        // bind appropriate textures
+        for(const MaterialTable &table : materials)
+            if(table.program == shader.ID)
+                return table;
+
+        MaterialTable table;
+        table.program = shader.ID;
         unsigned int diffuseNr  = 1;
         unsigned int specularNr = 1;
         unsigned int normalNr   = 1;
         unsigned int heightNr   = 1;
         for(unsigned int i = 0; i < textures.size(); i++)
         {
-            glActiveTexture(GL_TEXTURE0 + i); // active proper texture unit before binding
             // retrieve texture number (the N in diffuse_textureN)
             string number;
             string name = textures[i].type;
@@ -79,27 +284,30 @@ public:
              else if(name == "texture_height")
                 number = std::to_string(heightNr++); // transfer unsigned int to string
 
-            // now set the sampler to the correct texture unit
-            glUniform1i(glGetUniformLocation(shader.ID, (name + number).c_str()), i);
-            // and finally bind the texture
-            glBindTexture(GL_TEXTURE_2D, textures[i].id);
+            // samplers the program doesn't use need neither the uniform nor the texture
+            GLint location = glGetUniformLocation(shader.ID, (name + number).c_str());
+            if(location != -1)
+                table.bindings.push_back(MaterialBinding{ location, GL_TEXTURE0 + i, textures[i].id });
         }
-        
-        // draw mesh
-        glBindVertexArray(VAO);
-        glDrawElements(GL_TRIANGLES, static_cast<unsigned int>(indices.size()), GL_UNSIGNED_INT, 0);
-        glBindVertexArray(0);
-
-        // always good practice to set everything back to defaults once configured.
-        glActiveTexture(GL_TEXTURE0);
+        table.positionOffsetLocation = glGetUniformLocation(shader.ID, "positionOffset");
+        table.positionScaleLocation = glGetUniformLocation(shader.ID, "positionScale");
+        materials.push_back(std::move(table));
+        return materials.back();
     }
 
-private:
-    // render data 
-    unsigned int VBO, EBO;
+    // the element data as the GPU stores it: narrowed into packed for 16-bit meshes, the input itself otherwise
+    const void* packIndices(const unsigned int *data, size_t count, vector<GLushort> &packed) const
+    {
+        if(indexType != GL_UNSIGNED_SHORT)
+            return data;
+        packed.resize(count);
+        for(size_t i = 0; i < count; i++)
+            packed[i] = static_cast<GLushort>(data[i]);
+        return packed.data();
+    }
 
     // initializes all the buffer objects/arrays
-    void setupMesh()
+    void setupMesh(const VertexT *vertexData, const unsigned int *indexData)
     {
         // create buffers/arrays
         glGenVertexArrays(1, &VAO);
@@ -112,35 +320,21 @@ private:
         // A great thing about structs is that their memory layout is sequential for all its items.
         // The effect is that we can simply pass a pointer to the struct and it translates perfectly to a glm::vec3/2 array which
         // again translates to 3/2 floats which translates to a byte array.
-        glBufferData(GL_ARRAY_BUFFER, vertices.size() * sizeof(Vertex), &vertices[0], GL_STATIC_DRAW);  
+        glBufferData(GL_ARRAY_BUFFER, vertices.size() * sizeof(VertexT), vertexData, GL_STATIC_DRAW);  
 
         glBindBuffer(GL_ELEMENT_ARRAY_BUFFER, EBO);
-        glBufferData(GL_ELEMENT_ARRAY_BUFFER, indices.size() * sizeof(unsigned int), &indices[0], GL_STATIC_DRAW);
-
-        // set the vertex attribute pointers
-        // vertex Positions
-        glEnableVertexAttribArray(0);	
-        glVertexAttribPointer(0, 3, GL_FLOAT, GL_FALSE, sizeof(Vertex), (void*)0);
-        // vertex normals
-        glEnableVertexAttribArray(1);	
-        glVertexAttribPointer(1, 3, GL_FLOAT, GL_FALSE, sizeof(Vertex), (void*)offsetof(Vertex, Normal));
-        // vertex texture coords
-        glEnableVertexAttribArray(2);	
-        glVertexAttribPointer(2, 2, GL_FLOAT, GL_FALSE, sizeof(Vertex), (void*)offsetof(Vertex, TexCoords));
-        // vertex tangent
-        glEnableVertexAttribArray(3);
-        glVertexAttribPointer(3, 3, GL_FLOAT, GL_FALSE, sizeof(Vertex), (void*)offsetof(Vertex, Tangent));
-        // vertex bitangent
-        glEnableVertexAttribArray(4);
-        glVertexAttribPointer(4, 3, GL_FLOAT, GL_FALSE, sizeof(Vertex), (void*)offsetof(Vertex, Bitangent));
-		// ids
-		glEnableVertexAttribArray(5);
-		glVertexAttribIPointer(5, 4, GL_INT, sizeof(Vertex), (void*)offsetof(Vertex, m_BoneIDs));
-
-		// weights
-		glEnableVertexAttribArray(6);
-		glVertexAttribPointer(6, 4, GL_FLOAT, GL_FALSE, sizeof(Vertex), (void*)offsetof(Vertex, m_Weights));
+        indexType = vertices.size() <= 65536 ? GL_UNSIGNED_SHORT : GL_UNSIGNED_INT;
+        vector<GLushort> packed;
+        glBufferData(GL_ELEMENT_ARRAY_BUFFER, indices.size() * IndexSize(indexType), packIndices(indexData, indices.size(), packed), GL_STATIC_DRAW);
+
+        // set the vertex attribute pointers, one call per attribute of the vertex format
+        SetupVertexAttributes<VertexT>();
         glBindVertexArray(0);
     }
 };
+
+// static geometry (position/normal/uv/tangent)
+typedef BasicMesh<StaticVertex>  Mesh;
+// skinned geometry, adds the bitangent and bone influences
+typedef BasicMesh<SkinnedVertex> SkinnedMesh;
 #endif
@@ -0,0 +1,267 @@
+#ifndef MESH_ARENA_H
+#define MESH_ARENA_H
+
+#include <glad/glad.h>
+
+#include <learnopengl/vertex_format.h>
+
+#include <algorithm>
+#include <cstddef>
+#include <numeric>
+#include <utility>
+#include <vector>
+
+// command layout consumed by glMultiDrawElementsIndirect
+struct DrawElementsIndirectCommand
+{
+    GLuint count;
+    GLuint instanceCount;
+    GLuint firstIndex;
+    GLint  baseVertex;
+    GLuint baseInstance;
+};
+
+// the part of a MeshArena one mesh occupies; indices are relative to baseVertex.
+// firstIndex counts in indexType elements, as glDrawElements* and indirect commands expect it.
+struct ArenaRange
+{
+    unsigned int baseVertex = 0;
+    unsigned int vertexCount = 0;
+    unsigned int firstIndex = 0;
+    unsigned int indexCount = 0;
+    GLenum indexType = GL_UNSIGNED_INT;
+};
+
+// bytes per index of GL_UNSIGNED_SHORT / GL_UNSIGNED_INT element data
+inline size_t IndexSize(GLenum indexType)
+{
+    return indexType == GL_UNSIGNED_SHORT ? sizeof(GLushort) : sizeof(GLuint);
+}
+
+// first-fit allocator over [0, capacity) with coalescing of freed blocks
+class RangeAllocator
+{
+public:
+    static const size_t Invalid = ~size_t(0);
+
+    size_t Allocate(size_t count)
+    {
+        if (count == 0)
+            return 0;
+        for (size_t i = 0; i < free.size(); i++)
+        {
+            if (free[i].second < count)
+                continue;
+            size_t offset = free[i].first;
+            free[i].first += count;
+            free[i].second -= count;
+            if (free[i].second == 0)
+                free.erase(free.begin() + i);
+            return offset;
+        }
+        return Invalid;
+    }
+
+    void Free(size_t offset, size_t count)
+    {
+        if (count == 0)
+            return;
+        auto next = std::lower_bound(free.begin(), free.end(), std::make_pair(offset, size_t(0)));
+        next = free.insert(next, { offset, count });
+        // merge with the following and the preceding block
+        if (next + 1 != free.end() && next->first + next->second == (next + 1)->first)
+        {
+            next->second += (next + 1)->second;
+            free.erase(next + 1);
+        }
+        if (next != free.begin() && (next - 1)->first + (next - 1)->second == next->first)
+        {
+            (next - 1)->second += next->second;
+            free.erase(next);
+        }
+    }
+
+    // adds [capacity, newCapacity) to the free space
+    void Grow(size_t capacity, size_t newCapacity)
+    {
+        Free(capacity, newCapacity - capacity);
+    }
+
+private:
+    std::vector<std::pair<size_t, size_t>> free; // (offset, count), sorted by offset
+};
+
+// one vertex buffer, one index buffer and one VAO shared by every mesh of a vertex layout. Meshes are suballocated
+// from it, so any number of them can be drawn without switching VAOs, in a single glMultiDrawElementsIndirect per
+// index type. The index buffer is managed in 16-bit units and 32-bit ranges are kept 4 byte aligned, so meshes
+// with 16 and 32-bit indices share it.
+// The VAO also carries a per draw id at DrawIDLocation: an integer instanced attribute read from a buffer holding
+// 0, 1, 2, ..., so a draw's baseInstance arrives in the vertex shader as
+//     layout (location = 15) in uint aDrawID;
+// which works on GL 4.3 without ARB_shader_draw_parameters (gl_DrawID restarts at 0 for each multi-draw).
+template<typename VertexT>
+class MeshArena
+{
+public:
+    static const GLuint DrawIDLocation = 15;
+
+    static MeshArena& Instance()
+    {
+        static MeshArena arena;
+        return arena;
+    }
+
+    MeshArena(const MeshArena&) = delete;
+    MeshArena& operator=(const MeshArena&) = delete;
+
+    // context thread only: reserves room for a mesh, growing the buffers when needed. Data is uploaded by the caller.
+    ArenaRange Allocate(size_t vertexCount, size_t indexCount, GLenum indexType = GL_UNSIGNED_INT)
+    {
+        if (VAO == 0)
+            create();
+        ArenaRange range;
+        range.vertexCount = static_cast<unsigned int>(vertexCount);
+        range.indexCount = static_cast<unsigned int>(indexCount);
+        range.indexType = indexType;
+
+        size_t vertexOffset = vertexSpace.Allocate(vertexCount);
+        while (vertexOffset == RangeAllocator::Invalid)
+        {
+            growVertices(std::max(vertexCapacity * 2, vertexCapacity + vertexCount));
+            vertexOffset = vertexSpace.Allocate(vertexCount);
+        }
+        const size_t indexUnits = IndexUnits(range);
+        size_t indexOffset = indexSpace.Allocate(indexUnits);
+        while (indexOffset == RangeAllocator::Invalid)
+        {
+            growIndices(std::max(indexCapacity * 2, indexCapacity + indexUnits));
+            indexOffset = indexSpace.Allocate(indexUnits);
+        }
+        range.baseVertex = static_cast<unsigned int>(vertexOffset);
+        range.firstIndex = static_cast<unsigned int>(indexOffset * sizeof(GLushort) / IndexSize(indexType));
+        return range;
+    }
+
+    // returns a range to the free space. CPU bookkeeping only, safe after the context is gone.
+    void Free(const ArenaRange &range)
+    {
+        vertexSpace.Free(range.baseVertex, range.vertexCount);
+        indexSpace.Free(range.firstIndex * IndexSize(range.indexType) / sizeof(GLushort), IndexUnits(range));
+    }
+
+    // context thread only: indices are of the range's indexType
+    void Upload(const ArenaRange &range, const VertexT *vertices, const void *indices)
+    {
+        glBindBuffer(GL_ARRAY_BUFFER, VBO);
+        glBufferSubData(GL_ARRAY_BUFFER, range.baseVertex * sizeof(VertexT), range.vertexCount * sizeof(VertexT), vertices);
+        glBindBuffer(GL_ARRAY_BUFFER, 0);
+        // the element buffer is VAO state, go through the VAO to not disturb whatever is bound
+        glBindVertexArray(VAO);
+        const size_t indexSize = IndexSize(range.indexType);
+        glBufferSubData(GL_ELEMENT_ARRAY_BUFFER, range.firstIndex * indexSize, range.indexCount * indexSize, indices);
+        glBindVertexArray(0);
+    }
+
+    // context thread only: copies a mesh's existing buffers into its range without a round trip through the CPU
+    void Copy(const ArenaRange &range, GLuint vertexBuffer, GLuint indexBuffer)
+    {
+        glBindBuffer(GL_COPY_READ_BUFFER, vertexBuffer);
+        glBindBuffer(GL_COPY_WRITE_BUFFER, VBO);
+        glCopyBufferSubData(GL_COPY_READ_BUFFER, GL_COPY_WRITE_BUFFER, 0, range.baseVertex * sizeof(VertexT), range.vertexCount * sizeof(VertexT));
+        glBindBuffer(GL_COPY_READ_BUFFER, indexBuffer);
+        glBindBuffer(GL_COPY_WRITE_BUFFER, EBO);
+        const size_t indexSize = IndexSize(range.indexType);
+        glCopyBufferSubData(GL_COPY_READ_BUFFER, GL_COPY_WRITE_BUFFER, 0, range.firstIndex * indexSize, range.indexCount * indexSize);
+        glBindBuffer(GL_COPY_READ_BUFFER, 0);
+        glBindBuffer(GL_COPY_WRITE_BUFFER, 0);
+    }
+
+    // context thread only: makes sure draw ids 0..count-1 can be fetched through baseInstance
+    void ReserveDrawIDs(size_t count)
+    {
+        if (count <= drawIDCapacity)
+            return;
+        drawIDCapacity = std::max(count, drawIDCapacity * 2);
+        std::vector<GLuint> ids(drawIDCapacity);
+        std::iota(ids.begin(), ids.end(), 0u);
+        glBindBuffer(GL_ARRAY_BUFFER, drawIDBuffer);
+        glBufferData(GL_ARRAY_BUFFER, ids.size() * sizeof(GLuint), ids.data(), GL_STATIC_DRAW);
+        glBindBuffer(GL_ARRAY_BUFFER, 0);
+    }
+
+    GLuint VertexArray() const { return VAO; }
+    size_t VertexCapacity() const { return vertexCapacity; }
+    size_t IndexCapacity() const { return indexCapacity; } // in 16-bit units
+
+private:
+    GLuint VAO = 0, VBO = 0, EBO = 0, drawIDBuffer = 0;
+    size_t vertexCapacity = 0, indexCapacity = 0, drawIDCapacity = 0;
+    RangeAllocator vertexSpace, indexSpace;
+
+    MeshArena() {}
+
+    // 16-bit units a range occupies, rounded up to keep every range 4 byte aligned
+    static size_t IndexUnits(const ArenaRange &range)
+    {
+        return (range.indexCount * IndexSize(range.indexType) / sizeof(GLushort) + 1) & ~size_t(1);
+    }
+
+    void create()
+    {
+        glGenVertexArrays(1, &VAO);
+        glGenBuffers(1, &drawIDBuffer);
+        ReserveDrawIDs(1024);
+        glBindVertexArray(VAO);
+        glBindBuffer(GL_ARRAY_BUFFER, drawIDBuffer);
+        glEnableVertexAttribArray(DrawIDLocation);
+        glVertexAttribIPointer(DrawIDLocation, 1, GL_UNSIGNED_INT, sizeof(GLuint), (void*)0);
+        glVertexAttribDivisor(DrawIDLocation, 1);
+        glBindVertexArray(0);
+        glBindBuffer(GL_ARRAY_BUFFER, 0);
+        growVertices(size_t(1) << 16);
+        growIndices(size_t(1) << 19);
+    }
+
+    // replaces a buffer with a bigger one holding the same data
+    static GLuint grow(GLuint buffer, size_t oldBytes, size_t newBytes)
+    {
+        GLuint bigger;
+        glGenBuffers(1, &bigger);
+        glBindBuffer(GL_COPY_WRITE_BUFFER, bigger);
+        glBufferData(GL_COPY_WRITE_BUFFER, newBytes, nullptr, GL_STATIC_DRAW);
+        if (buffer != 0 && oldBytes > 0)
+        {
+            glBindBuffer(GL_COPY_READ_BUFFER, buffer);
+            glCopyBufferSubData(GL_COPY_READ_BUFFER, GL_COPY_WRITE_BUFFER, 0, 0, oldBytes);
+            glBindBuffer(GL_COPY_READ_BUFFER, 0);
+        }
+        glBindBuffer(GL_COPY_WRITE_BUFFER, 0);
+        if (buffer != 0)
+            glDeleteBuffers(1, &buffer);
+        return bigger;
+    }
+
+    void growVertices(size_t capacity)
+    {
+        VBO = grow(VBO, vertexCapacity * sizeof(VertexT), capacity * sizeof(VertexT));
+        vertexSpace.Grow(vertexCapacity, capacity);
+        vertexCapacity = capacity;
+        // attribute pointers capture the buffer, point them at the new one
+        glBindVertexArray(VAO);
+        glBindBuffer(GL_ARRAY_BUFFER, VBO);
+        SetupVertexAttributes<VertexT>();
+        glBindVertexArray(0);
+        glBindBuffer(GL_ARRAY_BUFFER, 0);
+    }
+
+    void growIndices(size_t capacity)
+    {
+        EBO = grow(EBO, indexCapacity * sizeof(GLushort), capacity * sizeof(GLushort));
+        indexSpace.Grow(indexCapacity, capacity);
+        indexCapacity = capacity;
+        glBindVertexArray(VAO);
+        glBindBuffer(GL_ELEMENT_ARRAY_BUFFER, EBO);
+        glBindVertexArray(0);
+    }
+};
+#endif
@@ -0,0 +1,304 @@
+#ifndef MESH_CACHE_H
+#define MESH_CACHE_H
+
+#include <learnopengl/mapped_file.h>
+#include <learnopengl/mesh.h>
+
+#include <cstdint>
+#include <cstdio>
+#include <cstring>
+#include <fstream>
+#include <string>
+#include <vector>
+
+// on-disk layout of a .meshcache file (native endianness, every blob 16 byte aligned):
+// MeshCacheHeader | MeshCacheEntry[meshCount] | MeshCacheTexture[textureCount] | MeshCacheString[dependencyCount] |
+// string table | vertex blob | index blob
+// the vertex and index blobs hold the post-processed data exactly as it is handed to glBufferData.
+struct MeshCacheHeader
+{
+    char     magic[8];
+    uint32_t version;
+    uint32_t vertexSize;     // sizeof(StaticVertex) at write time, guards against layout changes
+    uint64_t sourceHash;     // hash of the source asset combined with the hashes of its dependencies
+    uint32_t importFlags;    // assimp post-processing flags the data was produced with
+    uint32_t meshCount;
+    uint32_t textureCount;
+    uint32_t dependencyCount;
+    uint64_t dependenciesOffset;
+    uint32_t stringsSize;
+    uint32_t reserved;
+    uint64_t stringsOffset;
+    uint64_t verticesOffset;
+    uint64_t indicesOffset;
+    uint64_t fileSize;
+};
+
+struct MeshCacheEntry
+{
+    uint64_t firstVertex;
+    uint64_t firstIndex;
+    uint32_t vertexCount;
+    uint32_t indexCount;
+    uint32_t firstTexture;
+    uint32_t textureCount;
+};
+
+struct MeshCacheTexture
+{
+    uint32_t typeOffset; // offsets into the string table
+    uint32_t typeLength;
+    uint32_t pathOffset;
+    uint32_t pathLength;
+};
+
+struct MeshCacheString
+{
+    uint32_t offset; // into the string table
+    uint32_t length;
+};
+
+// versioned binary cache of a model's post-processed meshes, stored next to the source asset.
+// A cache file is only valid for the exact source bytes and import flags it was written with, and for the exact
+// bytes of every other file the importer read (an .obj's .mtl for instance); their paths are stored in the cache
+// and rehashed on open. Delete the .meshcache file, or load with useCache = false, to force a fresh import.
+class MeshCache
+{
+public:
+    static const uint32_t Version = 4; // 3: meshes are stored after MeshOptimizer, 4: dependency hashes
+
+    static std::string CachePath(const std::string &path)
+    {
+        return path + ".meshcache";
+    }
+
+    // 64-bit FNV-1a over the file contents, consumed a word at a time. Returns 0 if the file can't be read.
+    static uint64_t HashFile(const std::string &path)
+    {
+        MappedFile file;
+        if (!file.open(path))
+            return 0;
+
+        const uint64_t prime = 1099511628211ULL;
+        uint64_t hash = 14695981039346656037ULL;
+        const unsigned char* data = file.data();
+        size_t size = file.size();
+        size_t i = 0;
+        for (; i + 8 <= size; i += 8)
+        {
+            uint64_t word;
+            std::memcpy(&word, data + i, 8);
+            hash = (hash ^ word) * prime;
+        }
+        for (; i < size; i++)
+            hash = (hash ^ data[i]) * prime;
+        hash = (hash ^ size) * prime;
+        return hash;
+    }
+
+    // sourceHash with the current contents of every dependency folded in, in order. A missing file hashes to 0, so
+    // one that disappears or shows up later changes the result as well.
+    static uint64_t CombinedHash(uint64_t sourceHash, const vector<string> &dependencies)
+    {
+        uint64_t hash = sourceHash;
+        for (const string &dependency : dependencies)
+            hash = (hash ^ HashFile(dependency)) * 1099511628211ULL;
+        return hash;
+    }
+
+    // maps the cache file of the given asset and validates it against the source hash, the current contents of the
+    // dependencies it was written with and the import flags.
+    bool open(const std::string &path, uint64_t sourceHash, uint32_t importFlags)
+    {
+        if (!file.open(CachePath(path)))
+            return false;
+        if (file.size() < sizeof(MeshCacheHeader))
+            return invalidate();
+
+        std::memcpy(&header, file.data(), sizeof(MeshCacheHeader));
+        if (std::memcmp(header.magic, Magic(), sizeof(header.magic)) != 0 ||
+            header.version != Version ||
+            header.vertexSize != sizeof(StaticVertex) ||
+            header.importFlags != importFlags ||
+            header.fileSize != file.size() ||
+            !aligned(header.dependenciesOffset) || !aligned(header.stringsOffset) ||
+            !aligned(header.verticesOffset) || !aligned(header.indicesOffset) ||
+            !fits(TexturesOffset(header.meshCount), header.textureCount, sizeof(MeshCacheTexture), header.dependenciesOffset) ||
+            !fits(header.dependenciesOffset, header.dependencyCount, sizeof(MeshCacheString), header.stringsOffset) ||
+            !fits(header.stringsOffset, header.stringsSize, 1, header.verticesOffset) ||
+            header.verticesOffset > header.indicesOffset ||
+            header.indicesOffset > header.fileSize)
+            return invalidate();
+
+        entries = reinterpret_cast<const MeshCacheEntry*>(file.data() + Align(sizeof(MeshCacheHeader)));
+        textures = reinterpret_cast<const MeshCacheTexture*>(file.data() + TexturesOffset(header.meshCount));
+        const MeshCacheString* dependencies = reinterpret_cast<const MeshCacheString*>(file.data() + header.dependenciesOffset);
+        strings = reinterpret_cast<const char*>(file.data() + header.stringsOffset);
+        vertexData = reinterpret_cast<const StaticVertex*>(file.data() + header.verticesOffset);
+        indexData = reinterpret_cast<const unsigned int*>(file.data() + header.indicesOffset);
+
+        // reject truncated or inconsistent files before anything dereferences them. Every range is checked as
+        // first <= limit && count <= limit - first, a crafted first + count can't wrap around.
+        const uint64_t vertexLimit = (header.indicesOffset - header.verticesOffset) / sizeof(StaticVertex);
+        const uint64_t indexLimit = (header.fileSize - header.indicesOffset) / sizeof(unsigned int);
+        for (uint32_t i = 0; i < header.meshCount; i++)
+        {
+            const MeshCacheEntry &entry = entries[i];
+            if (!fits(entry.firstVertex, entry.vertexCount, 1, vertexLimit) ||
+                !fits(entry.firstIndex, entry.indexCount, 1, indexLimit) ||
+                !fits(entry.firstTexture, entry.textureCount, 1, header.textureCount))
+                return invalidate();
+        }
+        for (uint32_t i = 0; i < header.textureCount; i++)
+        {
+            if (!fits(textures[i].typeOffset, textures[i].typeLength, 1, header.stringsSize) ||
+                !fits(textures[i].pathOffset, textures[i].pathLength, 1, header.stringsSize))
+                return invalidate();
+        }
+
+        // the stored hash covers the asset and every file the importer read for it, all of which may have changed
+        vector<string> dependencyPaths;
+        for (uint32_t i = 0; i < header.dependencyCount; i++)
+        {
+            if (!fits(dependencies[i].offset, dependencies[i].length, 1, header.stringsSize))
+                return invalidate();
+            dependencyPaths.push_back(string(strings + dependencies[i].offset, dependencies[i].length));
+        }
+        if (CombinedHash(sourceHash, dependencyPaths) != header.sourceHash)
+            return invalidate();
+        return true;
+    }
+
+    unsigned int meshCount() const { return header.meshCount; }
+    const MeshCacheEntry& mesh(unsigned int i) const { return entries[i]; }
+    const StaticVertex* vertices(unsigned int i) const { return vertexData + entries[i].firstVertex; }
+    const unsigned int* indices(unsigned int i) const { return indexData + entries[i].firstIndex; }
+    string textureType(unsigned int t) const { return string(strings + textures[t].typeOffset, textures[t].typeLength); }
+    string texturePath(unsigned int t) const { return string(strings + textures[t].pathOffset, textures[t].pathLength); }
+
+    // serializes the given meshes (anything with StaticVertex vertices, indices and textures) along with the paths of
+    // the other files the import read. Written to a temporary file first so a concurrent reader never sees a half
+    // written cache.
+    template<typename MeshT>
+    static bool Write(const std::string &path, uint64_t sourceHash, uint32_t importFlags, const vector<MeshT> &meshes,
+                      const vector<string> &dependencies = vector<string>())
+    {
+        vector<MeshCacheEntry> entries;
+        vector<MeshCacheTexture> textures;
+        string strings;
+        uint64_t vertexCount = 0, indexCount = 0;
+        for (const MeshT &mesh : meshes)
+        {
+            MeshCacheEntry entry;
+            entry.firstVertex = vertexCount;
+            entry.firstIndex = indexCount;
+            entry.vertexCount = static_cast<uint32_t>(mesh.vertices.size());
+            entry.indexCount = static_cast<uint32_t>(mesh.indices.size());
+            entry.firstTexture = static_cast<uint32_t>(textures.size());
+            entry.textureCount = static_cast<uint32_t>(mesh.textures.size());
+            for (const Texture &texture : mesh.textures)
+            {
+                MeshCacheTexture record;
+                record.typeOffset = static_cast<uint32_t>(strings.size());
+                record.typeLength = static_cast<uint32_t>(texture.type.size());
+                strings += texture.type;
+                record.pathOffset = static_cast<uint32_t>(strings.size());
+                record.pathLength = static_cast<uint32_t>(texture.path.size());
+                strings += texture.path;
+                textures.push_back(record);
+            }
+            vertexCount += entry.vertexCount;
+            indexCount += entry.indexCount;
+            entries.push_back(entry);
+        }
+        vector<MeshCacheString> dependencyRecords;
+        for (const string &dependency : dependencies)
+        {
+            dependencyRecords.push_back(MeshCacheString{ static_cast<uint32_t>(strings.size()), static_cast<uint32_t>(dependency.size()) });
+            strings += dependency;
+        }
+
+        MeshCacheHeader header;
+        std::memset(&header, 0, sizeof(header));
+        std::memcpy(header.magic, Magic(), sizeof(header.magic));
+        header.version = Version;
+        header.vertexSize = sizeof(StaticVertex);
+        header.sourceHash = CombinedHash(sourceHash, dependencies);
+        header.importFlags = importFlags;
+        header.meshCount = static_cast<uint32_t>(entries.size());
+        header.textureCount = static_cast<uint32_t>(textures.size());
+        header.dependencyCount = static_cast<uint32_t>(dependencyRecords.size());
+        header.dependenciesOffset = Align(TexturesOffset(header.meshCount) + textures.size() * sizeof(MeshCacheTexture));
+        header.stringsSize = static_cast<uint32_t>(strings.size());
+        header.stringsOffset = Align(header.dependenciesOffset + dependencyRecords.size() * sizeof(MeshCacheString));
+        header.verticesOffset = Align(header.stringsOffset + strings.size());
+        header.indicesOffset = Align(header.verticesOffset + vertexCount * sizeof(StaticVertex));
+        header.fileSize = header.indicesOffset + indexCount * sizeof(unsigned int);
+
+        const string cachePath = CachePath(path);
+        const string tempPath = TemporaryPath(cachePath);
+        {
+            std::ofstream out(tempPath, std::ios::binary | std::ios::trunc);
+            if (!out)
+                return false;
+            WriteAt(out, 0, &header, sizeof(header));
+            WriteAt(out, Align(sizeof(MeshCacheHeader)), entries.data(), entries.size() * sizeof(MeshCacheEntry));
+            WriteAt(out, TexturesOffset(header.meshCount), textures.data(), textures.size() * sizeof(MeshCacheTexture));
+            WriteAt(out, header.dependenciesOffset, dependencyRecords.data(), dependencyRecords.size() * sizeof(MeshCacheString));
+            WriteAt(out, header.stringsOffset, strings.data(), strings.size());
+            out.seekp(static_cast<std::streamoff>(header.verticesOffset));
+            for (const MeshT &mesh : meshes)
+                out.write(reinterpret_cast<const char*>(mesh.vertices.data()), mesh.vertices.size() * sizeof(StaticVertex));
+            out.seekp(static_cast<std::streamoff>(header.indicesOffset));
+            for (const MeshT &mesh : meshes)
+                out.write(reinterpret_cast<const char*>(mesh.indices.data()), mesh.indices.size() * sizeof(unsigned int));
+            if (!out)
+            {
+                out.close();
+                std::remove(tempPath.c_str());
+                return false;
+            }
+        }
+        return RenameReplacing(tempPath, cachePath);
+    }
+
+private:
+    MappedFile file;
+    MeshCacheHeader header = {};
+    const MeshCacheEntry* entries = nullptr;
+    const MeshCacheTexture* textures = nullptr;
+    const char* strings = nullptr;
+    const StaticVertex* vertexData = nullptr;
+    const unsigned int* indexData = nullptr;
+
+    static const char* Magic() { return "LOGLMSH"; }
+
+    static uint64_t Align(uint64_t offset) { return (offset + 15) & ~uint64_t(15); }
+
+    static bool aligned(uint64_t offset) { return offset % 16 == 0; }
+
+    // count elements of the given size starting at offset end at or before limit
+    static bool fits(uint64_t offset, uint64_t count, uint64_t size, uint64_t limit)
+    {
+        return offset <= limit && count <= (limit - offset) / size;
+    }
+
+    static uint64_t TexturesOffset(uint32_t meshCount)
+    {
+        return Align(Align(sizeof(MeshCacheHeader)) + uint64_t(meshCount) * sizeof(MeshCacheEntry));
+    }
+
+    static void WriteAt(std::ofstream &out, uint64_t offset, const void* data, size_t size)
+    {
+        out.seekp(static_cast<std::streamoff>(offset));
+        if (size)
+            out.write(static_cast<const char*>(data), size);
+    }
+
+    bool invalidate()
+    {
+        file.close();
+        return false;
+    }
+};
+#endif
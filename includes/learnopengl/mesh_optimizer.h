@@ -0,0 +1,337 @@
+#ifndef MESH_OPTIMIZER_H
+#define MESH_OPTIMIZER_H
+
+#include <glm/glm.hpp>
+
+#include <algorithm>
+#include <cstdint>
+#include <cstring>
+#include <ostream>
+#include <unordered_map>
+#include <vector>
+
+// post-transform cache efficiency of an index buffer, measured with a FIFO cache
+struct VertexCacheStatistics
+{
+    size_t vertexCount = 0;   // referenced vertices
+    size_t triangleCount = 0;
+    size_t misses = 0;        // vertex shader invocations
+    float  acmr = 0.0f;       // average cache miss ratio: misses per triangle, 0.5 at best for large grids, 3 at worst
+    float  atvr = 0.0f;       // average transformed vertex ratio: misses per vertex, 1 is ideal
+};
+
+// before/after statistics of one MeshOptimizer::Optimize call
+struct MeshOptimizationStatistics
+{
+    size_t verticesBefore = 0;
+    size_t verticesAfter = 0;
+    VertexCacheStatistics before;
+    VertexCacheStatistics after;
+};
+
+inline std::ostream& operator<<(std::ostream &out, const MeshOptimizationStatistics &stats)
+{
+    return out << stats.verticesBefore << " -> " << stats.verticesAfter << " vertices, " << stats.after.triangleCount
+               << " triangles, ACMR " << stats.before.acmr << " -> " << stats.after.acmr
+               << ", ATVR " << stats.before.atvr << " -> " << stats.after.atvr;
+}
+
+// index/vertex buffer optimisation for triangle lists:
+//   1. Weld        - merges bitwise identical vertices
+//   2. Tipsify     - orders triangles for the post-transform vertex cache (Sander et al. 2007)
+//   3. Overdraw    - reorders the clusters Tipsify produces so outward facing geometry is drawn first
+//   4. Fetch order - renumbers vertices in order of first use so vertex fetch streams through memory
+// none of the steps change what is rendered, only how fast it is.
+class MeshOptimizer
+{
+public:
+    static const unsigned int CacheSize = 16;
+
+    // runs the whole pipeline in place. VertexT needs a glm::vec3 Position for the overdraw pass.
+    template<typename VertexT>
+    static MeshOptimizationStatistics Optimize(std::vector<VertexT> &vertices, std::vector<unsigned int> &indices)
+    {
+        MeshOptimizationStatistics stats;
+        stats.verticesBefore = vertices.size();
+        stats.before = AnalyzeVertexCache(indices, vertices.size());
+        if (indices.size() % 3 == 0 && !indices.empty())
+        {
+            Weld(vertices, indices);
+            std::vector<unsigned int> clusters;
+            indices = Tipsify(indices, vertices.size(), CacheSize, &clusters);
+            indices = OptimizeOverdraw(indices, vertices, clusters);
+            OptimizeVertexFetch(vertices, indices);
+        }
+        stats.verticesAfter = vertices.size();
+        stats.after = AnalyzeVertexCache(indices, vertices.size());
+        return stats;
+    }
+
+    // merges vertices whose bytes are identical and rewrites the indices accordingly
+    template<typename VertexT>
+    static void Weld(std::vector<VertexT> &vertices, std::vector<unsigned int> &indices)
+    {
+        struct Hash
+        {
+            const VertexT *vertices;
+            size_t operator()(unsigned int i) const
+            {
+                // FNV-1a over the raw vertex
+                const unsigned char *bytes = reinterpret_cast<const unsigned char*>(&vertices[i]);
+                uint64_t hash = 14695981039346656037ull;
+                for (size_t b = 0; b < sizeof(VertexT); b++)
+                    hash = (hash ^ bytes[b]) * 1099511628211ull;
+                return static_cast<size_t>(hash);
+            }
+        };
+        struct Equal
+        {
+            const VertexT *vertices;
+            bool operator()(unsigned int a, unsigned int b) const
+            {
+                return std::memcmp(&vertices[a], &vertices[b], sizeof(VertexT)) == 0;
+            }
+        };
+
+        std::vector<unsigned int> remap(vertices.size());
+        std::vector<VertexT> welded;
+        welded.reserve(vertices.size());
+        {
+            std::unordered_map<unsigned int, unsigned int, Hash, Equal> unique(vertices.size(), Hash{ vertices.data() }, Equal{ vertices.data() });
+            for (unsigned int i = 0; i < vertices.size(); i++)
+            {
+                auto inserted = unique.emplace(i, static_cast<unsigned int>(welded.size()));
+                if (inserted.second)
+                    welded.push_back(vertices[i]);
+                remap[i] = inserted.first->second;
+            }
+        }
+        for (unsigned int &index : indices)
+            index = remap[index];
+        vertices.swap(welded);
+    }
+
+    // Tipsify: fans around the most recently used vertex that is still in the cache and jumps to a dead-end
+    // vertex otherwise. Linear in the number of triangles. The optional clusters receive the first index of
+    // every run that starts after a cache flush, the boundaries the overdraw pass may reorder at.
+    static std::vector<unsigned int> Tipsify(const std::vector<unsigned int> &indices, size_t vertexCount, unsigned int cacheSize,
+                                             std::vector<unsigned int> *clusters = nullptr)
+    {
+        const size_t triangleCount = indices.size() / 3;
+
+        // vertex -> triangle adjacency
+        std::vector<unsigned int> offsets(vertexCount + 1, 0), live(vertexCount, 0);
+        for (unsigned int index : indices)
+            live[index]++;
+        for (size_t v = 0; v < vertexCount; v++)
+            offsets[v + 1] = offsets[v] + live[v];
+        std::vector<unsigned int> adjacency(indices.size()), fill(offsets.begin(), offsets.end() - 1);
+        for (size_t t = 0; t < triangleCount; t++)
+            for (int k = 0; k < 3; k++)
+                adjacency[fill[indices[t * 3 + k]]++] = static_cast<unsigned int>(t);
+
+        std::vector<unsigned int> timestamps(vertexCount, 0), deadEnds, candidates;
+        std::vector<bool> emitted(triangleCount, false);
+        std::vector<unsigned int> result;
+        result.reserve(indices.size());
+        if (clusters)
+            clusters->assign(1, 0);
+
+        unsigned int time = cacheSize + 1;
+        size_t cursor = 0;
+        long fanning = vertexCount ? 0 : -1;
+        while (fanning >= 0)
+        {
+            candidates.clear();
+            for (unsigned int a = offsets[fanning]; a < offsets[fanning + 1]; a++)
+            {
+                unsigned int t = adjacency[a];
+                if (emitted[t])
+                    continue;
+                for (int k = 0; k < 3; k++)
+                {
+                    unsigned int v = indices[t * 3 + k];
+                    result.push_back(v);
+                    deadEnds.push_back(v);
+                    candidates.push_back(v);
+                    live[v]--;
+                    if (time - timestamps[v] > cacheSize)
+                        timestamps[v] = time++;
+                }
+                emitted[t] = true;
+            }
+
+            // the candidate that stays in the cache for the whole fan and has been there the longest wins
+            long next = -1;
+            int best = -1;
+            for (unsigned int v : candidates)
+            {
+                if (live[v] == 0)
+                    continue;
+                int priority = 0;
+                if (time - timestamps[v] + 2 * live[v] <= cacheSize)
+                    priority = time - timestamps[v];
+                if (priority > best)
+                {
+                    best = priority;
+                    next = v;
+                }
+            }
+            if (next == -1)
+            {
+                // dead end: back track through recently emitted vertices, then scan for any vertex with work left
+                while (!deadEnds.empty() && next == -1)
+                {
+                    unsigned int v = deadEnds.back();
+                    deadEnds.pop_back();
+                    if (live[v] > 0)
+                        next = v;
+                }
+                while (next == -1 && cursor < vertexCount)
+                {
+                    if (live[cursor] > 0)
+                        next = static_cast<long>(cursor);
+                    cursor++;
+                }
+                if (next != -1 && clusters && result.size() > clusters->back())
+                    clusters->push_back(static_cast<unsigned int>(result.size()));
+            }
+            fanning = next;
+        }
+        return result;
+    }
+
+    // reorders the clusters of a cache optimised index buffer so that triangles facing away from the mesh centre
+    // are drawn first, which lets early-z reject more of the rest. Clusters that cache poorly are first split into
+    // smaller ones while the ACMR stays within threshold of the input, trading a little cache reuse for finer ordering.
+    template<typename VertexT>
+    static std::vector<unsigned int> OptimizeOverdraw(const std::vector<unsigned int> &indices, const std::vector<VertexT> &vertices,
+                                                      const std::vector<unsigned int> &hardClusters, float threshold = 1.05f)
+    {
+        const size_t triangleCount = indices.size() / 3;
+        if (triangleCount == 0)
+            return indices;
+
+        // soft boundaries: split a cluster as soon as its own ACMR is good enough
+        const float targetAcmr = AnalyzeVertexCache(indices, vertices.size()).acmr * threshold;
+        std::vector<unsigned int> clusters;
+        std::vector<unsigned int> cache(vertices.size(), 0);
+        unsigned int time = CacheSize + 1;
+        for (size_t c = 0; c < hardClusters.size(); c++)
+        {
+            size_t begin = hardClusters[c], end = c + 1 < hardClusters.size() ? hardClusters[c + 1] : indices.size();
+            clusters.push_back(static_cast<unsigned int>(begin));
+            time += CacheSize + 1; // a new cluster starts with a cold cache
+            size_t clusterMisses = 0, clusterStart = begin;
+            for (size_t i = begin; i < end; i += 3)
+            {
+                for (int k = 0; k < 3; k++)
+                {
+                    unsigned int v = indices[i + k];
+                    if (time - cache[v] > CacheSize)
+                    {
+                        cache[v] = time++;
+                        clusterMisses++;
+                    }
+                }
+                size_t clusterTriangles = (i + 3 - clusterStart) / 3;
+                if (i + 3 < end && clusterTriangles >= 8 && float(clusterMisses) / clusterTriangles <= targetAcmr)
+                {
+                    clusters.push_back(static_cast<unsigned int>(i + 3));
+                    clusterStart = i + 3;
+                    clusterMisses = 0;
+                    time += CacheSize + 1;
+                }
+            }
+        }
+
+        // sort key: how far the cluster faces out from the mesh centroid
+        glm::vec3 meshCentroid(0.0f);
+        for (unsigned int index : indices)
+            meshCentroid += vertices[index].Position;
+        meshCentroid /= float(indices.size());
+
+        std::vector<std::pair<float, unsigned int>> order(clusters.size());
+        for (size_t c = 0; c < clusters.size(); c++)
+        {
+            size_t begin = clusters[c], end = c + 1 < clusters.size() ? clusters[c + 1] : indices.size();
+            glm::vec3 centroid(0.0f), normal(0.0f);
+            float area = 0.0f;
+            for (size_t i = begin; i < end; i += 3)
+            {
+                const glm::vec3 &p0 = vertices[indices[i]].Position;
+                const glm::vec3 &p1 = vertices[indices[i + 1]].Position;
+                const glm::vec3 &p2 = vertices[indices[i + 2]].Position;
+                glm::vec3 n = glm::cross(p1 - p0, p2 - p0); // length is twice the area
+                float a = glm::length(n);
+                centroid += (p0 + p1 + p2) * (a / 3.0f);
+                normal += n;
+                area += a;
+            }
+            if (area > 0.0f)
+                centroid /= area;
+            float length = glm::length(normal);
+            if (length > 0.0f)
+                normal /= length;
+            order[c] = { glm::dot(centroid - meshCentroid, normal), static_cast<unsigned int>(c) };
+        }
+        std::stable_sort(order.begin(), order.end(), [](const std::pair<float, unsigned int> &a, const std::pair<float, unsigned int> &b) { return a.first > b.first; });
+
+        std::vector<unsigned int> result;
+        result.reserve(indices.size());
+        for (const auto &entry : order)
+        {
+            size_t c = entry.second;
+            size_t begin = clusters[c], end = c + 1 < clusters.size() ? clusters[c + 1] : indices.size();
+            result.insert(result.end(), indices.begin() + begin, indices.begin() + end);
+        }
+        return result;
+    }
+
+    // renumbers the vertices in the order the index buffer first references them and drops unreferenced ones
+    template<typename VertexT>
+    static void OptimizeVertexFetch(std::vector<VertexT> &vertices, std::vector<unsigned int> &indices)
+    {
+        const unsigned int unused = ~0u;
+        std::vector<unsigned int> remap(vertices.size(), unused);
+        std::vector<VertexT> ordered;
+        ordered.reserve(vertices.size());
+        for (unsigned int &index : indices)
+        {
+            if (remap[index] == unused)
+            {
+                remap[index] = static_cast<unsigned int>(ordered.size());
+                ordered.push_back(vertices[index]);
+            }
+            index = remap[index];
+        }
+        vertices.swap(ordered);
+    }
+
+    // simulates a FIFO post-transform cache over the index buffer
+    static VertexCacheStatistics AnalyzeVertexCache(const std::vector<unsigned int> &indices, size_t vertexCount, unsigned int cacheSize = CacheSize)
+    {
+        VertexCacheStatistics stats;
+        stats.triangleCount = indices.size() / 3;
+        std::vector<unsigned int> timestamps(vertexCount, 0);
+        std::vector<bool> referenced(vertexCount, false);
+        unsigned int time = cacheSize + 1;
+        for (unsigned int index : indices)
+        {
+            if (!referenced[index])
+            {
+                referenced[index] = true;
+                stats.vertexCount++;
+            }
+            if (time - timestamps[index] > cacheSize)
+            {
+                timestamps[index] = time++;
+                stats.misses++;
+            }
+        }
+        stats.acmr = stats.triangleCount ? float(stats.misses) / stats.triangleCount : 0.0f;
+        stats.atvr = stats.vertexCount ? float(stats.misses) / stats.vertexCount : 0.0f;
+        return stats;
+    }
+};
+#endif
@@ -0,0 +1,243 @@
+#ifndef MESH_SIMPLIFY_H
+#define MESH_SIMPLIFY_H
+
+#include <glm/glm.hpp>
+
+#include <algorithm>
+#include <cmath>
+#include <functional>
+#include <unordered_map>
+#include <vector>
+
+// quadric error metric simplification (Garland & Heckbert 1997) by half-edge collapse: a vertex is merged into one of
+// its neighbours, so the vertex buffer is shared by every level and only a new index buffer is produced.
+// UV seams and open borders are kept intact by only ever removing vertices that sit in the interior of the surface
+// with a position no other vertex shares; a small penalty on normal change keeps hard edges from being collapsed early.
+class MeshSimplifier
+{
+public:
+    // simplifies until at most targetIndexCount indices remain or no collapse stays under maxError (object space units).
+    // returns the new index buffer, error receives the largest geometric error introduced.
+    template<typename VertexT>
+    static std::vector<unsigned int> Simplify(const std::vector<VertexT> &vertices, const std::vector<unsigned int> &indices,
+                                              size_t targetIndexCount, float maxError, float *error = nullptr)
+    {
+        std::vector<unsigned int> result(indices);
+        float resultError = 0.0f;
+        if (error)
+            *error = 0.0f;
+        const size_t vertexCount = vertices.size();
+        if (indices.size() % 3 != 0 || vertexCount == 0)
+            return result;
+
+        std::vector<bool> collapsible = classifyVertices(vertices, indices);
+
+        // accumulate the plane of every triangle into its corners
+        std::vector<Quadric> quadrics(vertexCount);
+        for (size_t i = 0; i < indices.size(); i += 3)
+        {
+            const glm::vec3 &p0 = vertices[indices[i]].Position;
+            const glm::vec3 &p1 = vertices[indices[i + 1]].Position;
+            const glm::vec3 &p2 = vertices[indices[i + 2]].Position;
+            glm::dvec3 normal = glm::cross(glm::dvec3(p1 - p0), glm::dvec3(p2 - p0));
+            double length = glm::length(normal);
+            if (length == 0.0)
+                continue;
+            normal /= length;
+            Quadric plane(normal, -glm::dot(normal, glm::dvec3(p0)));
+            for (int k = 0; k < 3; k++)
+                quadrics[indices[i + k]] += plane;
+        }
+
+        std::vector<unsigned int> remap(vertexCount);
+        std::vector<bool> touched(vertexCount);
+        std::vector<Collapse> collapses;
+        std::vector<unsigned int> adjacencyOffsets, adjacency;
+        const double maxCost = double(maxError) * maxError;
+
+        while (result.size() > targetIndexCount)
+        {
+            buildAdjacency(result, vertexCount, adjacencyOffsets, adjacency);
+
+            // every directed edge whose source may disappear is a candidate
+            collapses.clear();
+            for (size_t i = 0; i < result.size(); i += 3)
+            {
+                for (int k = 0; k < 3; k++)
+                {
+                    unsigned int a = result[i + k], b = result[i + (k + 1) % 3];
+                    if (collapsible[a])
+                        collapses.push_back({ a, b, cost(quadrics[a], vertices[a], vertices[b]) });
+                    if (collapsible[b])
+                        collapses.push_back({ b, a, cost(quadrics[b], vertices[b], vertices[a]) });
+                }
+            }
+            if (collapses.empty())
+                break;
+            std::sort(collapses.begin(), collapses.end(), [](const Collapse &x, const Collapse &y) { return x.cost < y.cost; });
+
+            // apply the cheapest collapses that don't interact; a collapse removes about two triangles
+            for (unsigned int v = 0; v < vertexCount; v++)
+                remap[v] = v;
+            std::fill(touched.begin(), touched.end(), false);
+            size_t triangleBudget = (result.size() - targetIndexCount) / 3;
+            size_t removed = 0;
+            for (const Collapse &collapse : collapses)
+            {
+                if (removed >= triangleBudget || collapse.cost > maxCost)
+                    break;
+                if (touched[collapse.from] || touched[collapse.to])
+                    continue;
+                if (flips(vertices, result, adjacencyOffsets, adjacency, remap, collapse.from, collapse.to))
+                    continue;
+
+                remap[collapse.from] = collapse.to;
+                quadrics[collapse.to] += quadrics[collapse.from];
+                // lock the whole neighbourhood, its triangles are about to change
+                for (unsigned int a = adjacencyOffsets[collapse.from]; a < adjacencyOffsets[collapse.from + 1]; a++)
+                    for (int k = 0; k < 3; k++)
+                        touched[result[adjacency[a] * 3 + k]] = true;
+                resultError = std::max(resultError, float(std::sqrt(std::max(collapse.cost, 0.0))));
+                removed += 2;
+            }
+            if (removed == 0)
+                break;
+
+            // rewrite the triangles and drop the ones that collapsed
+            size_t write = 0;
+            for (size_t i = 0; i < result.size(); i += 3)
+            {
+                unsigned int a = remap[result[i]], b = remap[result[i + 1]], c = remap[result[i + 2]];
+                if (a == b || b == c || a == c)
+                    continue;
+                result[write++] = a;
+                result[write++] = b;
+                result[write++] = c;
+            }
+            result.resize(write);
+        }
+
+        if (error)
+            *error = resultError;
+        return result;
+    }
+
+private:
+    struct Quadric
+    {
+        // symmetric 4x4 matrix of the plane equation products
+        double a2 = 0, ab = 0, ac = 0, ad = 0, b2 = 0, bc = 0, bd = 0, c2 = 0, cd = 0, d2 = 0;
+
+        Quadric() {}
+        Quadric(const glm::dvec3 &n, double d)
+            : a2(n.x * n.x), ab(n.x * n.y), ac(n.x * n.z), ad(n.x * d), b2(n.y * n.y), bc(n.y * n.z), bd(n.y * d),
+              c2(n.z * n.z), cd(n.z * d), d2(d * d) {}
+
+        Quadric& operator+=(const Quadric &q)
+        {
+            a2 += q.a2; ab += q.ab; ac += q.ac; ad += q.ad; b2 += q.b2;
+            bc += q.bc; bd += q.bd; c2 += q.c2; cd += q.cd; d2 += q.d2;
+            return *this;
+        }
+
+        // sum of squared distances from p to the accumulated planes
+        double evaluate(const glm::dvec3 &p) const
+        {
+            return a2 * p.x * p.x + 2 * ab * p.x * p.y + 2 * ac * p.x * p.z + 2 * ad * p.x
+                 + b2 * p.y * p.y + 2 * bc * p.y * p.z + 2 * bd * p.y
+                 + c2 * p.z * p.z + 2 * cd * p.z + d2;
+        }
+    };
+
+    struct Collapse
+    {
+        unsigned int from, to;
+        double cost;
+    };
+
+    template<typename VertexT>
+    static double cost(const Quadric &quadric, const VertexT &from, const VertexT &to)
+    {
+        double distance = std::max(quadric.evaluate(glm::dvec3(to.Position)), 0.0);
+        // bending the shading normal costs as much as moving the vertex by a fraction of the edge length
+        double edge2 = glm::dot(glm::dvec3(to.Position - from.Position), glm::dvec3(to.Position - from.Position));
+        double bend = 1.0 - glm::dot(glm::dvec3(from.Normal), glm::dvec3(to.Normal));
+        return distance + 0.25 * edge2 * std::max(bend, 0.0);
+    }
+
+    // a vertex may only be removed if no other vertex shares its position (no UV/normal seam) and every edge
+    // around it is shared by exactly two triangles (not on an open border or non-manifold edge)
+    template<typename VertexT>
+    static std::vector<bool> classifyVertices(const std::vector<VertexT> &vertices, const std::vector<unsigned int> &indices)
+    {
+        struct PositionHash
+        {
+            size_t operator()(const glm::vec3 &p) const
+            {
+                return std::hash<float>()(p.x) ^ (std::hash<float>()(p.y) * 31) ^ (std::hash<float>()(p.z) * 131);
+            }
+        };
+        std::unordered_map<glm::vec3, unsigned int, PositionHash> positions;
+        std::vector<bool> collapsible(vertices.size(), true);
+        for (unsigned int v = 0; v < vertices.size(); v++)
+        {
+            auto inserted = positions.emplace(vertices[v].Position, v);
+            if (!inserted.second)
+                collapsible[v] = collapsible[inserted.first->second] = false;
+        }
+
+        // undirected edge -> triangle count
+        std::unordered_map<unsigned long long, unsigned int> edges;
+        for (size_t i = 0; i < indices.size(); i += 3)
+            for (int k = 0; k < 3; k++)
+            {
+                unsigned long long a = indices[i + k], b = indices[i + (k + 1) % 3];
+                edges[a < b ? (a << 32) | b : (b << 32) | a]++;
+            }
+        for (const auto &edge : edges)
+            if (edge.second != 2)
+                collapsible[edge.first >> 32] = collapsible[edge.first & 0xffffffffu] = false;
+        return collapsible;
+    }
+
+    static void buildAdjacency(const std::vector<unsigned int> &indices, size_t vertexCount,
+                               std::vector<unsigned int> &offsets, std::vector<unsigned int> &adjacency)
+    {
+        offsets.assign(vertexCount + 1, 0);
+        for (unsigned int index : indices)
+            offsets[index + 1]++;
+        for (size_t v = 0; v < vertexCount; v++)
+            offsets[v + 1] += offsets[v];
+        adjacency.resize(indices.size());
+        std::vector<unsigned int> fill(offsets.begin(), offsets.end() - 1);
+        for (size_t i = 0; i < indices.size(); i++)
+            adjacency[fill[indices[i]]++] = static_cast<unsigned int>(i / 3);
+    }
+
+    // true if moving 'from' onto 'to' would turn any surviving triangle around 'from' upside down
+    template<typename VertexT>
+    static bool flips(const std::vector<VertexT> &vertices, const std::vector<unsigned int> &indices,
+                      const std::vector<unsigned int> &offsets, const std::vector<unsigned int> &adjacency,
+                      const std::vector<unsigned int> &remap, unsigned int from, unsigned int to)
+    {
+        for (unsigned int a = offsets[from]; a < offsets[from + 1]; a++)
+        {
+            const unsigned int *triangle = &indices[adjacency[a] * 3];
+            if (triangle[0] == to || triangle[1] == to || triangle[2] == to)
+                continue; // collapses away
+            glm::vec3 before[3], after[3];
+            for (int k = 0; k < 3; k++)
+            {
+                before[k] = vertices[remap[triangle[k]]].Position;
+                after[k] = triangle[k] == from ? vertices[to].Position : before[k];
+            }
+            glm::vec3 n0 = glm::cross(before[1] - before[0], before[2] - before[0]);
+            glm::vec3 n1 = glm::cross(after[1] - after[0], after[2] - after[0]);
+            // reject flipped and nearly degenerate results
+            if (glm::dot(n0, n1) <= 0.25f * glm::length(n0) * glm::length(n1))
+                return true;
+        }
+        return false;
+    }
+};
+#endif
@@ -0,0 +1,276 @@
+#ifndef MESHLET_H
+#define MESHLET_H
+
+#include <glad/glad.h>
+#include <glm/glm.hpp>
+
+#include <learnopengl/frustum.h>
+#include <learnopengl/simd.h>
+
+#include <algorithm>
+#include <cmath>
+#include <cstdint>
+#include <vector>
+
+// a cluster of up to MaxVertices vertices / MaxTriangles triangles stored as one contiguous range of the mesh's index buffer
+struct Meshlet
+{
+    unsigned int firstIndex;
+    unsigned int indexCount;
+    unsigned int vertexCount; // unique vertices referenced
+};
+
+// index ranges left after culling, ready for glMultiDrawElementsBaseVertex. Adjacent visible meshlets are merged into one range.
+struct MeshletDrawList
+{
+    std::vector<GLsizei>     counts;
+    std::vector<const void*> offsets;
+    std::vector<GLint>       baseVertices;
+    size_t visibleMeshlets = 0;
+    size_t visibleTriangles = 0;
+
+    void clear()
+    {
+        counts.clear();
+        offsets.clear();
+        baseVertices.clear();
+        visibleMeshlets = visibleTriangles = 0;
+    }
+};
+
+// the meshlets of one mesh plus their culling data: a bounding sphere and a cone bounding the triangle normals.
+// the culling data is kept as structure of arrays padded to a multiple of 4, so Cull() tests four meshlets per step.
+// everything here is CPU only; only MeshletDrawList is consumed by GL.
+class MeshletSet
+{
+public:
+    static const unsigned int MaxVertices = 64;
+    static const unsigned int MaxTriangles = 124;
+
+    std::vector<Meshlet> meshlets;
+
+    // partitions the triangle list into meshlets. The triangles keep their order (which MeshOptimizer already made
+    // cache and locality friendly), so indices stay valid and only meshlet boundaries are added.
+    template<typename VertexT>
+    void Build(const std::vector<VertexT> &vertices, const std::vector<unsigned int> &indices,
+               unsigned int maxVertices = MaxVertices, unsigned int maxTriangles = MaxTriangles)
+    {
+        meshlets.clear();
+        // last meshlet each vertex was counted in, so the unique vertex count needs no set
+        std::vector<unsigned int> seen(vertices.size(), ~0u);
+        Meshlet current = { 0, 0, 0 };
+        for (size_t i = 0; i + 2 < indices.size(); i += 3)
+        {
+            unsigned int id = static_cast<unsigned int>(meshlets.size());
+            unsigned int newVertices = 0;
+            for (int k = 0; k < 3; k++)
+                newVertices += seen[indices[i + k]] != id;
+            if (current.indexCount > 0 && (current.vertexCount + newVertices > maxVertices || current.indexCount / 3 + 1 > maxTriangles))
+            {
+                meshlets.push_back(current);
+                current = { static_cast<unsigned int>(i), 0, 0 };
+                id++;
+            }
+            for (int k = 0; k < 3; k++)
+            {
+                if (seen[indices[i + k]] != id)
+                {
+                    seen[indices[i + k]] = id;
+                    current.vertexCount++;
+                }
+            }
+            current.indexCount += 3;
+        }
+        if (current.indexCount > 0)
+            meshlets.push_back(current);
+
+        computeBounds(vertices, indices);
+    }
+
+    // frustum and backface cone test of every meshlet of a mesh drawn with the given model matrix.
+    // the test runs in object space, which is exact for any affine model matrix. firstIndex and baseVertex place the
+    // emitted ranges when the mesh lives in a shared buffer (see MeshArena), indexSize is the bytes per GPU index.
+    void Cull(const Frustum &frustum, const glm::mat4 &model, const glm::vec3 &cameraPosition, MeshletDrawList &out,
+              unsigned int firstIndex = 0, int baseVertex = 0, size_t indexSize = sizeof(unsigned int)) const
+    {
+#ifdef LOGL_SSE2
+        out.clear();
+        if (meshlets.empty())
+            return;
+        glm::vec4 planes[6];
+        glm::vec3 camera;
+        const bool coneTest = objectSpace(frustum, model, cameraPosition, planes, camera);
+
+        const size_t count = meshlets.size();
+        for (size_t i = 0; i < count; i += 4)
+        {
+            const __m128 cx = _mm_loadu_ps(&centerX[i]), cy = _mm_loadu_ps(&centerY[i]), cz = _mm_loadu_ps(&centerZ[i]);
+            const __m128 r = _mm_loadu_ps(&radius[i]);
+            const __m128 negativeR = _mm_sub_ps(_mm_setzero_ps(), r);
+            __m128 visible = _mm_castsi128_ps(_mm_set1_epi32(-1));
+            for (int p = 0; p < 6; p++)
+            {
+                __m128 distance = _mm_add_ps(_mm_add_ps(_mm_mul_ps(cx, _mm_set1_ps(planes[p].x)), _mm_mul_ps(cy, _mm_set1_ps(planes[p].y))),
+                                             _mm_add_ps(_mm_mul_ps(cz, _mm_set1_ps(planes[p].z)), _mm_set1_ps(planes[p].w)));
+                visible = _mm_and_ps(visible, _mm_cmpgt_ps(distance, negativeR));
+            }
+            if (coneTest)
+            {
+                // back facing when the whole sphere lies inside the cone of view directions that see only back faces
+                const __m128 vx = _mm_sub_ps(cx, _mm_set1_ps(camera.x));
+                const __m128 vy = _mm_sub_ps(cy, _mm_set1_ps(camera.y));
+                const __m128 vz = _mm_sub_ps(cz, _mm_set1_ps(camera.z));
+                const __m128 along = _mm_add_ps(_mm_add_ps(_mm_mul_ps(vx, _mm_loadu_ps(&axisX[i])), _mm_mul_ps(vy, _mm_loadu_ps(&axisY[i]))),
+                                                _mm_mul_ps(vz, _mm_loadu_ps(&axisZ[i])));
+                const __m128 length = _mm_sqrt_ps(_mm_add_ps(_mm_add_ps(_mm_mul_ps(vx, vx), _mm_mul_ps(vy, vy)), _mm_mul_ps(vz, vz)));
+                const __m128 backfacing = _mm_cmpge_ps(along, _mm_add_ps(_mm_mul_ps(_mm_loadu_ps(&cutoff[i]), length), r));
+                visible = _mm_andnot_ps(backfacing, visible);
+            }
+            emit(_mm_movemask_ps(visible), i, firstIndex, baseVertex, indexSize, out);
+        }
+#else
+        CullScalar(frustum, model, cameraPosition, out, firstIndex, baseVertex, indexSize);
+#endif
+    }
+
+    // the same test one meshlet at a time, what Cull() runs without SSE2. Gives the same draw list.
+    void CullScalar(const Frustum &frustum, const glm::mat4 &model, const glm::vec3 &cameraPosition, MeshletDrawList &out,
+                    unsigned int firstIndex = 0, int baseVertex = 0, size_t indexSize = sizeof(unsigned int)) const
+    {
+        out.clear();
+        if (meshlets.empty())
+            return;
+        glm::vec4 planes[6];
+        glm::vec3 camera;
+        const bool coneTest = objectSpace(frustum, model, cameraPosition, planes, camera);
+
+        const size_t count = meshlets.size();
+        for (size_t i = 0; i < count; i += 4)
+        {
+            int mask = 0;
+            for (size_t j = i; j < i + 4 && j < count; j++)
+                mask |= visibleScalar(j, planes, camera, coneTest) << (j - i);
+            emit(mask, i, firstIndex, baseVertex, indexSize, out);
+        }
+    }
+
+private:
+    // the frustum planes and the camera moved into object space. Returns whether the cone test applies.
+    static bool objectSpace(const Frustum &frustum, const glm::mat4 &model, const glm::vec3 &cameraPosition, glm::vec4 planes[6], glm::vec3 &camera)
+    {
+        // world plane (n, -d) -> object space plane transpose(M) * (n, -d)
+        const Plane *faces[6] = { &frustum.leftFace, &frustum.rightFace, &frustum.nearFace, &frustum.farFace, &frustum.topFace, &frustum.bottomFace };
+        for (int p = 0; p < 6; p++)
+        {
+            glm::vec4 plane = glm::transpose(model) * glm::vec4(faces[p]->normal, -faces[p]->distance);
+            planes[p] = plane / glm::length(glm::vec3(plane));
+        }
+        camera = glm::vec3(glm::inverse(model) * glm::vec4(cameraPosition, 1.0f));
+        // a mirroring transform turns front faces into back faces, skip the cone test then
+        return glm::determinant(glm::mat3(model)) > 0.0f;
+    }
+
+    // scalar version of the test Cull() vectorises
+    bool visibleScalar(size_t i, const glm::vec4 planes[6], const glm::vec3 &camera, bool coneTest) const
+    {
+        glm::vec3 center(centerX[i], centerY[i], centerZ[i]);
+        for (int p = 0; p < 6; p++)
+            if (!(glm::dot(glm::vec3(planes[p]), center) + planes[p].w > -radius[i]))
+                return false;
+        if (coneTest)
+        {
+            glm::vec3 view = center - camera;
+            if (glm::dot(view, glm::vec3(axisX[i], axisY[i], axisZ[i])) >= cutoff[i] * glm::length(view) + radius[i])
+                return false;
+        }
+        return true;
+    }
+
+    // SoA culling data, padded to a multiple of 4
+    std::vector<float> centerX, centerY, centerZ, radius;
+    std::vector<float> axisX, axisY, axisZ, cutoff;
+
+    template<typename VertexT>
+    void computeBounds(const std::vector<VertexT> &vertices, const std::vector<unsigned int> &indices)
+    {
+        const size_t padded = (meshlets.size() + 3) & ~size_t(3);
+        // the padding lanes are tested but never emitted
+        centerX.assign(padded, 0.0f); centerY.assign(padded, 0.0f); centerZ.assign(padded, 0.0f);
+        radius.assign(padded, 0.0f);
+        axisX.assign(padded, 0.0f); axisY.assign(padded, 0.0f); axisZ.assign(padded, 0.0f);
+        cutoff.assign(padded, 2.0f);
+
+        for (size_t m = 0; m < meshlets.size(); m++)
+        {
+            const Meshlet &meshlet = meshlets[m];
+            // sphere: centre of the bounds, radius to the farthest vertex
+            glm::vec3 minimum(vertices[indices[meshlet.firstIndex]].Position), maximum(minimum);
+            for (unsigned int i = meshlet.firstIndex; i < meshlet.firstIndex + meshlet.indexCount; i++)
+            {
+                minimum = glm::min(minimum, vertices[indices[i]].Position);
+                maximum = glm::max(maximum, vertices[indices[i]].Position);
+            }
+            glm::vec3 center = (minimum + maximum) * 0.5f;
+            float r = 0.0f;
+            for (unsigned int i = meshlet.firstIndex; i < meshlet.firstIndex + meshlet.indexCount; i++)
+                r = std::max(r, glm::length(vertices[indices[i]].Position - center));
+
+            // cone: average face normal, widened until it contains every face normal
+            std::vector<glm::vec3> normals;
+            glm::vec3 axis(0.0f);
+            for (unsigned int i = meshlet.firstIndex; i < meshlet.firstIndex + meshlet.indexCount; i += 3)
+            {
+                const glm::vec3 &p0 = vertices[indices[i]].Position;
+                glm::vec3 normal = glm::cross(vertices[indices[i + 1]].Position - p0, vertices[indices[i + 2]].Position - p0);
+                float length = glm::length(normal);
+                if (length == 0.0f)
+                    continue;
+                normals.push_back(normal / length);
+                axis += normals.back();
+            }
+            float axisLength = glm::length(axis);
+            float c = 2.0f; // never back facing
+            if (axisLength > 0.0f && !normals.empty())
+            {
+                axis /= axisLength;
+                float minDot = 1.0f;
+                for (const glm::vec3 &normal : normals)
+                    minDot = std::min(minDot, glm::dot(axis, normal));
+                // normals spread by more than 90 degrees can always be seen from somewhere
+                if (minDot > 0.0f)
+                    c = std::sqrt(1.0f - minDot * minDot);
+            }
+            else
+                axis = glm::vec3(0.0f);
+
+            centerX[m] = center.x; centerY[m] = center.y; centerZ[m] = center.z;
+            radius[m] = r;
+            axisX[m] = axis.x; axisY[m] = axis.y; axisZ[m] = axis.z;
+            cutoff[m] = c;
+        }
+    }
+
+    // appends the visible meshlets of a batch of 4, extending the previous range when it ends where the meshlet starts
+    void emit(int mask, size_t first, unsigned int firstIndex, int baseVertex, size_t indexSize, MeshletDrawList &out) const
+    {
+        for (size_t j = first; mask != 0 && j < meshlets.size(); j++, mask >>= 1)
+        {
+            if (!(mask & 1))
+                continue;
+            const Meshlet &meshlet = meshlets[j];
+            const void *offset = reinterpret_cast<const void*>(static_cast<uintptr_t>(firstIndex + meshlet.firstIndex) * indexSize);
+            if (!out.counts.empty() &&
+                reinterpret_cast<uintptr_t>(out.offsets.back()) + out.counts.back() * indexSize == reinterpret_cast<uintptr_t>(offset))
+                out.counts.back() += meshlet.indexCount;
+            else
+            {
+                out.counts.push_back(static_cast<GLsizei>(meshlet.indexCount));
+                out.offsets.push_back(offset);
+                out.baseVertices.push_back(baseVertex);
+            }
+            out.visibleMeshlets++;
+            out.visibleTriangles += meshlet.indexCount / 3;
+        }
+    }
+};
+#endif
@@ -7,62 +7,538 @@
 #include <glm/gtc/matrix_transform.hpp>
 #include <stb_image.h>
 #include <assimp/Importer.hpp>
+#include <assimp/IOStream.hpp>
+#include <assimp/IOSystem.hpp>
 #include <assimp/scene.h>
 #include <assimp/postprocess.h>
 
+#include <learnopengl/bounds.h>
 #include <learnopengl/mesh.h>
+#include <learnopengl/mesh_cache.h>
+#include <learnopengl/mesh_optimizer.h>
+#include <learnopengl/mesh_simplify.h>
 #include <learnopengl/shader.h>
+#include <learnopengl/texture_cache.h>
+#include <learnopengl/texture_loader.h>
 
+#include <algorithm>
+#include <atomic>
+#include <chrono>
+#include <cmath>
+#include <cstdio>
+#include <future>
+#include <memory>
 #include <string>
 #include <fstream>
 #include <sstream>
 #include <iostream>
+#include <limits>
 #include <map>
+#include <thread>
+#include <unordered_map>
 #include <vector>
 using namespace std;
 
 unsigned int TextureFromFile(const char *path, const string &directory, bool gamma = false);
 
+class AsyncModel;
+
+// plain stdio file for RecordingIOSystem
+class StdioStream : public Assimp::IOStream
+{
+public:
+    explicit StdioStream(FILE *file) : file(file) {}
+    ~StdioStream() { fclose(file); }
+
+    size_t Read(void *buffer, size_t size, size_t count) { return fread(buffer, size, count, file); }
+    size_t Write(const void *buffer, size_t size, size_t count) { return fwrite(buffer, size, count, file); }
+    aiReturn Seek(size_t offset, aiOrigin origin)
+    {
+        const int whence = origin == aiOrigin_CUR ? SEEK_CUR : origin == aiOrigin_END ? SEEK_END : SEEK_SET;
+        return fseek(file, static_cast<long>(offset), whence) == 0 ? aiReturn_SUCCESS : aiReturn_FAILURE;
+    }
+    size_t Tell() const { return static_cast<size_t>(ftell(file)); }
+    size_t FileSize() const
+    {
+        const long position = ftell(file);
+        fseek(file, 0, SEEK_END);
+        const long size = ftell(file);
+        fseek(file, position, SEEK_SET);
+        return static_cast<size_t>(size);
+    }
+    void Flush() { fflush(file); }
+
+private:
+    FILE *file;
+};
+
+// file access for an Assimp::Importer that remembers every file other than the asset itself the import asked for
+// (materials, external buffers, ...), whether it was there or not. The mesh cache hashes them along with the asset.
+class RecordingIOSystem : public Assimp::IOSystem
+{
+public:
+    vector<string> dependencies;
+
+    explicit RecordingIOSystem(const string &source) : source(source) {}
+
+    bool Exists(const char *file) const
+    {
+        FILE *handle = fopen(file, "rb");
+        if(!handle)
+            return false;
+        fclose(handle);
+        return true;
+    }
+    char getOsSeparator() const { return '/'; }
+    Assimp::IOStream* Open(const char *file, const char *mode = "rb")
+    {
+        if(file != source && std::find(dependencies.begin(), dependencies.end(), file) == dependencies.end())
+            dependencies.push_back(file);
+        FILE *handle = fopen(file, mode);
+        return handle ? new StdioStream(handle) : nullptr;
+    }
+    void Close(Assimp::IOStream *stream) { delete stream; }
+
+private:
+    string source;
+};
+
+// what the last Draw(shader) / DrawIndirect(shader) of a model cost on the CPU side, filled only while
+// Model::collectDrawStats is set
+struct DrawStats
+{
+    unsigned int drawCalls = 0;
+    double submitMicroseconds = 0.0; // time spent issuing GL commands, not GPU time
+};
+
 class Model 
 {
 public:
     // model data 
     vector<Texture> textures_loaded;	// stores all the textures loaded so far, optimization to make sure textures aren't loaded more than once.
     vector<Mesh>    meshes;
+    vector<MeshOptimizationStatistics> optimizationStats; // per mesh, only filled when the model was imported by assimp
+    vector<float> lodErrors; // per level of detail, the largest error of any mesh in model space units. Empty without LODs.
+    vector<MeshBounds> meshBounds; // per mesh, computed once on load
+    MeshBounds bounds; // of the whole model
     string directory;
+    string path; // the file the model was loaded from
     bool gammaCorrection;
+    bool useMeshCache;
+    bool streamTextures;
+    bool collectDrawStats = false; // opt-in, costs two clock reads per draw
+    DrawStats lastDrawStats;
+
+    // post-processing steps applied on import; part of the mesh cache key.
+    static const unsigned int ImportFlags = aiProcess_Triangulate | aiProcess_GenSmoothNormals | aiProcess_FlipUVs | aiProcess_CalcTangentSpace;
 
     // constructor, expects a filepath to a 3D model.
-    Model(string const &path, bool gamma = false) : gammaCorrection(gamma)
+    // with useCache the post-processed meshes are stored next to the model (see mesh_cache.h) so later loads skip assimp.
+    // textures are decoded in parallel by the shared TextureLoader; by default the constructor waits for them to be uploaded.
+    // with stream the constructor returns while the textures still show placeholders, and the render loop has to call
+    // TextureLoader::Instance().ProcessUploads() every frame to finish them.
+    Model(string const &path, bool gamma = false, bool useCache = true, bool stream = false)
+        : gammaCorrection(gamma), useMeshCache(useCache), streamTextures(stream)
     {
         loadModel(path);
+        computeBounds(meshes);
+        if(!streamTextures)
+            TextureLoader::Instance().Flush();
+    }
+
+    // starts loading a model without blocking the calling thread. The file is imported (or read from the mesh cache)
+    // on a worker thread and its textures are decoded by the TextureLoader; the render loop calls Update() on the
+    // returned handle once per frame to create the GL objects under a time budget, and draws through the handle,
+    // which shows a box around the model's bounds until the meshes are uploaded.
+    static std::unique_ptr<AsyncModel> LoadAsync(string const &path, bool gamma = false, bool useCache = true);
+
+    // textures are shared through the process-wide TextureCache, the model only holds references to them
+    Model(const Model&) = delete;
+    Model& operator=(const Model&) = delete;
+
+    ~Model()
+    {
+        for(unsigned int i = 0; i < textures_loaded.size(); i++)
+            TextureCache::Instance().Release(textures_loaded[i].id);
+        for(unsigned int i = 0; i < meshes.size(); i++)
+            meshes[i].ReleaseArena();
     }
 
     // draws the model, and thus all its meshes
     void Draw(Shader &shader)
     {
+        if(collectDrawStats)
+        {
+            const auto start = std::chrono::steady_clock::now();
+            for(unsigned int i = 0; i < meshes.size(); i++)
+                meshes[i].Draw(shader);
+            recordDrawStats(static_cast<unsigned int>(meshes.size()), start);
+            return;
+        }
         for(unsigned int i = 0; i < meshes.size(); i++)
             meshes[i].Draw(shader);
     }
+
+    // moves every mesh into the shared MeshArena and records one indirect draw command per mesh, so DrawIndirect()
+    // draws the whole model with one glMultiDrawElementsIndirect per index type and distinct set of textures instead of
+    // one draw per mesh.
+    // each command's baseInstance is the mesh index, readable in the vertex shader through MeshArena's draw id attribute:
+    //     layout (location = 15) in uint aDrawID;
+    // call again after GenerateLods(), which may move meshes inside the arena.
+    void UseArena()
+    {
+        for(unsigned int i = 0; i < meshes.size(); i++)
+            meshes[i].MoveToArena();
+        MeshArena<StaticVertex>::Instance().ReserveDrawIDs(meshes.size());
+
+        // group the meshes by index type and textures, the only per mesh state left
+        vector<unsigned int> order(meshes.size());
+        for(unsigned int i = 0; i < order.size(); i++)
+            order[i] = i;
+        auto textureIds = [this](unsigned int mesh)
+        {
+            vector<unsigned int> ids;
+            for(const Texture &texture : meshes[mesh].textures)
+                ids.push_back(texture.id);
+            return ids;
+        };
+        auto key = [&](unsigned int mesh) { return std::make_pair(meshes[mesh].indexType, textureIds(mesh)); };
+        std::stable_sort(order.begin(), order.end(), [&](unsigned int a, unsigned int b) { return key(a) < key(b); });
+
+        vector<DrawElementsIndirectCommand> commands;
+        indirectBatches.clear();
+        for(unsigned int i = 0; i < order.size(); i++)
+        {
+            if(indirectBatches.empty() || key(order[i]) != key(indirectBatches.back().mesh))
+                indirectBatches.push_back({ order[i], static_cast<unsigned int>(commands.size()), 0 });
+            commands.push_back(meshes[order[i]].IndirectCommand(order[i]));
+            indirectBatches.back().commandCount++;
+        }
+
+        if(indirectBuffer == 0)
+            glGenBuffers(1, &indirectBuffer);
+        glBindBuffer(GL_DRAW_INDIRECT_BUFFER, indirectBuffer);
+        glBufferData(GL_DRAW_INDIRECT_BUFFER, commands.size() * sizeof(DrawElementsIndirectCommand), commands.data(), GL_STATIC_DRAW);
+        glBindBuffer(GL_DRAW_INDIRECT_BUFFER, 0);
+    }
+
+    // draws the model from the arena set up by UseArena()
+    void DrawIndirect(Shader &shader)
+    {
+        if(indirectBuffer == 0)
+        {
+            cout << "ERROR::MODEL::DRAW_INDIRECT: UseArena() was not called" << endl;
+            return;
+        }
+        const auto start = collectDrawStats ? std::chrono::steady_clock::now() : std::chrono::steady_clock::time_point();
+        glBindVertexArray(MeshArena<StaticVertex>::Instance().VertexArray());
+        glBindBuffer(GL_DRAW_INDIRECT_BUFFER, indirectBuffer);
+        for(const IndirectBatch &batch : indirectBatches)
+        {
+            meshes[batch.mesh].BindMaterial(shader);
+            glMultiDrawElementsIndirect(GL_TRIANGLES, meshes[batch.mesh].indexType, (void*)(batch.firstCommand * sizeof(DrawElementsIndirectCommand)), batch.commandCount, 0);
+        }
+        glBindBuffer(GL_DRAW_INDIRECT_BUFFER, 0);
+        glBindVertexArray(0);
+        glActiveTexture(GL_TEXTURE0);
+        if(collectDrawStats)
+            recordDrawStats(static_cast<unsigned int>(indirectBatches.size()), start);
+    }
+
+    // draws the model at the level of detail SelectLod() picks for the given placement and camera
+    void Draw(Shader &shader, const glm::mat4 &model, const glm::vec3 &cameraPosition, float fovY, float viewportHeight, float pixelError = 1.0f)
+    {
+        unsigned int lod = SelectLod(model, cameraPosition, fovY, viewportHeight, pixelError);
+        for(unsigned int i = 0; i < meshes.size(); i++)
+            meshes[i].Draw(shader, lod);
+    }
+
+    // generates levelCount coarser levels of detail for every mesh, each with about reduction times the triangles of
+    // the one before. Levels stop early once a mesh can't be simplified further within maxRelativeError of the model's size.
+    // the meshes are simplified in parallel, the index buffers are uploaded afterwards on the calling (context) thread.
+    void GenerateLods(unsigned int levelCount = 3, float reduction = 0.5f, float maxRelativeError = 0.05f)
+    {
+        const float maxError = maxRelativeError * 2.0f * bounds.sphere.radius;
+
+        vector<vector<vector<unsigned int>>> levels(meshes.size());
+        vector<vector<float>> errors(meshes.size());
+        std::atomic<size_t> next(0);
+        auto worker = [&]()
+        {
+            for(size_t m = next++; m < meshes.size(); m = next++)
+            {
+                const vector<unsigned int> *source = &meshes[m].indices;
+                for(unsigned int level = 0; level < levelCount; level++)
+                {
+                    size_t target = static_cast<size_t>(source->size() / 3 * reduction) * 3;
+                    float error = 0.0f;
+                    vector<unsigned int> simplified = MeshSimplifier::Simplify(meshes[m].vertices, *source, target, maxError, &error);
+                    // not worth another level if it barely got smaller
+                    if(simplified.size() > source->size() - source->size() / 10)
+                        break;
+                    // each level is simplified from the previous one, so their errors add up
+                    errors[m].push_back(level > 0 ? errors[m].back() + error : error);
+                    levels[m].push_back(std::move(simplified));
+                    source = &levels[m].back();
+                }
+            }
+        };
+        unsigned int threadCount = std::min<unsigned int>(std::max(1u, std::thread::hardware_concurrency()), static_cast<unsigned int>(meshes.size()));
+        vector<std::thread> threads;
+        for(unsigned int i = 1; i < threadCount; i++)
+            threads.emplace_back(worker);
+        worker();
+        for(std::thread &thread : threads)
+            thread.join();
+
+        // a mesh that ran out of levels keeps drawing its coarsest one, so every mesh exposes the same level count
+        size_t levelsGenerated = 0;
+        for(size_t m = 0; m < meshes.size(); m++)
+            levelsGenerated = std::max(levelsGenerated, levels[m].size());
+        lodErrors.assign(levelsGenerated + 1, 0.0f);
+        for(size_t m = 0; m < meshes.size(); m++)
+        {
+            while(levels[m].size() < levelsGenerated)
+            {
+                levels[m].push_back(levels[m].empty() ? meshes[m].indices : levels[m].back());
+                errors[m].push_back(errors[m].empty() ? 0.0f : errors[m].back());
+            }
+            for(size_t level = 0; level < levelsGenerated; level++)
+                lodErrors[level + 1] = std::max(lodErrors[level + 1], errors[m][level]);
+            meshes[m].SetLods(levels[m], errors[m]);
+        }
+    }
+
+    // partitions every mesh into meshlets so Draw(shader, frustum, ...) can cull inside the meshes
+    void BuildMeshlets()
+    {
+        for(unsigned int i = 0; i < meshes.size(); i++)
+            meshes[i].BuildMeshlets();
+    }
+
+    // culls the meshlets of every mesh against the frustum and their backface cones, then draws the survivors
+    // with one multi-draw per mesh. Meshes without meshlets are drawn whole. Returns the number of triangles drawn.
+    size_t Draw(Shader &shader, const Frustum &frustum, const glm::mat4 &model, const glm::vec3 &cameraPosition)
+    {
+        size_t triangles = 0;
+        for(unsigned int i = 0; i < meshes.size(); i++)
+        {
+            if(meshes[i].meshlets.meshlets.empty())
+            {
+                meshes[i].Draw(shader);
+                triangles += meshes[i].indices.size() / 3;
+                continue;
+            }
+            meshes[i].meshlets.Cull(frustum, model, cameraPosition, meshletDrawList, meshes[i].arenaRange.firstIndex, meshes[i].arenaRange.baseVertex,
+                                    IndexSize(meshes[i].indexType));
+            meshes[i].Draw(shader, meshletDrawList);
+            triangles += meshletDrawList.visibleTriangles;
+        }
+        return triangles;
+    }
+
+    // number of triangles drawn at the given level of detail
+    size_t TriangleCount(unsigned int lod = 0) const
+    {
+        size_t count = 0;
+        for(unsigned int i = 0; i < meshes.size(); i++)
+            count += (lod > 0 && lod < meshes[i].lods.size() ? meshes[i].lods[lod].indexCount : meshes[i].indices.size()) / 3;
+        return count;
+    }
+
+    // GPU memory of the full resolution index buffers; 12 bytes per triangle would be the 32-bit size
+    size_t IndexBytes() const
+    {
+        size_t bytes = 0;
+        for(unsigned int i = 0; i < meshes.size(); i++)
+            bytes += meshes[i].indices.size() * IndexSize(meshes[i].indexType);
+        return bytes;
+    }
+
+    // picks the coarsest level of detail whose error covers at most pixelError pixels on screen.
+    // fovY is the vertical field of view in radians, viewportHeight in pixels.
+    unsigned int SelectLod(const glm::mat4 &model, const glm::vec3 &cameraPosition, float fovY, float viewportHeight, float pixelError = 1.0f) const
+    {
+        if(lodErrors.size() < 2)
+            return 0;
+        float scale = std::max(glm::length(glm::vec3(model[0])), std::max(glm::length(glm::vec3(model[1])), glm::length(glm::vec3(model[2]))));
+        glm::vec3 center = glm::vec3(model * glm::vec4(bounds.sphere.center, 1.0f));
+        // distance to the nearest point of the bounding sphere, the camera inside it gets full detail
+        float distance = glm::length(center - cameraPosition) - bounds.sphere.radius * scale;
+        if(distance <= 0.0f)
+            return 0;
+        float pixelsPerUnit = viewportHeight / (2.0f * distance * std::tan(fovY * 0.5f));
+        unsigned int lod = 0;
+        while(lod + 1 < lodErrors.size() && lodErrors[lod + 1] * scale * pixelsPerUnit <= pixelError)
+            lod++;
+        return lod;
+    }
     
 private:
+    friend class AsyncModel;
+
+    // a mesh between import and upload, CPU data only. Texture ids are resolved when the mesh is built.
+    struct ImportedMesh
+    {
+        vector<StaticVertex> vertices;
+        vector<unsigned int> indices;
+        vector<Texture>      textures;
+    };
+
+    // a run of indirect commands sharing the textures of meshes[mesh]
+    struct IndirectBatch
+    {
+        unsigned int mesh;
+        unsigned int firstCommand;
+        unsigned int commandCount;
+    };
+
+    unordered_map<string, size_t> texturesByPath; // path (plus "|srgb" for sRGB loads) -> index into textures_loaded
+    vector<ImportedMesh> imported; // filled by importModel(), emptied by buildMesh()
+    unsigned int indirectBuffer = 0;
+    vector<IndirectBatch> indirectBatches;
+    MeshletDrawList meshletDrawList; // reused by every culled draw to avoid per frame allocations
+
+    // per mesh box and sphere plus the model's: the box is the union of the mesh boxes, the sphere is fitted to every vertex.
+    // takes the meshes, or the imported data before they exist, so it runs once per load on whichever thread loads.
+    template<typename MeshT>
+    void computeBounds(const vector<MeshT> &source)
+    {
+        meshBounds.resize(source.size());
+        bool empty = true;
+        for(size_t i = 0; i < source.size(); i++)
+        {
+            meshBounds[i] = Bounds::Compute(source[i].vertices.data(), source[i].vertices.size());
+            if(source[i].vertices.empty())
+                continue;
+            bounds.box = empty ? meshBounds[i].box : Bounds::Merge(bounds.box, meshBounds[i].box);
+            empty = false;
+        }
+        if(empty)
+            return;
+        bounds.sphere = Bounds::ComputeSphere([&source](auto &&f)
+        {
+            for(const MeshT &mesh : source)
+                for(const auto &vertex : mesh.vertices)
+                    f(vertex.Position);
+        }, bounds.box);
+    }
+
+    void recordDrawStats(unsigned int drawCalls, std::chrono::steady_clock::time_point start)
+    {
+        lastDrawStats.drawCalls = drawCalls;
+        lastDrawStats.submitMicroseconds = std::chrono::duration<double, std::micro>(std::chrono::steady_clock::now() - start).count();
+    }
+
+    // used by LoadAsync(), which imports on a worker thread and builds the meshes later
+    struct Deferred {};
+    Model(Deferred, bool gamma, bool useCache)
+        : gammaCorrection(gamma), useMeshCache(useCache), streamTextures(true)
+    {
+    }
+
     // loads a model with supported ASSIMP extensions from file and stores the resulting meshes in the meshes vector.
     void loadModel(string const &path)
     {
-        // read file via ASSIMP
+        // retrieve the directory path of the filepath
+        this->path = path;
+        directory = path.substr(0, path.find_last_of('/'));
+
+        // a valid cache holds the exact result of the import below, so only a cache miss has to touch ASSIMP
+        uint64_t sourceHash = 0;
+        if(useMeshCache)
+        {
+            sourceHash = MeshCache::HashFile(path);
+            if(loadFromCache(path, sourceHash))
+                return;
+        }
+
+        if(!importAssimp(path, sourceHash))
+            return;
+        for(size_t i = 0; i < imported.size(); i++)
+            buildMesh(imported[i]);
+        imported.clear();
+    }
+
+    // the CPU half of loadModel(): fills imported from the cache or ASSIMP without touching GL, so it may run on any thread
+    bool importModel(string const &path)
+    {
+        this->path = path;
+        directory = path.substr(0, path.find_last_of('/'));
+
+        uint64_t sourceHash = 0;
+        if(useMeshCache)
+        {
+            sourceHash = MeshCache::HashFile(path);
+            MeshCache cache;
+            if(cache.open(path, sourceHash, ImportFlags))
+            {
+                imported.resize(cache.meshCount());
+                for(unsigned int i = 0; i < cache.meshCount(); i++)
+                {
+                    const MeshCacheEntry &entry = cache.mesh(i);
+                    imported[i].vertices.assign(cache.vertices(i), cache.vertices(i) + entry.vertexCount);
+                    imported[i].indices.assign(cache.indices(i), cache.indices(i) + entry.indexCount);
+                    for(unsigned int t = entry.firstTexture; t < entry.firstTexture + entry.textureCount; t++)
+                        imported[i].textures.push_back(Texture{ 0, cache.textureType(t), cache.texturePath(t) });
+                }
+                return true;
+            }
+        }
+        return importAssimp(path, sourceHash);
+    }
+
+    // reads the file via ASSIMP into imported and refreshes the mesh cache. No GL calls.
+    bool importAssimp(string const &path, uint64_t sourceHash)
+    {
+        // read file via ASSIMP, noting the other files it reads so the cache can tell when one of them changes
         Assimp::Importer importer;
-        const aiScene* scene = importer.ReadFile(path, aiProcess_Triangulate | aiProcess_GenSmoothNormals | aiProcess_FlipUVs | aiProcess_CalcTangentSpace);
+        RecordingIOSystem *io = new RecordingIOSystem(path);
+        importer.SetIOHandler(io); // owned by the importer from here on
+        const aiScene* scene = importer.ReadFile(path, ImportFlags);
         // check for errors
         if(!scene || scene->mFlags & AI_SCENE_FLAGS_INCOMPLETE || !scene->mRootNode) // if is Not Zero
         {
             cout << "ERROR::ASSIMP:: " << importer.GetErrorString() << endl;
-            return;
+            return false;
         }
-        // retrieve the directory path of the filepath
-        directory = path.substr(0, path.find_last_of('/'));
 
         // process ASSIMP's root node recursively
         processNode(scene->mRootNode, scene);
+
+        if(useMeshCache && sourceHash != 0 && !MeshCache::Write(path, sourceHash, ImportFlags, imported, io->dependencies))
+            cout << "WARNING::MESH_CACHE:: could not write cache for " << path << endl;
+        return true;
+    }
+
+    // context thread only: resolves the textures of an imported mesh and uploads it, releasing the CPU copy it came from
+    void buildMesh(ImportedMesh &data)
+    {
+        vector<Texture> textures;
+        for(unsigned int i = 0; i < data.textures.size(); i++)
+            textures.push_back(loadTexture(data.textures[i].path.c_str(), data.textures[i].type));
+        meshes.emplace_back(std::move(data.vertices), std::move(data.indices), textures);
+        data = ImportedMesh();
+    }
+
+    // builds the meshes from a memory mapped cache file. The vertex/index data is uploaded from the mapping, each mesh
+    // still keeps its own CPU copy (see the BasicMesh constructor).
+    bool loadFromCache(string const &path, uint64_t sourceHash)
+    {
+        MeshCache cache;
+        if(!cache.open(path, sourceHash, ImportFlags))
+            return false;
+
+        meshes.reserve(cache.meshCount());
+        for(unsigned int i = 0; i < cache.meshCount(); i++)
+        {
+            const MeshCacheEntry &entry = cache.mesh(i);
+            vector<Texture> textures;
+            for(unsigned int t = entry.firstTexture; t < entry.firstTexture + entry.textureCount; t++)
+                textures.push_back(loadTexture(cache.texturePath(t).c_str(), cache.textureType(t)));
+            meshes.emplace_back(cache.vertices(i), entry.vertexCount, cache.indices(i), entry.indexCount, textures);
+        }
+        return true;
     }
 
     // processes a node in a recursive fashion. Processes each individual mesh located at the node and repeats this process on its children nodes (if any).
@@ -74,7 +550,7 @@ private:
             // the node object only contains indices to index the actual objects in the scene. 
             // the scene contains all the data, node is just to keep stuff organized (like relations between nodes).
             aiMesh* mesh = scene->mMeshes[node->mMeshes[i]];
-            meshes.push_back(processMesh(mesh, scene));
+            imported.push_back(processMesh(mesh, scene));
         }
         // after we've processed all of the meshes (if any) we then recursively process each of the children nodes
         for(unsigned int i = 0; i < node->mNumChildren; i++)
@@ -84,17 +560,17 @@ private:
 
     }
 
-    Mesh processMesh(aiMesh *mesh, const aiScene *scene)
+    ImportedMesh processMesh(aiMesh *mesh, const aiScene *scene)
     {
         // data to fill
-        vector<Vertex> vertices;
+        vector<StaticVertex> vertices;
         vector<unsigned int> indices;
         vector<Texture> textures;
 
         // walk through each of the mesh's vertices
         for(unsigned int i = 0; i < mesh->mNumVertices; i++)
         {
-            Vertex vertex;
+            StaticVertex vertex;
             glm::vec3 vector; // we declare a placeholder vector since assimp uses its own vector class that doesn't directly convert to glm's vec3 class so we transfer the data to this placeholder glm::vec3 first.
             // positions
             vector.x = mesh->mVertices[i].x;
@@ -118,19 +594,19 @@ private:
                 vec.x = mesh->mTextureCoords[0][i].x; 
                 vec.y = mesh->mTextureCoords[0][i].y;
                 vertex.TexCoords = vec;
-                // tangent
+                // tangent, the bitangent is folded into the handedness stored in w
                 vector.x = mesh->mTangents[i].x;
                 vector.y = mesh->mTangents[i].y;
                 vector.z = mesh->mTangents[i].z;
-                vertex.Tangent = vector;
-                // bitangent
-                vector.x = mesh->mBitangents[i].x;
-                vector.y = mesh->mBitangents[i].y;
-                vector.z = mesh->mBitangents[i].z;
-                vertex.Bitangent = vector;
+                glm::vec3 bitangent(mesh->mBitangents[i].x, mesh->mBitangents[i].y, mesh->mBitangents[i].z);
+                float handedness = glm::dot(glm::cross(vertex.Normal, vector), bitangent) < 0.0f ? -1.0f : 1.0f;
+                vertex.Tangent = glm::vec4(vector, handedness);
             }
             else
+            {
                 vertex.TexCoords = glm::vec2(0.0f, 0.0f);
+                vertex.Tangent = glm::vec4(0.0f, 0.0f, 0.0f, 1.0f);
+            }
 
             vertices.push_back(vertex);
         }
@@ -164,12 +640,15 @@ private:
         std::vector<Texture> heightMaps = loadMaterialTextures(material, aiTextureType_AMBIENT, "texture_height");
         textures.insert(textures.end(), heightMaps.begin(), heightMaps.end());
         
-        // return a mesh object created from the extracted mesh data
-        return Mesh(vertices, indices, textures);
+        // assimp leaves duplicated vertices and an arbitrary triangle order behind, weld and reorder for the GPU caches
+        optimizationStats.push_back(MeshOptimizer::Optimize(vertices, indices));
+
+        // return the extracted mesh data, it is uploaded by buildMesh()
+        return ImportedMesh{ std::move(vertices), std::move(indices), std::move(textures) };
     }
 
-    // checks all material textures of a given type and loads the textures if they're not loaded yet.
-    // the required info is returned as a Texture struct.
+    // checks all material textures of a given type and returns their paths as Texture structs.
+    // the textures themselves are loaded by buildMesh().
     vector<Texture> loadMaterialTextures(aiMaterial *mat, aiTextureType type, string typeName)
     {
         vector<Texture> textures;
@@ -177,31 +656,210 @@ private:
         {
             aiString str;
             mat->GetTexture(type, i, &str);
-            // check if texture was loaded before and if so, continue to next iteration: skip loading a new texture
-            bool skip = false;
-            for(unsigned int j = 0; j < textures_loaded.size(); j++)
+            textures.push_back(Texture{ 0, typeName, str.C_Str() });
+        }
+        return textures;
+    }
+
+    // loads a single texture unless this model already references a texture with the same filepath.
+    Texture loadTexture(const char *path, const string &typeName)
+    {
+        // colour maps are stored in sRGB when the model is gamma corrected, data maps (specular, normal, height) never are
+        TextureParams params;
+        params.srgb = gammaCorrection && typeName == "texture_diffuse";
+        const string key = params.srgb ? string(path) + "|srgb" : string(path);
+
+        // check if texture was loaded before and if so, skip loading a new texture
+        auto loaded = texturesByPath.find(key);
+        if(loaded != texturesByPath.end())
+            return textures_loaded[loaded->second]; // a texture with the same filepath has already been loaded (optimization)
+
+        // otherwise take a reference from the shared cache, which only decodes files no other model has loaded yet
+        Texture texture;
+        texture.id = TextureCache::Instance().Acquire(this->directory + '/' + string(path), params);
+        texture.type = typeName;
+        texture.path = path;
+        texturesByPath[key] = textures_loaded.size();
+        textures_loaded.push_back(texture);  // store it as texture loaded for entire model, to ensure we won't unnecessary load duplicate textures.
+        return texture;
+    }
+};
+
+
+// a model being loaded in the background, see Model::LoadAsync(). The handle owns the model.
+class AsyncModel
+{
+public:
+    enum class State { Importing, Uploading, Ready, Failed };
+
+    AsyncModel(const AsyncModel&) = delete;
+    AsyncModel& operator=(const AsyncModel&) = delete;
+
+    ~AsyncModel()
+    {
+        // the import may still be running, it writes into the model
+        if(import.valid())
+            import.wait();
+    }
+
+    State GetState() const { return state; }
+    bool IsReady() const { return state == State::Ready; }
+
+    // the model, nullptr until it is ready
+    Model* Get() { return state == State::Ready ? model.get() : nullptr; }
+
+    // fraction of the meshes uploaded so far
+    float Progress() const
+    {
+        if(state == State::Ready)
+            return 1.0f;
+        return meshCount > 0 ? static_cast<float>(nextMesh) / meshCount : 0.0f;
+    }
+
+    // context thread only, once per frame: uploads meshes until budgetMilliseconds are used up (at least one per call)
+    // and spends what is left on decoded textures. Textures may still show placeholders for a few frames after the
+    // model becomes ready, keep calling Update() to finish them. Returns true once the model is ready.
+    bool Update(double budgetMilliseconds = 2.0)
+    {
+        auto start = std::chrono::steady_clock::now();
+        auto elapsed = [&start]() { return std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - start).count(); };
+
+        if(state == State::Importing)
+        {
+            if(import.wait_for(std::chrono::seconds(0)) != std::future_status::ready)
+                return false;
+            if(!import.get())
             {
-                if(std::strcmp(textures_loaded[j].path.data(), str.C_Str()) == 0)
-                {
-                    textures.push_back(textures_loaded[j]);
-                    skip = true; // a texture with the same filepath has already been loaded, continue to next one. (optimization)
-                    break;
-                }
+                state = State::Failed;
+                return false;
             }
-            if(!skip)
-            {   // if texture hasn't been loaded already, load it
-                Texture texture;
-                texture.id = TextureFromFile(str.C_Str(), this->directory);
-                texture.type = typeName;
-                texture.path = str.C_Str();
-                textures.push_back(texture);
-                textures_loaded.push_back(texture);  // store it as texture loaded for entire model, to ensure we won't unnecessary load duplicate textures.
+            meshCount = model->imported.size();
+            createProxy();
+            state = State::Uploading;
+        }
+        if(state == State::Uploading)
+        {
+            do
+            {
+                if(nextMesh < meshCount)
+                    model->buildMesh(model->imported[nextMesh++]);
+            } while(nextMesh < meshCount && elapsed() < budgetMilliseconds);
+            if(nextMesh == meshCount)
+            {
+                model->imported.clear();
+                deleteProxy();
+                state = State::Ready;
             }
         }
-        return textures;
+        while(elapsed() < budgetMilliseconds && TextureLoader::Instance().ProcessUploads(1) > 0)
+            ;
+        return state == State::Ready;
+    }
+
+    // draws the model once it is ready, its bounding box while the meshes are uploading and nothing before that
+    void Draw(Shader &shader)
+    {
+        if(state == State::Ready)
+            model->Draw(shader);
+        else if(state == State::Uploading && proxyVAO != 0)
+        {
+            glActiveTexture(GL_TEXTURE0);
+            glBindTexture(GL_TEXTURE_2D, proxyTexture);
+            shader.setInt("texture_diffuse1", 0);
+            glBindVertexArray(proxyVAO);
+            glDrawArrays(GL_TRIANGLES, 0, 36);
+            glBindVertexArray(0);
+        }
+    }
+
+    // deletes the placeholder box of a model that is still uploading; call while the GL context is current, before
+    // glfwTerminate(). The destructor doesn't touch GL, so dropping the handle mid-upload without Release() leaks
+    // the box's vertex array, buffer and texture. Update() deletes the box itself once the model is ready.
+    void Release()
+    {
+        if(proxyVAO != 0)
+            deleteProxy();
+    }
+
+private:
+    friend class Model;
+
+    // declared before the future: the worker writes into the model, so the model has to outlive it
+    std::unique_ptr<Model> model;
+    std::future<bool> import;
+    State state = State::Importing;
+    size_t meshCount = 0, nextMesh = 0;
+    unsigned int proxyVAO = 0, proxyVBO = 0, proxyTexture = 0;
+
+    AsyncModel(string const &path, bool gamma, bool useCache)
+        : model(new Model(Model::Deferred(), gamma, useCache))
+    {
+        import = std::async(std::launch::async, [this, path]()
+        {
+            if(!model->importModel(path))
+                return false;
+            model->computeBounds(model->imported);
+            return true;
+        });
+    }
+
+    // a box around the imported bounds with a grey diffuse texture, drawn with the model's own shader
+    void createProxy()
+    {
+        const glm::vec3 corner[2] = { model->bounds.box.min, model->bounds.box.max };
+        // per face: axis of the normal, side, and the two other axes
+        vector<StaticVertex> vertices;
+        for(int axis = 0; axis < 3; axis++)
+            for(int side = 0; side < 2; side++)
+            {
+                int u = (axis + 1) % 3, v = (axis + 2) % 3;
+                glm::vec3 normal(0.0f);
+                normal[axis] = side ? 1.0f : -1.0f;
+                const int quad[6][2] = { { 0, 0 }, { 1, 0 }, { 1, 1 }, { 0, 0 }, { 1, 1 }, { 0, 1 } };
+                for(int k = 0; k < 6; k++)
+                {
+                    // swap the winding on the negative side so every face is counter-clockwise from outside
+                    int a = quad[k][0], b = quad[k][1];
+                    if(!side)
+                        std::swap(a, b);
+                    StaticVertex vertex;
+                    vertex.Position[axis] = corner[side][axis];
+                    vertex.Position[u] = corner[a][u];
+                    vertex.Position[v] = corner[b][v];
+                    vertex.Normal = normal;
+                    vertex.TexCoords = glm::vec2(a, b);
+                    vertex.Tangent = glm::vec4(0.0f, 0.0f, 0.0f, 1.0f);
+                    vertex.Tangent[u] = 1.0f;
+                    vertices.push_back(vertex);
+                }
+            }
+
+        glGenVertexArrays(1, &proxyVAO);
+        glGenBuffers(1, &proxyVBO);
+        glBindVertexArray(proxyVAO);
+        glBindBuffer(GL_ARRAY_BUFFER, proxyVBO);
+        glBufferData(GL_ARRAY_BUFFER, vertices.size() * sizeof(StaticVertex), vertices.data(), GL_STATIC_DRAW);
+        SetupVertexAttributes<StaticVertex>();
+        glBindVertexArray(0);
+        glBindBuffer(GL_ARRAY_BUFFER, 0);
+
+        glGenTextures(1, &proxyTexture);
+        TextureLoader::UploadPlaceholder(proxyTexture);
+    }
+
+    void deleteProxy()
+    {
+        glDeleteVertexArrays(1, &proxyVAO);
+        glDeleteBuffers(1, &proxyVBO);
+        glDeleteTextures(1, &proxyTexture);
+        proxyVAO = proxyVBO = proxyTexture = 0;
     }
 };
 
+inline std::unique_ptr<AsyncModel> Model::LoadAsync(string const &path, bool gamma, bool useCache)
+{
+    return std::unique_ptr<AsyncModel>(new AsyncModel(path, gamma, useCache));
+}
 
 unsigned int TextureFromFile(const char *path, const string &directory, bool gamma)
 {
@@ -215,23 +873,7 @@ unsigned int TextureFromFile(const char *path, const string &directory, bool gam
     unsigned char *data = stbi_load(filename.c_str(), &width, &height, &nrComponents, 0);
     if (data)
     {
-        GLenum format;
-        if (nrComponents == 1)
-            format = GL_RED;
-        else if (nrComponents == 3)
-            format = GL_RGB;
-        else if (nrComponents == 4)
-            format = GL_RGBA;
-
-        glBindTexture(GL_TEXTURE_2D, textureID);
-        glTexImage2D(GL_TEXTURE_2D, 0, format, width, height, 0, format, GL_UNSIGNED_BYTE, data);
-        glGenerateMipmap(GL_TEXTURE_2D);
-
-        glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_S, GL_REPEAT);
-        glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_T, GL_REPEAT);
-        glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MIN_FILTER, GL_LINEAR_MIPMAP_LINEAR);
-        glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MAG_FILTER, GL_LINEAR);
-
+        TextureLoader::Upload(textureID, data, width, height, nrComponents);
         stbi_image_free(data);
     }
     else
@@ -29,7 +29,7 @@ class Model
 public:
     // model data 
     vector<Texture> textures_loaded;	// stores all the textures loaded so far, optimization to make sure textures aren't loaded more than once.
-    vector<Mesh>    meshes;
+    vector<SkinnedMesh> meshes;
     string directory;
     bool gammaCorrection;
 	
@@ -95,7 +95,7 @@ private:
 
     }
 
-	void SetVertexBoneDataToDefault(Vertex& vertex)
+	void SetVertexBoneDataToDefault(SkinnedVertex& vertex)
 	{
 		for (int i = 0; i < MAX_BONE_INFLUENCE; i++)
 		{
@@ -105,15 +105,15 @@ private:
 	}
 
 
-	Mesh processMesh(aiMesh* mesh, const aiScene* scene)
+	SkinnedMesh processMesh(aiMesh* mesh, const aiScene* scene)
 	{
-		vector<Vertex> vertices;
+		vector<SkinnedVertex> vertices;
 		vector<unsigned int> indices;
 		vector<Texture> textures;
 
 		for (unsigned int i = 0; i < mesh->mNumVertices; i++)
 		{
-			Vertex vertex;
+			SkinnedVertex vertex;
 			SetVertexBoneDataToDefault(vertex);
 			vertex.Position = AssimpGLMHelpers::GetGLMVec(mesh->mVertices[i]);
 			vertex.Normal = AssimpGLMHelpers::GetGLMVec(mesh->mNormals[i]);
@@ -149,10 +149,10 @@ private:
 
 		ExtractBoneWeightForVertices(vertices,mesh,scene);
 
-		return Mesh(vertices, indices, textures);
+		return SkinnedMesh(vertices, indices, textures);
 	}
 
-	void SetVertexBoneData(Vertex& vertex, int boneID, float weight)
+	void SetVertexBoneData(SkinnedVertex& vertex, int boneID, float weight)
 	{
 		for (int i = 0; i < MAX_BONE_INFLUENCE; ++i)
 		{
@@ -166,7 +166,7 @@ private:
 	}
 
 
-	void ExtractBoneWeightForVertices(std::vector<Vertex>& vertices, aiMesh* mesh, const aiScene* scene)
+	void ExtractBoneWeightForVertices(std::vector<SkinnedVertex>& vertices, aiMesh* mesh, const aiScene* scene)
 	{
 		auto& boneInfoMap = m_BoneInfoMap;
 		int& boneCount = m_BoneCounter;
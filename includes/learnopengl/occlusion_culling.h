@@ -0,0 +1,362 @@
+#ifndef OCCLUSION_CULLING_H
+#define OCCLUSION_CULLING_H
+
+#include <glm/glm.hpp>
+
+#include <learnopengl/job_system.h>
+#include <learnopengl/simd.h>
+
+#include <algorithm>
+#include <cmath>
+#include <cstdint>
+#include <limits>
+#include <vector>
+
+// software occlusion culling on a small depth buffer. A few large occluders are rasterised on the CPU every frame,
+// then the world boxes of candidate objects are tested against the result before anything is sent to GL.
+// Everything errs towards visible: occluder triangles crossing the near plane or reaching far off screen are
+// dropped, and a box is only hidden when every pixel of its screen rectangle is nearer than the nearest point of the
+// box. Coverage is decided per occluder mesh, not per triangle: the mesh's triangles are sampled at pixel centres
+// into a coverage mask, and a pixel only stores a depth when it and its eight neighbours are covered by the mesh,
+// so the mesh covers all of it. The depth stored is the farthest any of the mesh's triangles touching the pixel
+// reaches inside it. Front and back facing triangles are separate layers, so the back of a closed occluder doesn't
+// push its front back. Each 8x8 tile keeps its farthest depth too, so most tests decide per tile, in the style of
+// masked occlusion culling and hierarchical z.
+// Depth is NDC z of the given view projection, smaller is nearer.
+class OcclusionCuller
+{
+public:
+    static const int TileSize = 8;
+
+    // width and height are rounded up to whole tiles
+    explicit OcclusionCuller(int width = 256, int height = 128)
+        : width((std::max(width, TileSize) + TileSize - 1) / TileSize * TileSize),
+          height((std::max(height, TileSize) + TileSize - 1) / TileSize * TileSize),
+          tilesX(this->width / TileSize), tilesY(this->height / TileSize),
+          depth(static_cast<size_t>(this->width) * this->height, Far), tileMax(static_cast<size_t>(tilesX) * tilesY, Far)
+    {
+    }
+
+    int Width() const { return width; }
+    int Height() const { return height; }
+    const float* Depth() const { return depth.data(); }
+    // occluder triangles that reached the rasteriser this frame
+    size_t TriangleCount() const { return triangles.size(); }
+
+    // starts a frame: drops the previous occluders and clears the depth buffer
+    void Begin(const glm::mat4 &viewProjection)
+    {
+        this->viewProjection = viewProjection;
+        triangles.clear();
+        groups.clear();
+        std::fill(depth.begin(), depth.end(), Far);
+        std::fill(tileMax.begin(), tileMax.end(), Far);
+    }
+
+    // queues the triangles of an indexed mesh placed by world; VertexT needs a glm::vec3 Position
+    template<typename VertexT>
+    void AddOccluder(const std::vector<VertexT> &vertices, const std::vector<unsigned int> &indices, const glm::mat4 &world)
+    {
+        const glm::mat4 transform = viewProjection * world;
+        clip.resize(vertices.size());
+        for (size_t i = 0; i < vertices.size(); i++)
+            clip[i] = transform * glm::vec4(vertices[i].Position, 1.0f);
+        const size_t first = triangles.size();
+        for (size_t i = 0; i + 2 < indices.size(); i += 3)
+            addTriangle(clip[indices[i]], clip[indices[i + 1]], clip[indices[i + 2]]);
+
+        // one group per facing, each covers pixels on its own
+        const auto back = std::stable_partition(triangles.begin() + first, triangles.end(), [](const Triangle &t) { return !t.backFacing; });
+        addGroup(first, static_cast<size_t>(back - triangles.begin()));
+        addGroup(static_cast<size_t>(back - triangles.begin()), triangles.size());
+    }
+
+    // queues every mesh of a model
+    template<typename ModelT>
+    void AddOccluder(const ModelT &model, const glm::mat4 &world)
+    {
+        for (const auto &mesh : model.meshes)
+            AddOccluder(mesh.vertices, mesh.indices, world);
+    }
+
+    // rasterises the queued occluders, one band of tile rows per chunk
+    void Rasterize(JobSystem &jobs)
+    {
+        jobs.ParallelFor(static_cast<size_t>(tilesY), 1, [this](size_t begin, size_t end)
+        {
+            rasterizeBand(static_cast<int>(begin), static_cast<int>(end));
+        });
+    }
+
+    void Rasterize()
+    {
+        rasterizeBand(0, tilesY);
+    }
+
+    // false only when the world space box is certainly hidden behind the rasterised occluders
+    bool IsVisible(const glm::vec3 &min, const glm::vec3 &max) const
+    {
+        float minX = std::numeric_limits<float>::max(), minY = minX, minZ = minX;
+        float maxX = -minX, maxY = -minX;
+        for (int corner = 0; corner < 8; corner++)
+        {
+            const glm::vec3 p(corner & 1 ? max.x : min.x, corner & 2 ? max.y : min.y, corner & 4 ? max.z : min.z);
+            const glm::vec4 c = viewProjection * glm::vec4(p, 1.0f);
+            if (c.w <= NearW)
+                return true; // reaches behind the camera
+            const glm::vec3 s = toScreen(c);
+            minX = std::min(minX, s.x); maxX = std::max(maxX, s.x);
+            minY = std::min(minY, s.y); maxY = std::max(maxY, s.y);
+            minZ = std::min(minZ, s.z);
+        }
+        // every pixel the rectangle overlaps
+        if (maxX < 0.0f || maxY < 0.0f || minX >= width || minY >= height)
+            return true; // off screen, frustum culling decides
+        const int x0 = static_cast<int>(std::max(minX, 0.0f)), x1 = static_cast<int>(std::min(maxX, width - 1.0f));
+        const int y0 = static_cast<int>(std::max(minY, 0.0f)), y1 = static_cast<int>(std::min(maxY, height - 1.0f));
+        for (int ty = y0 / TileSize; ty <= y1 / TileSize; ty++)
+        {
+            for (int tx = x0 / TileSize; tx <= x1 / TileSize; tx++)
+            {
+                if (tileMax[ty * tilesX + tx] <= minZ)
+                    continue; // the whole tile is in front of the box
+                const int px0 = std::max(x0, tx * TileSize), px1 = std::min(x1, tx * TileSize + TileSize - 1);
+                const int py0 = std::max(y0, ty * TileSize), py1 = std::min(y1, ty * TileSize + TileSize - 1);
+                for (int y = py0; y <= py1; y++)
+                {
+                    const float *row = &depth[static_cast<size_t>(y) * width];
+                    for (int x = px0; x <= px1; x++)
+                        if (row[x] > minZ)
+                            return true;
+                }
+            }
+        }
+        return false;
+    }
+
+private:
+    static constexpr float Far = std::numeric_limits<float>::max();
+    // clip w below which a point counts as on or behind the camera
+    static constexpr float NearW = 1e-5f;
+    // how many buffer sizes an occluder triangle may reach past the edges
+    static constexpr float GuardBand = 16.0f;
+
+    // screen space triangle as edge functions over pixel centres and a depth plane, all relative to pixel (0, 0)
+    struct Triangle
+    {
+        float edgeA[3], edgeB[3], edgeC[3]; // the centre of pixel (x, y) is inside edge i where A * x + B * y + C >= 0
+        float edgeReach[3];                 // the most edge i changes between a pixel's centre and its corners
+        float depth0, depthX, depthY;      // farthest depth within pixel (x, y) = depth0 + depthX * x + depthY * y
+        float depthMax;                    // farthest depth of the whole triangle
+        int minX, maxX, minY, maxY;         // pixels the triangle touches, clamped to the buffer plus one pixel around it
+        bool backFacing;
+    };
+
+    // the triangles [first, end) of one occluder mesh and facing, with the pixels they touch
+    struct Group
+    {
+        size_t first, end;
+        int minX, maxX, minY, maxY;
+    };
+
+    // per band: the coverage and farthest depth of the group being rasterised, for the band's rows plus one above
+    // and below, and the columns of the buffer plus one either side and padding for the last four pixel step
+    struct Scratch
+    {
+        int firstRow, stride;
+        std::vector<uint8_t> covered;
+        std::vector<float> farthest;
+
+        size_t index(int x, int y) const { return static_cast<size_t>(y - firstRow) * stride + (x + 1); }
+    };
+
+    int width, height, tilesX, tilesY;
+    glm::mat4 viewProjection = glm::mat4(1.0f);
+    std::vector<float> depth;
+    std::vector<float> tileMax;
+    std::vector<Triangle> triangles;
+    std::vector<Group> groups;
+    std::vector<glm::vec4> clip; // scratch of AddOccluder()
+
+    // x and y in pixels with y down the rows, z in NDC
+    glm::vec3 toScreen(const glm::vec4 &c) const
+    {
+        const float invW = 1.0f / c.w;
+        return glm::vec3((c.x * invW * 0.5f + 0.5f) * width, (0.5f - c.y * invW * 0.5f) * height, c.z * invW);
+    }
+
+    void addTriangle(const glm::vec4 &c0, const glm::vec4 &c1, const glm::vec4 &c2)
+    {
+        if (c0.w <= NearW || c1.w <= NearW || c2.w <= NearW)
+            return; // would need clipping, an occluder can simply do without it
+        glm::vec3 v[3] = { toScreen(c0), toScreen(c1), toScreen(c2) };
+        float area = (v[1].x - v[0].x) * (v[2].y - v[0].y) - (v[2].x - v[0].x) * (v[1].y - v[0].y);
+        if (!(std::abs(area) > 1e-8f))
+            return;
+        Triangle t;
+        t.backFacing = area < 0.0f;
+        if (t.backFacing)
+        {
+            // both windings occlude, make the edge functions positive inside
+            std::swap(v[1], v[2]);
+            area = -area;
+        }
+
+        const float minX = std::min({ v[0].x, v[1].x, v[2].x }), maxX = std::max({ v[0].x, v[1].x, v[2].x });
+        const float minY = std::min({ v[0].y, v[1].y, v[2].y }), maxY = std::max({ v[0].y, v[1].y, v[2].y });
+        if (maxX < -1.0f || maxY < -1.0f || minX >= width + 1.0f || minY >= height + 1.0f)
+            return;
+        // far outside the buffer the edge functions lose too much precision, such triangles would need clipping too
+        const float guardX = GuardBand * width, guardY = GuardBand * height;
+        if (minX < -guardX || maxX > width + guardX || minY < -guardY || maxY > height + guardY)
+            return;
+        // the mask reaches one pixel past the buffer, so the pixels along its edges can be fully covered too
+        t.minX = static_cast<int>(std::floor(std::max(minX, -1.0f)));
+        t.maxX = static_cast<int>(std::min(maxX, static_cast<float>(width)));
+        t.minY = static_cast<int>(std::floor(std::max(minY, -1.0f)));
+        t.maxY = static_cast<int>(std::min(maxY, static_cast<float>(height)));
+        // a triangle entirely beyond the far plane hides nothing inside the frustum
+        if (std::min({ v[0].z, v[1].z, v[2].z }) > 1.0f)
+            return;
+
+        for (int e = 0; e < 3; e++)
+        {
+            const glm::vec3 &a = v[e], &b = v[(e + 1) % 3];
+            // evaluated at pixel centres, hence the half pixel folded into C. Two triangles sharing an edge get
+            // exactly opposite functions for it, so no centre on the edge is missed by both.
+            t.edgeA[e] = a.y - b.y;
+            t.edgeB[e] = b.x - a.x;
+            t.edgeC[e] = a.x * b.y - a.y * b.x + 0.5f * (t.edgeA[e] + t.edgeB[e]);
+            t.edgeReach[e] = 0.5f * (std::abs(t.edgeA[e]) + std::abs(t.edgeB[e]));
+        }
+        // depth plane through the three vertices
+        const float dx1 = v[1].x - v[0].x, dy1 = v[1].y - v[0].y, dz1 = v[1].z - v[0].z;
+        const float dx2 = v[2].x - v[0].x, dy2 = v[2].y - v[0].y, dz2 = v[2].z - v[0].z;
+        t.depthX = (dz1 * dy2 - dz2 * dy1) / area;
+        t.depthY = (dx1 * dz2 - dx2 * dz1) / area;
+        // at pixel centres, pushed back by the most the plane recedes within half a pixel
+        t.depth0 = v[0].z - t.depthX * (v[0].x - 0.5f) - t.depthY * (v[0].y - 0.5f) + 0.5f * (std::abs(t.depthX) + std::abs(t.depthY));
+        t.depthMax = std::max({ v[0].z, v[1].z, v[2].z });
+        triangles.push_back(t);
+    }
+
+    void addGroup(size_t first, size_t end)
+    {
+        if (first == end)
+            return;
+        Group g{ first, end, width, -1, height, -1 };
+        for (size_t i = first; i < end; i++)
+        {
+            g.minX = std::min(g.minX, triangles[i].minX); g.maxX = std::max(g.maxX, triangles[i].maxX);
+            g.minY = std::min(g.minY, triangles[i].minY); g.maxY = std::max(g.maxY, triangles[i].maxY);
+        }
+        groups.push_back(g);
+    }
+
+    // rasterises the part of every group inside tile rows [tileBegin, tileEnd), then updates their tile maxima.
+    // bands do not overlap, so they can run on several threads at once.
+    void rasterizeBand(int tileBegin, int tileEnd)
+    {
+        const int rowBegin = tileBegin * TileSize, rowEnd = tileEnd * TileSize;
+        Scratch scratch;
+        scratch.firstRow = rowBegin - 1;
+        scratch.stride = width + 8;
+        scratch.covered.resize(static_cast<size_t>(rowEnd - rowBegin + 2) * scratch.stride);
+        scratch.farthest.resize(scratch.covered.size());
+        for (const Group &g : groups)
+        {
+            const int y0 = std::max(g.minY, rowBegin - 1), y1 = std::min(g.maxY, rowEnd);
+            if (y0 > y1)
+                continue;
+            for (int y = y0; y <= y1; y++)
+            {
+                const size_t row = scratch.index(g.minX, y);
+                std::fill_n(&scratch.covered[row], g.maxX - g.minX + 1, uint8_t(0));
+                std::fill_n(&scratch.farthest[row], g.maxX - g.minX + 1, -Far);
+            }
+            for (size_t i = g.first; i < g.end; i++)
+            {
+                const Triangle &t = triangles[i];
+                for (int y = std::max(t.minY, y0); y <= std::min(t.maxY, y1); y++)
+                    rasterizeRow(t, y, scratch);
+            }
+            // a pixel is fully covered when the centres around it are: pixels on the group's bounds never are, and
+            // the mask is only valid inside them
+            for (int y = std::max(y0 + 1, rowBegin); y <= std::min(y1 - 1, rowEnd - 1); y++)
+            {
+                float *out = &depth[static_cast<size_t>(y) * width];
+                const uint8_t *above = &scratch.covered[scratch.index(0, y - 1)];
+                const uint8_t *here = &scratch.covered[scratch.index(0, y)];
+                const uint8_t *below = &scratch.covered[scratch.index(0, y + 1)];
+                const float *farthest = &scratch.farthest[scratch.index(0, y)];
+                for (int x = std::max(g.minX + 1, 0); x <= std::min(g.maxX - 1, width - 1); x++)
+                {
+                    if (above[x - 1] & above[x] & above[x + 1] & here[x - 1] & here[x] & here[x + 1] & below[x - 1] & below[x] & below[x + 1])
+                        out[x] = std::min(out[x], farthest[x]);
+                }
+            }
+        }
+        for (int ty = tileBegin; ty < tileEnd; ty++)
+        {
+            for (int tx = 0; tx < tilesX; tx++)
+            {
+                float farthest = -Far;
+                for (int y = ty * TileSize; y < (ty + 1) * TileSize; y++)
+                {
+                    const float *row = &depth[static_cast<size_t>(y) * width + tx * TileSize];
+                    for (int x = 0; x < TileSize; x++)
+                        farthest = std::max(farthest, row[x]);
+                }
+                tileMax[ty * tilesX + tx] = farthest;
+            }
+        }
+    }
+
+    // marks the pixel centres of row y the triangle covers, and raises the farthest depth of every pixel it touches
+    void rasterizeRow(const Triangle &t, int y, Scratch &scratch)
+    {
+        uint8_t *covered = &scratch.covered[scratch.index(0, y)];
+        float *farthest = &scratch.farthest[scratch.index(0, y)];
+        const float fy = static_cast<float>(y);
+        const float row0 = t.edgeB[0] * fy + t.edgeC[0], row1 = t.edgeB[1] * fy + t.edgeC[1], row2 = t.edgeB[2] * fy + t.edgeC[2];
+        const float rowDepth = t.depth0 + t.depthY * fy;
+        int x = t.minX;
+#ifdef LOGL_SSE2
+        // four pixels per step; the scratch rows are padded, so the last step stays inside them
+        const __m128 a0 = _mm_set1_ps(t.edgeA[0]), a1 = _mm_set1_ps(t.edgeA[1]), a2 = _mm_set1_ps(t.edgeA[2]);
+        const __m128 r0 = _mm_set1_ps(row0), r1 = _mm_set1_ps(row1), r2 = _mm_set1_ps(row2);
+        const __m128 m0 = _mm_set1_ps(-t.edgeReach[0]), m1 = _mm_set1_ps(-t.edgeReach[1]), m2 = _mm_set1_ps(-t.edgeReach[2]);
+        const __m128 dx = _mm_set1_ps(t.depthX), rd = _mm_set1_ps(rowDepth), top = _mm_set1_ps(t.depthMax);
+        const __m128 zero = _mm_setzero_ps(), lastX = _mm_set1_ps(static_cast<float>(t.maxX));
+        for (; x <= t.maxX; x += 4)
+        {
+            const __m128 xs = _mm_add_ps(_mm_set1_ps(static_cast<float>(x)), _mm_setr_ps(0.0f, 1.0f, 2.0f, 3.0f));
+            const __m128 e0 = _mm_add_ps(_mm_mul_ps(a0, xs), r0);
+            const __m128 e1 = _mm_add_ps(_mm_mul_ps(a1, xs), r1);
+            const __m128 e2 = _mm_add_ps(_mm_mul_ps(a2, xs), r2);
+            const __m128 valid = _mm_cmple_ps(xs, lastX);
+            const __m128 touched = _mm_and_ps(valid, _mm_and_ps(_mm_cmpge_ps(e0, m0), _mm_and_ps(_mm_cmpge_ps(e1, m1), _mm_cmpge_ps(e2, m2))));
+            if (_mm_movemask_ps(touched) == 0)
+                continue;
+            const __m128 z = _mm_min_ps(_mm_add_ps(_mm_mul_ps(dx, xs), rd), top);
+            const __m128 old = _mm_loadu_ps(farthest + x);
+            _mm_storeu_ps(farthest + x, _mm_or_ps(_mm_and_ps(touched, _mm_max_ps(old, z)), _mm_andnot_ps(touched, old)));
+            const int inside = _mm_movemask_ps(_mm_and_ps(valid, _mm_and_ps(_mm_cmpge_ps(e0, zero), _mm_and_ps(_mm_cmpge_ps(e1, zero), _mm_cmpge_ps(e2, zero)))));
+            for (int lane = 0; lane < 4; lane++)
+                covered[x + lane] |= (inside >> lane) & 1;
+        }
+#else
+        for (; x <= t.maxX; x++)
+        {
+            const float fx = static_cast<float>(x);
+            const float e0 = t.edgeA[0] * fx + row0, e1 = t.edgeA[1] * fx + row1, e2 = t.edgeA[2] * fx + row2;
+            if (e0 < -t.edgeReach[0] || e1 < -t.edgeReach[1] || e2 < -t.edgeReach[2])
+                continue;
+            farthest[x] = std::max(farthest[x], std::min(t.depthX * fx + rowDepth, t.depthMax));
+            if (e0 >= 0.0f && e1 >= 0.0f && e2 >= 0.0f)
+                covered[x] = 1;
+        }
+#endif
+    }
+};
+#endif
@@ -0,0 +1,335 @@
+#ifndef RENDER_QUEUE_H
+#define RENDER_QUEUE_H
+
+#include <glad/glad.h>
+#include <glm/glm.hpp>
+
+#include <learnopengl/mesh.h>
+#include <learnopengl/shader.h>
+
+#include <algorithm>
+#include <chrono>
+#include <cstdint>
+#include <vector>
+
+// what the last RenderQueue::Submit() did
+struct RenderQueueStats
+{
+    unsigned int draws = 0;
+    unsigned int instancedDraws = 0; // of draws, the ones that drew several entries at once
+    unsigned int instances = 0;      // entries drawn by instancedDraws
+    unsigned int programBinds = 0;
+    unsigned int materialBinds = 0;
+    unsigned int vertexArrayBinds = 0;
+    double sortMicroseconds = 0.0;
+    double submitMicroseconds = 0.0;
+};
+
+// collects the draws of a frame instead of issuing them during traversal. Every draw gets a 64-bit key, from the
+// most significant bit: pass (4 bits), program (12), material (16), vertex array (16), quantised depth (16).
+// Sort() orders the keys with an LSD radix sort and Submit() walks them, binding a program, material or vertex
+// array only when it differs from the one of the previous draw. Key fields are folded ids, so two different
+// materials can share a field value; Submit() compares the real state and stays correct, only the grouping suffers.
+// Draws in the same pass and state are ordered front to back, from TransparentPass on back to front.
+//
+// Consecutive draws of the same mesh, lod and program collapse into one instanced draw when the program declares
+// a bool uniform "instanced" and reads its model matrix from a mat4 attribute at InstanceMatrixLocation while it is
+// set. Their matrices go into a buffer filled once per Submit(). For such programs the depth field of opaque passes
+// holds a folded mesh id instead, so all draws of one mesh sort next to each other; transparent passes keep their
+// back to front order and are never instanced.
+class RenderQueue
+{
+public:
+    static const unsigned int TransparentPass = 8;
+    static const GLuint InstanceMatrixLocation = 8; // takes four locations, one per column
+
+    // deletes the instance buffer; call while the GL context is current. The destructor doesn't touch GL, the queue
+    // may outlive the context.
+    void Release()
+    {
+        if (instanceBuffer != 0)
+            glDeleteBuffers(1, &instanceBuffer);
+        instanceBuffer = 0;
+        instanceCapacity = 0;
+    }
+
+    RenderQueueStats stats;
+
+    // starts a frame; depth is the distance to cameraPosition over farPlane
+    void Begin(const glm::vec3 &cameraPosition, float farPlane)
+    {
+        this->cameraPosition = cameraPosition;
+        inverseFar = farPlane > 0.0f ? 1.0f / farPlane : 0.0f;
+        items.clear();
+        keys.clear();
+    }
+
+    void Push(unsigned int pass, Shader &shader, Mesh &mesh, const glm::mat4 &model, unsigned int lod = 0)
+    {
+        const bool instanced = pass < TransparentPass && shader.uniforms.Location("instanced") >= 0;
+        float depth = glm::length(glm::vec3(model[3]) - cameraPosition) * inverseFar;
+        if (pass >= TransparentPass)
+            depth = 1.0f - depth;
+        if (instanced)
+            depth = meshId(mesh) / 65535.0f;
+        keys.push_back(MakeKey(pass, shader.ID, materialId(mesh), mesh.VAO, depth));
+        items.push_back(Item{ &shader, &mesh, model, lod, instanced });
+    }
+
+    // every mesh of a model
+    template<typename ModelT>
+    void Push(unsigned int pass, Shader &shader, ModelT &model, const glm::mat4 &matrix, unsigned int lod = 0)
+    {
+        for (Mesh &mesh : model.meshes)
+            Push(pass, shader, mesh, matrix, lod);
+    }
+
+    size_t Size() const { return items.size(); }
+
+    static uint64_t MakeKey(unsigned int pass, unsigned int program, unsigned int material, unsigned int vertexArray, float depth)
+    {
+        const uint64_t quantised = static_cast<uint64_t>(std::min(std::max(depth, 0.0f), 1.0f) * 65535.0f);
+        return (static_cast<uint64_t>(pass & 0xfu) << 60) | (static_cast<uint64_t>(program & 0xfffu) << 48) |
+               (static_cast<uint64_t>(material & 0xffffu) << 32) | (static_cast<uint64_t>(vertexArray & 0xffffu) << 16) | quantised;
+    }
+
+    // least significant byte first, one counting pass per byte. The histograms of all eight bytes are built in a
+    // single read of the keys, and bytes that are the same for every key are skipped.
+    void Sort()
+    {
+        const auto start = std::chrono::steady_clock::now();
+        const size_t count = keys.size();
+        order.resize(count);
+        for (size_t i = 0; i < count; i++)
+            order[i] = static_cast<uint32_t>(i);
+        sortedKeys.resize(count);
+        sortedOrder.resize(count);
+
+        size_t histogram[8][256] = {};
+        for (uint64_t key : keys)
+            for (int digit = 0; digit < 8; digit++)
+                histogram[digit][(key >> (digit * 8)) & 0xff]++;
+
+        for (int digit = 0; digit < 8; digit++)
+        {
+            size_t *buckets = histogram[digit];
+            if (count == 0 || buckets[(keys[0] >> (digit * 8)) & 0xff] == count)
+                continue;
+            size_t offset = 0;
+            for (int b = 0; b < 256; b++)
+            {
+                const size_t size = buckets[b];
+                buckets[b] = offset;
+                offset += size;
+            }
+            for (size_t i = 0; i < count; i++)
+            {
+                const size_t to = buckets[(keys[i] >> (digit * 8)) & 0xff]++;
+                sortedKeys[to] = keys[i];
+                sortedOrder[to] = order[i];
+            }
+            keys.swap(sortedKeys);
+            order.swap(sortedOrder);
+        }
+        stats.sortMicroseconds = std::chrono::duration<double, std::micro>(std::chrono::steady_clock::now() - start).count();
+    }
+
+    // issues the draws in key order; call Sort() first. Leaves the last program in use.
+    void Submit()
+    {
+        const auto start = std::chrono::steady_clock::now();
+        stats.draws = stats.instancedDraws = stats.instances = 0;
+        stats.programBinds = stats.materialBinds = stats.vertexArrayBinds = 0;
+        gatherRuns();
+        uploadInstances();
+
+        Shader *program = nullptr;
+        Mesh *material = nullptr;
+        unsigned int vertexArray = 0;
+        bool instancing = false;
+        for (const Run &run : runs)
+        {
+            Item &item = items[order[run.first]];
+            if (item.shader != program)
+            {
+                if (instancing)
+                    program->setBool("instanced", false); // leave every program drawing from "model"
+                program = item.shader;
+                program->use();
+                material = nullptr; // sampler uniforms belong to the program
+                instancing = false;
+                stats.programBinds++;
+            }
+            if (material == nullptr || !sameMaterial(*material, *item.mesh))
+            {
+                material = item.mesh;
+                material->BindMaterial(*program);
+                stats.materialBinds++;
+            }
+            if (item.mesh->VAO != vertexArray)
+            {
+                vertexArray = item.mesh->VAO;
+                glBindVertexArray(vertexArray);
+                stats.vertexArrayBinds++;
+            }
+            const GLsizei count = static_cast<GLsizei>(run.count);
+            if (run.firstInstance >= 0)
+            {
+                if (!instancing)
+                {
+                    program->setBool("instanced", true);
+                    instancing = true;
+                }
+                pointInstanceMatrix(static_cast<size_t>(run.firstInstance));
+                item.mesh->DrawElementsInstanced(count, item.lod);
+                clearInstanceMatrix();
+                stats.instancedDraws++;
+                stats.instances += run.count;
+                stats.draws++;
+                continue;
+            }
+            if (instancing)
+            {
+                program->setBool("instanced", false);
+                instancing = false;
+            }
+            for (uint32_t i = run.first; i < run.first + run.count; i++)
+            {
+                program->setMat4("model", items[order[i]].model);
+                item.mesh->DrawElements(item.lod);
+                stats.draws++;
+            }
+        }
+        if (instancing)
+            program->setBool("instanced", false);
+        glBindVertexArray(0);
+        glActiveTexture(GL_TEXTURE0);
+        stats.submitMicroseconds = std::chrono::duration<double, std::micro>(std::chrono::steady_clock::now() - start).count();
+    }
+
+private:
+    struct Item
+    {
+        Shader *shader;
+        Mesh *mesh;
+        glm::mat4 model;
+        unsigned int lod;
+        bool instanced; // the program can draw it instanced
+    };
+
+    // order[first, first + count) share program, mesh and lod; firstInstance is their offset in the instance
+    // buffer, -1 when they are drawn one by one
+    struct Run
+    {
+        uint32_t first;
+        uint32_t count;
+        long long firstInstance;
+    };
+
+    glm::vec3 cameraPosition = glm::vec3(0.0f);
+    float inverseFar = 0.0f;
+    std::vector<Item> items;
+    std::vector<uint64_t> keys, sortedKeys;
+    std::vector<uint32_t> order, sortedOrder; // item index of each key
+    std::vector<Run> runs;
+    std::vector<glm::mat4> instanceMatrices;
+    unsigned int instanceBuffer = 0;
+    size_t instanceCapacity = 0; // in matrices
+
+    void gatherRuns()
+    {
+        runs.clear();
+        instanceMatrices.clear();
+        for (uint32_t first = 0; first < order.size(); )
+        {
+            const Item &item = items[order[first]];
+            uint32_t last = first + 1;
+            while (last < order.size())
+            {
+                const Item &next = items[order[last]];
+                if (next.shader != item.shader || next.mesh != item.mesh || next.lod != item.lod || next.instanced != item.instanced)
+                    break;
+                last++;
+            }
+            Run run{ first, last - first, -1 };
+            if (item.instanced && run.count > 1)
+            {
+                run.firstInstance = static_cast<long long>(instanceMatrices.size());
+                for (uint32_t i = first; i < last; i++)
+                    instanceMatrices.push_back(items[order[i]].model);
+            }
+            runs.push_back(run);
+            first = last;
+        }
+    }
+
+    // the whole frame in one upload; the buffer is orphaned so the driver never waits on last frame's draws
+    void uploadInstances()
+    {
+        if (instanceMatrices.empty())
+            return;
+        if (instanceBuffer == 0)
+            glGenBuffers(1, &instanceBuffer);
+        glBindBuffer(GL_ARRAY_BUFFER, instanceBuffer);
+        if (instanceMatrices.size() > instanceCapacity)
+            instanceCapacity = std::max(instanceMatrices.size(), instanceCapacity * 2);
+        glBufferData(GL_ARRAY_BUFFER, instanceCapacity * sizeof(glm::mat4), nullptr, GL_STREAM_DRAW);
+        glBufferSubData(GL_ARRAY_BUFFER, 0, instanceMatrices.size() * sizeof(glm::mat4), instanceMatrices.data());
+    }
+
+    // points the instance matrix of the bound VAO at one run of the instance buffer, as 10.3.asteroids_instanced
+    // does. Only for the one draw: clearInstanceMatrix() undoes it right after.
+    void pointInstanceMatrix(size_t firstInstance)
+    {
+        glBindBuffer(GL_ARRAY_BUFFER, instanceBuffer);
+        for (GLuint column = 0; column < 4; column++)
+        {
+            const GLuint location = InstanceMatrixLocation + column;
+            glEnableVertexAttribArray(location);
+            glVertexAttribPointer(location, 4, GL_FLOAT, GL_FALSE, sizeof(glm::mat4),
+                                  (void*)(firstInstance * sizeof(glm::mat4) + column * sizeof(glm::vec4)));
+            glVertexAttribDivisor(location, 1);
+        }
+    }
+
+    // disables the instance matrix attributes of the bound VAO again and resets their divisors. The VAO may be the
+    // one a MeshArena shares between all its meshes, which must be left with exactly its own attributes.
+    void clearInstanceMatrix()
+    {
+        for (GLuint column = 0; column < 4; column++)
+        {
+            const GLuint location = InstanceMatrixLocation + column;
+            glDisableVertexAttribArray(location);
+            glVertexAttribDivisor(location, 0);
+        }
+    }
+
+    // folds the identity of a mesh into the 16 bit depth field; meshes sharing a value only sort less well
+    static unsigned int meshId(const Mesh &mesh)
+    {
+        const uintptr_t address = reinterpret_cast<uintptr_t>(&mesh) / sizeof(void*);
+        return static_cast<unsigned int>((address ^ (address >> 16) ^ (address >> 32)) & 0xffffu);
+    }
+
+    // meshes binding the same textures share a material
+    static unsigned int materialId(const Mesh &mesh)
+    {
+        unsigned int id = 0;
+        for (const Texture &texture : mesh.textures)
+            id = id * 31u + texture.id;
+        return id;
+    }
+
+    static bool sameMaterial(const Mesh &a, const Mesh &b)
+    {
+        if (&a == &b)
+            return true;
+        if (a.textures.size() != b.textures.size())
+            return false;
+        for (size_t i = 0; i < a.textures.size(); i++)
+            if (a.textures[i].id != b.textures[i].id || a.textures[i].type != b.textures[i].type)
+                return false;
+        return true;
+    }
+};
+#endif
@@ -0,0 +1,215 @@
+#ifndef SCENE_FILE_H
+#define SCENE_FILE_H
+
+#include <glm/glm.hpp>
+#include <glm/gtc/quaternion.hpp>
+
+#include <learnopengl/bounds.h>
+#include <learnopengl/mapped_file.h>
+#include <learnopengl/transform_hierarchy.h>
+
+#include <cstdint>
+#include <cstdio>
+#include <cstring>
+#include <fstream>
+#include <string>
+#include <vector>
+
+// on-disk layout of a .scene file (native endianness, every array 16 byte aligned):
+// SceneFileHeader | parents | positions | orientations | rotations | scales | models | bounds | SceneFileString[modelCount] | string table
+// the node arrays are those of a TransformHierarchy, parent before child, so loading copies them as they are.
+struct SceneFileHeader
+{
+    char     magic[8];
+    uint32_t version;
+    uint32_t nodeCount;
+    uint32_t modelCount;
+    uint32_t stringsSize;
+    uint64_t parentsOffset;      // uint32_t per node, TransformHierarchy::None for roots
+    uint64_t positionsOffset;    // glm::vec3 per node
+    uint64_t orientationsOffset; // glm::quat per node
+    uint64_t rotationsOffset;    // glm::vec3 per node, the euler angles of the orientation
+    uint64_t scalesOffset;       // glm::vec3 per node
+    uint64_t modelsOffset;       // uint32_t per node, index into the model paths
+    uint64_t boundsOffset;       // BoundingBox per node, in the space of its model
+    uint64_t modelPathsOffset;
+    uint64_t stringsOffset;
+    uint64_t fileSize;
+};
+
+struct SceneFileString
+{
+    uint32_t offset; // into the string table
+    uint32_t length;
+};
+
+// a flattened entity hierarchy mapped straight from disk. open() only validates the header and the parent indices;
+// the arrays are read in place, and TransformHierarchy::Assign() takes them over with one copy per array.
+class SceneFile
+{
+public:
+    static const uint32_t Version = 1;
+
+    static_assert(sizeof(glm::vec3) == 12 && sizeof(glm::quat) == 16 && sizeof(BoundingBox) == 24, "scene files store glm types as they are laid out in memory");
+
+    bool open(const std::string &path)
+    {
+        if (!file.open(path))
+            return false;
+        if (file.size() < sizeof(SceneFileHeader))
+            return invalidate();
+
+        std::memcpy(&header, file.data(), sizeof(SceneFileHeader));
+        const uint64_t nodes = header.nodeCount;
+        if (std::memcmp(header.magic, Magic(), sizeof(header.magic)) != 0 ||
+            header.version != Version ||
+            header.fileSize != file.size() ||
+            !fits(header.parentsOffset, nodes * sizeof(uint32_t)) ||
+            !fits(header.positionsOffset, nodes * sizeof(glm::vec3)) ||
+            !fits(header.orientationsOffset, nodes * sizeof(glm::quat)) ||
+            !fits(header.rotationsOffset, nodes * sizeof(glm::vec3)) ||
+            !fits(header.scalesOffset, nodes * sizeof(glm::vec3)) ||
+            !fits(header.modelsOffset, nodes * sizeof(uint32_t)) ||
+            !fits(header.boundsOffset, nodes * sizeof(BoundingBox)) ||
+            !fits(header.modelPathsOffset, uint64_t(header.modelCount) * sizeof(SceneFileString)) ||
+            !fits(header.stringsOffset, header.stringsSize))
+            return invalidate();
+
+        parentData = reinterpret_cast<const uint32_t*>(file.data() + header.parentsOffset);
+        positionData = reinterpret_cast<const glm::vec3*>(file.data() + header.positionsOffset);
+        orientationData = reinterpret_cast<const glm::quat*>(file.data() + header.orientationsOffset);
+        rotationData = reinterpret_cast<const glm::vec3*>(file.data() + header.rotationsOffset);
+        scaleData = reinterpret_cast<const glm::vec3*>(file.data() + header.scalesOffset);
+        modelData = reinterpret_cast<const uint32_t*>(file.data() + header.modelsOffset);
+        boundsData = reinterpret_cast<const BoundingBox*>(file.data() + header.boundsOffset);
+        modelPaths = reinterpret_cast<const SceneFileString*>(file.data() + header.modelPathsOffset);
+        strings = reinterpret_cast<const char*>(file.data() + header.stringsOffset);
+
+        // anything that would break the parent before child order or index out of bounds is rejected here
+        for (uint32_t i = 0; i < header.nodeCount; i++)
+        {
+            if ((parentData[i] != TransformHierarchy::None && parentData[i] >= i) || modelData[i] >= header.modelCount)
+                return invalidate();
+        }
+        for (uint32_t i = 0; i < header.modelCount; i++)
+        {
+            if (uint64_t(modelPaths[i].offset) + modelPaths[i].length > header.stringsSize)
+                return invalidate();
+        }
+        return true;
+    }
+
+    uint32_t nodeCount() const { return header.nodeCount; }
+    uint32_t modelCount() const { return header.modelCount; }
+    const uint32_t* parents() const { return parentData; }
+    const glm::vec3* positions() const { return positionData; }
+    const glm::quat* orientations() const { return orientationData; }
+    const glm::vec3* rotations() const { return rotationData; }
+    const glm::vec3* scales() const { return scaleData; }
+    const uint32_t* models() const { return modelData; }
+    const BoundingBox* bounds() const { return boundsData; }
+    std::string modelPath(uint32_t m) const { return std::string(strings + modelPaths[m].offset, modelPaths[m].length); }
+
+    // takes over the transforms of every node
+    void assignTo(TransformHierarchy &hierarchy) const
+    {
+        hierarchy.Assign(header.nodeCount, parentData, positionData, orientationData, rotationData, scaleData);
+    }
+
+    // writes every node of hierarchy with the model index and model space box of each. Written to a temporary
+    // file first so a concurrent reader never sees a half written scene.
+    static bool Write(const std::string &path, const TransformHierarchy &hierarchy, const std::vector<uint32_t> &models,
+                      const std::vector<BoundingBox> &bounds, const std::vector<std::string> &modelPathList)
+    {
+        const uint64_t nodes = hierarchy.Size();
+        if (models.size() != nodes || bounds.size() != nodes)
+            return false;
+
+        std::vector<SceneFileString> paths;
+        std::string table;
+        for (const std::string &modelPath : modelPathList)
+        {
+            paths.push_back(SceneFileString{ static_cast<uint32_t>(table.size()), static_cast<uint32_t>(modelPath.size()) });
+            table += modelPath;
+        }
+
+        SceneFileHeader header;
+        std::memset(&header, 0, sizeof(header));
+        std::memcpy(header.magic, Magic(), sizeof(header.magic));
+        header.version = Version;
+        header.nodeCount = static_cast<uint32_t>(nodes);
+        header.modelCount = static_cast<uint32_t>(paths.size());
+        header.stringsSize = static_cast<uint32_t>(table.size());
+        header.parentsOffset = Align(sizeof(SceneFileHeader));
+        header.positionsOffset = Align(header.parentsOffset + nodes * sizeof(uint32_t));
+        header.orientationsOffset = Align(header.positionsOffset + nodes * sizeof(glm::vec3));
+        header.rotationsOffset = Align(header.orientationsOffset + nodes * sizeof(glm::quat));
+        header.scalesOffset = Align(header.rotationsOffset + nodes * sizeof(glm::vec3));
+        header.modelsOffset = Align(header.scalesOffset + nodes * sizeof(glm::vec3));
+        header.boundsOffset = Align(header.modelsOffset + nodes * sizeof(uint32_t));
+        header.modelPathsOffset = Align(header.boundsOffset + nodes * sizeof(BoundingBox));
+        header.stringsOffset = Align(header.modelPathsOffset + paths.size() * sizeof(SceneFileString));
+        header.fileSize = header.stringsOffset + table.size();
+
+        const std::string tempPath = TemporaryPath(path);
+        {
+            std::ofstream out(tempPath, std::ios::binary | std::ios::trunc);
+            if (!out)
+                return false;
+            WriteAt(out, 0, &header, sizeof(header));
+            WriteAt(out, header.parentsOffset, hierarchy.parent.data(), nodes * sizeof(uint32_t));
+            WriteAt(out, header.positionsOffset, hierarchy.localPosition.data(), nodes * sizeof(glm::vec3));
+            WriteAt(out, header.orientationsOffset, hierarchy.localOrientation.data(), nodes * sizeof(glm::quat));
+            WriteAt(out, header.rotationsOffset, hierarchy.localRotation.data(), nodes * sizeof(glm::vec3));
+            WriteAt(out, header.scalesOffset, hierarchy.localScale.data(), nodes * sizeof(glm::vec3));
+            WriteAt(out, header.modelsOffset, models.data(), nodes * sizeof(uint32_t));
+            WriteAt(out, header.boundsOffset, bounds.data(), nodes * sizeof(BoundingBox));
+            WriteAt(out, header.modelPathsOffset, paths.data(), paths.size() * sizeof(SceneFileString));
+            WriteAt(out, header.stringsOffset, table.data(), table.size());
+            if (!out)
+            {
+                out.close();
+                std::remove(tempPath.c_str());
+                return false;
+            }
+        }
+        return RenameReplacing(tempPath, path);
+    }
+
+private:
+    MappedFile file;
+    SceneFileHeader header = {};
+    const uint32_t* parentData = nullptr;
+    const glm::vec3* positionData = nullptr;
+    const glm::quat* orientationData = nullptr;
+    const glm::vec3* rotationData = nullptr;
+    const glm::vec3* scaleData = nullptr;
+    const uint32_t* modelData = nullptr;
+    const BoundingBox* boundsData = nullptr;
+    const SceneFileString* modelPaths = nullptr;
+    const char* strings = nullptr;
+
+    static const char* Magic() { return "LOGLSCN"; }
+
+    static uint64_t Align(uint64_t offset) { return (offset + 15) & ~uint64_t(15); }
+
+    bool fits(uint64_t offset, uint64_t size) const
+    {
+        return offset >= sizeof(SceneFileHeader) && offset % 16 == 0 && offset <= header.fileSize && size <= header.fileSize - offset;
+    }
+
+    static void WriteAt(std::ofstream &out, uint64_t offset, const void* data, size_t size)
+    {
+        out.seekp(static_cast<std::streamoff>(offset));
+        if (size)
+            out.write(static_cast<const char*>(data), size);
+    }
+
+    bool invalidate()
+    {
+        file.close();
+        header = {};
+        return false;
+    }
+};
+#endif
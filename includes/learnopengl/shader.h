@@ -4,6 +4,8 @@
 #include <glad/glad.h>
 #include <glm/glm.hpp>
 
+#include <learnopengl/uniform_table.h>
+
 #include <string>
 #include <fstream>
 #include <sstream>
@@ -13,6 +15,7 @@ class Shader
 {
 public:
     unsigned int ID;
+    UniformTable uniforms; // active uniform locations, queried once after linking
     // constructor generates the shader on the fly
     // ------------------------------------------------------------------------
     Shader(const char* vertexPath, const char* fragmentPath, const char* geometryPath = nullptr)
@@ -89,6 +92,8 @@ public:
             glAttachShader(ID, geometry);
         glLinkProgram(ID);
         checkCompileErrors(ID, "PROGRAM");
+        // look up the active uniforms once, the setters below then never call glGetUniformLocation
+        uniforms.Build(ID);
         // delete the shaders as they're linked into our program now and no longer necessary
         glDeleteShader(vertex);
         glDeleteShader(fragment);
@@ -103,62 +108,64 @@ public:
         glUseProgram(ID); 
     }
     // utility uniform functions
+    // the name is hashed and looked up in the uniform table. On hot paths pass a constexpr UniformName or "name"_uniform,
+    // which are hashed at compile time; strings still work and are hashed without allocating.
     // ------------------------------------------------------------------------
-    void setBool(const std::string &name, bool value) const
+    void setBool(UniformName name, bool value) const
     {         
-        glUniform1i(glGetUniformLocation(ID, name.c_str()), (int)value); 
+        glUniform1i(uniforms.Location(name), (int)value); 
     }
     // ------------------------------------------------------------------------
-    void setInt(const std::string &name, int value) const
+    void setInt(UniformName name, int value) const
     { 
-        glUniform1i(glGetUniformLocation(ID, name.c_str()), value); 
+        glUniform1i(uniforms.Location(name), value); 
     }
     // ------------------------------------------------------------------------
-    void setFloat(const std::string &name, float value) const
+    void setFloat(UniformName name, float value) const
     { 
-        glUniform1f(glGetUniformLocation(ID, name.c_str()), value); 
+        glUniform1f(uniforms.Location(name), value); 
     }
     // ------------------------------------------------------------------------
-    void setVec2(const std::string &name, const glm::vec2 &value) const
+    void setVec2(UniformName name, const glm::vec2 &value) const
     { 
-        glUniform2fv(glGetUniformLocation(ID, name.c_str()), 1, &value[0]); 
+        glUniform2fv(uniforms.Location(name), 1, &value[0]); 
     }
-    void setVec2(const std::string &name, float x, float y) const
+    void setVec2(UniformName name, float x, float y) const
     { 
-        glUniform2f(glGetUniformLocation(ID, name.c_str()), x, y); 
+        glUniform2f(uniforms.Location(name), x, y); 
     }
     // ------------------------------------------------------------------------
-    void setVec3(const std::string &name, const glm::vec3 &value) const
+    void setVec3(UniformName name, const glm::vec3 &value) const
     { 
-        glUniform3fv(glGetUniformLocation(ID, name.c_str()), 1, &value[0]); 
+        glUniform3fv(uniforms.Location(name), 1, &value[0]); 
     }
-    void setVec3(const std::string &name, float x, float y, float z) const
+    void setVec3(UniformName name, float x, float y, float z) const
     { 
-        glUniform3f(glGetUniformLocation(ID, name.c_str()), x, y, z); 
+        glUniform3f(uniforms.Location(name), x, y, z); 
     }
     // ------------------------------------------------------------------------
-    void setVec4(const std::string &name, const glm::vec4 &value) const
+    void setVec4(UniformName name, const glm::vec4 &value) const
     { 
-        glUniform4fv(glGetUniformLocation(ID, name.c_str()), 1, &value[0]); 
+        glUniform4fv(uniforms.Location(name), 1, &value[0]); 
     }
-    void setVec4(const std::string &name, float x, float y, float z, float w) 
+    void setVec4(UniformName name, float x, float y, float z, float w) 
     { 
-        glUniform4f(glGetUniformLocation(ID, name.c_str()), x, y, z, w); 
+        glUniform4f(uniforms.Location(name), x, y, z, w); 
     }
     // ------------------------------------------------------------------------
-    void setMat2(const std::string &name, const glm::mat2 &mat) const
+    void setMat2(UniformName name, const glm::mat2 &mat) const
     {
-        glUniformMatrix2fv(glGetUniformLocation(ID, name.c_str()), 1, GL_FALSE, &mat[0][0]);
+        glUniformMatrix2fv(uniforms.Location(name), 1, GL_FALSE, &mat[0][0]);
     }
     // ------------------------------------------------------------------------
-    void setMat3(const std::string &name, const glm::mat3 &mat) const
+    void setMat3(UniformName name, const glm::mat3 &mat) const
     {
-        glUniformMatrix3fv(glGetUniformLocation(ID, name.c_str()), 1, GL_FALSE, &mat[0][0]);
+        glUniformMatrix3fv(uniforms.Location(name), 1, GL_FALSE, &mat[0][0]);
     }
     // ------------------------------------------------------------------------
-    void setMat4(const std::string &name, const glm::mat4 &mat) const
+    void setMat4(UniformName name, const glm::mat4 &mat) const
     {
-        glUniformMatrix4fv(glGetUniformLocation(ID, name.c_str()), 1, GL_FALSE, &mat[0][0]);
+        glUniformMatrix4fv(uniforms.Location(name), 1, GL_FALSE, &mat[0][0]);
     }
 
 private:
@@ -2,6 +2,7 @@
 #define SHADER_H
 
 #include <glad/glad.h>
+#include <learnopengl/uniform_table.h>
 #include <string>
 #include <fstream>
 #include <sstream>
@@ -13,6 +14,7 @@ class Shader
 public:
     // 着色器程序ID
     unsigned int ID;
+    UniformTable uniforms; // 链接时查询的活动uniform位置
 
     // 构造函数：接收顶点着色器和片段着色器的文件路径，完成着色器的创建和编译
     // vertexPath: 顶点着色器文件路径
@@ -68,6 +70,8 @@ public:
         glAttachShader(ID, fragment);
         glLinkProgram(ID);
         checkCompileErrors(ID, "PROGRAM");
+        // 查询一次活动uniform的位置，之后的set函数不再调用glGetUniformLocation
+        uniforms.Build(ID);
         // delete the shaders as they're linked into our program now and no longer necessary
         glDeleteShader(vertex);
         glDeleteShader(fragment);
@@ -85,25 +89,25 @@ public:
     // setBool：设置布尔类型的uniform变量
     // name: uniform变量名
     // value: 要设置的布尔值
-    void setBool(const std::string &name, bool value) const
+    void setBool(UniformName name, bool value) const
     {         
-        glUniform1i(glGetUniformLocation(ID, name.c_str()), (int)value); 
+        glUniform1i(uniforms.Location(name), (int)value); 
     }
 
     // setInt：设置整型uniform变量
     // name: uniform变量名
     // value: 要设置的整数值
-    void setInt(const std::string &name, int value) const
+    void setInt(UniformName name, int value) const
     { 
-        glUniform1i(glGetUniformLocation(ID, name.c_str()), value); 
+        glUniform1i(uniforms.Location(name), value); 
     }
 
     // setFloat：设置浮点型uniform变量
     // name: uniform变量名
     // value: 要设置的浮点数值
-    void setFloat(const std::string &name, float value) const
+    void setFloat(UniformName name, float value) const
     { 
-        glUniform1f(glGetUniformLocation(ID, name.c_str()), value); 
+        glUniform1f(uniforms.Location(name), value); 
     }
 
 private:
@@ -0,0 +1,21 @@
+#ifndef SIMD_H
+#define SIMD_H
+
+// compile-time SIMD detection shared by the CPU-side kernels. Every kernel keeps a scalar fallback,
+// so building without these instruction sets only costs speed.
+#if defined(__SSE2__) || defined(_M_X64) || (defined(_M_IX86_FP) && _M_IX86_FP >= 2)
+#define LOGL_SSE2 1
+#include <emmintrin.h>
+#endif
+
+#if defined(__SSE4_1__) || defined(__AVX__)
+#define LOGL_SSE41 1
+#include <smmintrin.h>
+#endif
+
+#if defined(__AVX2__)
+#define LOGL_AVX2 1
+#include <immintrin.h>
+#endif
+
+#endif
@@ -0,0 +1,454 @@
+#ifndef SPATIAL_HASH_H
+#define SPATIAL_HASH_H
+
+#include <glm/glm.hpp>
+
+#include <learnopengl/bounds.h>
+
+#include <algorithm>
+#include <cmath>
+#include <cstdint>
+#include <limits>
+#include <utility>
+#include <vector>
+
+// loose uniform grid over boxes, with the cells kept in a hash table so only occupied ones cost memory. A box lives
+// in the one cell its centre falls into; boxes may reach half a cell beyond it, so queries look one cell further.
+// Boxes with a half extent larger than that go into a separate list every query tests.
+// Insert(), Remove() and Move() are O(1): a move within its cell only stores the new box, otherwise the object is
+// swapped out of one cell vector and appended to the other. Cells are never freed, an emptied cell is reused when
+// something enters it again.
+class SpatialHash
+{
+public:
+    static const int32_t None = -1;
+
+    explicit SpatialHash(float cellSize = 4.0f)
+    {
+        setCellSize(cellSize);
+    }
+
+    // empties the grid and changes its cell size
+    void Clear(float cellSize)
+    {
+        setCellSize(cellSize);
+        proxies.clear();
+        freeProxies.clear();
+        cells.clear();
+        large.clear();
+        table.clear();
+        tableMask = 0;
+        proxyCount = 0;
+        cellMin = glm::ivec3(std::numeric_limits<int>::max());
+        cellMax = glm::ivec3(std::numeric_limits<int>::min());
+    }
+
+    // adds a box and returns its proxy id
+    int32_t Insert(const BoundingBox &box, uint32_t userData)
+    {
+        int32_t proxy;
+        if (!freeProxies.empty())
+        {
+            proxy = freeProxies.back();
+            freeProxies.pop_back();
+        }
+        else
+        {
+            proxy = static_cast<int32_t>(proxies.size());
+            proxies.emplace_back();
+        }
+        proxies[proxy].box = box;
+        proxies[proxy].userData = userData;
+        link(proxy, cellFor(box));
+        proxyCount++;
+        return proxy;
+    }
+
+    void Remove(int32_t proxy)
+    {
+        unlink(proxy);
+        proxies[proxy].cell = Free;
+        freeProxies.push_back(proxy);
+        proxyCount--;
+    }
+
+    void Move(int32_t proxy, const BoundingBox &box)
+    {
+        Proxy &p = proxies[proxy];
+        p.box = box;
+        const uint32_t cell = cellFor(box);
+        if (cell == p.cell)
+            return;
+        unlink(proxy);
+        link(proxy, cell);
+    }
+
+    size_t Size() const { return proxyCount; }
+    size_t CellCount() const { return cells.size(); }
+    float CellSize() const { return cellSize; }
+    const BoundingBox &Box(int32_t proxy) const { return proxies[proxy].box; }
+    uint32_t UserData(int32_t proxy) const { return proxies[proxy].userData; }
+
+    // calls visit(userData) for every box overlapping the given one
+    template<typename Visit>
+    void Query(const BoundingBox &box, Visit visit) const
+    {
+        forEachCandidate(box, [&](int32_t proxy)
+        {
+            if (overlaps(proxies[proxy].box, box))
+                visit(proxies[proxy].userData);
+        });
+    }
+
+    // calls visit(userData) for every box within radius of center
+    template<typename Visit>
+    void QuerySphere(const glm::vec3 &center, float radius, Visit visit) const
+    {
+        const BoundingBox box{ center - glm::vec3(radius), center + glm::vec3(radius) };
+        forEachCandidate(box, [&](int32_t proxy)
+        {
+            if (distanceSquared(proxies[proxy].box, center) <= radius * radius)
+                visit(proxies[proxy].userData);
+        });
+    }
+
+    // the userData of the k boxes closest to point, closest first. Searches rings of cells outwards from the cell
+    // of the point and stops once the next ring can't hold anything closer than the k-th box found so far.
+    void Nearest(const glm::vec3 &point, size_t k, std::vector<uint32_t> &result) const
+    {
+        result.clear();
+        if (k == 0 || proxyCount == 0)
+            return;
+        std::vector<std::pair<float, int32_t>> &best = nearestHeap;
+        best.clear();
+        auto consider = [&](int32_t proxy)
+        {
+            const float d = distanceSquared(proxies[proxy].box, point);
+            if (best.size() < k)
+            {
+                best.push_back({ d, proxy });
+                std::push_heap(best.begin(), best.end());
+            }
+            else if (d < best.front().first)
+            {
+                std::pop_heap(best.begin(), best.end());
+                best.back() = { d, proxy };
+                std::push_heap(best.begin(), best.end());
+            }
+        };
+        for (int32_t proxy : large)
+            consider(proxy);
+
+        if (!cells.empty())
+        {
+            const glm::ivec3 center = glm::clamp(cellOf(point), cellMin, cellMax);
+            const glm::ivec3 reach = glm::max(center - cellMin, cellMax - center);
+            const int lastRing = std::max(reach.x, std::max(reach.y, reach.z));
+            for (int ring = 0; ring <= lastRing; ring++)
+            {
+                // every box of a cell in this ring is at least this far from the point
+                const float bound = std::max(0.0f, (static_cast<float>(ring) - 1.5f) * cellSize);
+                if (best.size() == k && bound * bound > best.front().first)
+                    break;
+                // a thin shell of a large ring costs more lookups than there are cells, test the rest of them instead
+                if (24.0 * ring * ring + 2.0 > static_cast<double>(cells.size()))
+                {
+                    for (const Cell &cell : cells)
+                    {
+                        const glm::ivec3 d = glm::abs(cell.coord - center);
+                        if (std::max(d.x, std::max(d.y, d.z)) >= ring)
+                            for (int32_t proxy : cell.proxies)
+                                consider(proxy);
+                    }
+                    break;
+                }
+                forEachInRing(center, ring, [&](const Cell &cell)
+                {
+                    for (int32_t proxy : cell.proxies)
+                        consider(proxy);
+                });
+            }
+        }
+
+        std::sort_heap(best.begin(), best.end());
+        for (const auto &entry : best)
+            result.push_back(proxies[entry.second].userData);
+    }
+
+    // closest box along origin + t * direction with 0 <= t <= maxDistance. Walks the cells the ray crosses
+    // (Amanatides & Woo) and tests the boxes of their neighbours too, since those may reach into them; each cell
+    // is tested once. The walk ends at the first cell entered behind the closest hit.
+    bool Raycast(const glm::vec3 &origin, const glm::vec3 &direction, float maxDistance, uint32_t &userData, float &distance) const
+    {
+        const glm::vec3 inverse = 1.0f / direction;
+        float closest = maxDistance;
+        int32_t hit = None;
+        auto test = [&](int32_t proxy)
+        {
+            float t;
+            if (intersect(proxies[proxy].box, origin, inverse, closest, t))
+            {
+                closest = t;
+                hit = proxy;
+            }
+        };
+        for (int32_t proxy : large)
+            test(proxy);
+
+        if (!cells.empty())
+        {
+            // only the occupied cells and the ring around them can hold anything
+            const glm::ivec3 low = cellMin - 1, high = cellMax + 1;
+            const BoundingBox range{ glm::vec3(low) * cellSize, glm::vec3(high + 1) * cellSize };
+            float enter, exit;
+            if (slabs(range, origin, inverse, enter, exit) && enter <= closest)
+            {
+                float t = std::max(enter, 0.0f);
+                glm::ivec3 cell = glm::clamp(cellOf(origin + direction * t), low, high);
+                glm::ivec3 step;
+                glm::vec3 next, delta;
+                for (int axis = 0; axis < 3; axis++)
+                {
+                    step[axis] = direction[axis] > 0.0f ? 1 : -1;
+                    delta[axis] = std::abs(cellSize * inverse[axis]);
+                    const float boundary = (cell[axis] + (step[axis] > 0 ? 1 : 0)) * cellSize;
+                    next[axis] = direction[axis] != 0.0f ? (boundary - origin[axis]) * inverse[axis] : std::numeric_limits<float>::infinity();
+                }
+                stamp++;
+                while (t <= closest && t <= exit)
+                {
+                    for (int z = -1; z <= 1; z++)
+                        for (int y = -1; y <= 1; y++)
+                            for (int x = -1; x <= 1; x++)
+                            {
+                                const uint32_t index = find(cell + glm::ivec3(x, y, z));
+                                if (index == Free || cellStamps[index] == stamp)
+                                    continue;
+                                cellStamps[index] = stamp;
+                                for (int32_t proxy : cells[index].proxies)
+                                    test(proxy);
+                            }
+                    const int axis = next.x < next.y ? (next.x < next.z ? 0 : 2) : (next.y < next.z ? 1 : 2);
+                    t = next[axis];
+                    next[axis] += delta[axis];
+                    cell[axis] += step[axis];
+                    if (cell[axis] < low[axis] || cell[axis] > high[axis])
+                        break;
+                }
+            }
+        }
+
+        if (hit == None)
+            return false;
+        userData = proxies[hit].userData;
+        distance = closest;
+        return true;
+    }
+
+private:
+    static constexpr uint32_t Free = 0xffffffffu;  // cell of a removed proxy, and the empty table slot
+    static constexpr uint32_t Large = 0xfffffffeu; // cell of a proxy kept in the large list
+    static constexpr int CoordLimit = 1 << 20;
+
+    struct Proxy
+    {
+        BoundingBox box;
+        uint32_t userData = 0;
+        uint32_t cell = Free;
+        uint32_t slot = 0; // position in the proxy list of its cell
+    };
+
+    struct Cell
+    {
+        glm::ivec3 coord;
+        std::vector<int32_t> proxies;
+    };
+
+    float cellSize = 4.0f;
+    float inverseCellSize = 0.25f;
+    std::vector<Proxy> proxies;
+    std::vector<int32_t> freeProxies;
+    std::vector<Cell> cells;
+    std::vector<int32_t> large;
+    std::vector<uint32_t> table; // cell index per slot, open addressing with linear probing at most half full
+    uint32_t tableMask = 0;
+    size_t proxyCount = 0;
+    glm::ivec3 cellMin = glm::ivec3(std::numeric_limits<int>::max());
+    glm::ivec3 cellMax = glm::ivec3(std::numeric_limits<int>::min());
+    // scratch of the const queries
+    mutable std::vector<std::pair<float, int32_t>> nearestHeap;
+    mutable std::vector<uint32_t> cellStamps;
+    mutable uint32_t stamp = 0;
+
+    void setCellSize(float size)
+    {
+        cellSize = size > 0.0f ? size : 1.0f;
+        inverseCellSize = 1.0f / cellSize;
+    }
+
+    glm::ivec3 cellOf(const glm::vec3 &position) const
+    {
+        const glm::vec3 coord = glm::clamp(glm::floor(position * inverseCellSize), glm::vec3(-CoordLimit), glm::vec3(CoordLimit - 1));
+        return glm::ivec3(coord);
+    }
+
+    static uint32_t hash(const glm::ivec3 &coord)
+    {
+        return static_cast<uint32_t>(coord.x) * 73856093u ^ static_cast<uint32_t>(coord.y) * 19349663u ^ static_cast<uint32_t>(coord.z) * 83492791u;
+    }
+
+    uint32_t find(const glm::ivec3 &coord) const
+    {
+        if (table.empty())
+            return Free;
+        for (uint32_t slot = hash(coord) & tableMask; ; slot = (slot + 1) & tableMask)
+        {
+            const uint32_t index = table[slot];
+            if (index == Free || cells[index].coord == coord)
+                return index;
+        }
+    }
+
+    // the cell a box belongs to, created on first use
+    uint32_t cellFor(const BoundingBox &box)
+    {
+        const glm::vec3 extents = box.Extents();
+        if (std::max(extents.x, std::max(extents.y, extents.z)) > cellSize * 0.5f)
+            return Large;
+        const glm::ivec3 coord = cellOf(box.Center());
+        const uint32_t index = find(coord);
+        if (index != Free)
+            return index;
+
+        if ((cells.size() + 1) * 2 > table.size())
+            grow();
+        const uint32_t created = static_cast<uint32_t>(cells.size());
+        cells.push_back(Cell{ coord, {} });
+        cellStamps.push_back(0);
+        insertSlot(created);
+        cellMin = glm::min(cellMin, coord);
+        cellMax = glm::max(cellMax, coord);
+        return created;
+    }
+
+    void insertSlot(uint32_t index)
+    {
+        uint32_t slot = hash(cells[index].coord) & tableMask;
+        while (table[slot] != Free)
+            slot = (slot + 1) & tableMask;
+        table[slot] = index;
+    }
+
+    void grow()
+    {
+        const size_t capacity = std::max<size_t>(table.size() * 2, 64);
+        table.assign(capacity, Free);
+        tableMask = static_cast<uint32_t>(capacity - 1);
+        for (uint32_t index = 0; index < cells.size(); index++)
+            insertSlot(index);
+    }
+
+    std::vector<int32_t> &listOf(uint32_t cell)
+    {
+        return cell == Large ? large : cells[cell].proxies;
+    }
+
+    void link(int32_t proxy, uint32_t cell)
+    {
+        std::vector<int32_t> &list = listOf(cell);
+        proxies[proxy].cell = cell;
+        proxies[proxy].slot = static_cast<uint32_t>(list.size());
+        list.push_back(proxy);
+    }
+
+    // swap with the last entry of the cell and pop
+    void unlink(int32_t proxy)
+    {
+        std::vector<int32_t> &list = listOf(proxies[proxy].cell);
+        const uint32_t slot = proxies[proxy].slot;
+        list[slot] = list.back();
+        proxies[list[slot]].slot = slot;
+        list.pop_back();
+    }
+
+    // every proxy whose box can overlap the given one: the large ones and those of the cells around it
+    template<typename Visit>
+    void forEachCandidate(const BoundingBox &box, Visit visit) const
+    {
+        for (int32_t proxy : large)
+            visit(proxy);
+        if (cells.empty())
+            return;
+        const glm::vec3 loose(cellSize * 0.5f);
+        const glm::ivec3 low = glm::max(cellOf(box.min - loose), cellMin);
+        const glm::ivec3 high = glm::min(cellOf(box.max + loose), cellMax);
+        if (glm::any(glm::greaterThan(low, high)))
+            return;
+        const glm::dvec3 size = glm::dvec3(high - low + 1);
+        if (size.x * size.y * size.z > static_cast<double>(cells.size()))
+        {
+            for (const Cell &cell : cells)
+                if (glm::all(glm::greaterThanEqual(cell.coord, low)) && glm::all(glm::lessThanEqual(cell.coord, high)))
+                    for (int32_t proxy : cell.proxies)
+                        visit(proxy);
+            return;
+        }
+        for (int z = low.z; z <= high.z; z++)
+            for (int y = low.y; y <= high.y; y++)
+                for (int x = low.x; x <= high.x; x++)
+                {
+                    const uint32_t index = find(glm::ivec3(x, y, z));
+                    if (index != Free)
+                        for (int32_t proxy : cells[index].proxies)
+                            visit(proxy);
+                }
+    }
+
+    // the occupied cells at Chebyshev distance ring from center
+    template<typename Visit>
+    void forEachInRing(const glm::ivec3 &center, int ring, Visit visit) const
+    {
+        for (int z = -ring; z <= ring; z++)
+            for (int y = -ring; y <= ring; y++)
+            {
+                const bool face = std::abs(z) == ring || std::abs(y) == ring;
+                for (int x = -ring; x <= ring; x += face || ring == 0 ? 1 : 2 * ring)
+                {
+                    const uint32_t index = find(center + glm::ivec3(x, y, z));
+                    if (index != Free)
+                        visit(cells[index]);
+                }
+            }
+    }
+
+    static bool overlaps(const BoundingBox &a, const BoundingBox &b)
+    {
+        return glm::all(glm::lessThanEqual(a.min, b.max)) && glm::all(glm::lessThanEqual(b.min, a.max));
+    }
+
+    static float distanceSquared(const BoundingBox &box, const glm::vec3 &point)
+    {
+        const glm::vec3 d = glm::max(glm::max(box.min - point, point - box.max), glm::vec3(0.0f));
+        return glm::dot(d, d);
+    }
+
+    static bool slabs(const BoundingBox &box, const glm::vec3 &origin, const glm::vec3 &inverse, float &enter, float &exit)
+    {
+        const glm::vec3 t0 = (box.min - origin) * inverse, t1 = (box.max - origin) * inverse;
+        const glm::vec3 first = glm::min(t0, t1), last = glm::max(t0, t1);
+        enter = std::max(first.x, std::max(first.y, first.z));
+        exit = std::min(last.x, std::min(last.y, last.z));
+        return enter <= exit && exit >= 0.0f;
+    }
+
+    // entry distance of the ray into the box, when that is no further than limit
+    static bool intersect(const BoundingBox &box, const glm::vec3 &origin, const glm::vec3 &inverse, float limit, float &t)
+    {
+        float enter, exit;
+        if (!slabs(box, origin, inverse, enter, exit))
+            return false;
+        t = std::max(enter, 0.0f);
+        return t <= limit;
+    }
+};
+#endif
@@ -0,0 +1,142 @@
+#ifndef TEXTURE_CACHE_H
+#define TEXTURE_CACHE_H
+
+#include <glad/glad.h>
+
+#include <learnopengl/texture_loader.h>
+
+#include <filesystem>
+#include <list>
+#include <string>
+#include <system_error>
+#include <unordered_map>
+
+// process-wide cache of 2D textures shared by every Model. Textures are keyed by their canonical path plus
+// sampler/colour-space parameters, so two models referencing the same file decode and upload it only once.
+// Entries are reference counted; once nothing references a texture it stays resident for reuse until the
+// VRAM budget is exceeded, at which point the least recently used unreferenced textures are deleted.
+class TextureCache
+{
+public:
+    static TextureCache& Instance()
+    {
+        static TextureCache cache(TextureLoader::Instance());
+        return cache;
+    }
+
+    explicit TextureCache(TextureLoader &loader, size_t budgetBytes = size_t(512) << 20)
+        : loader(loader), budget(budgetBytes)
+    {
+        loader.SetUploadCallback([this](unsigned int textureID, size_t bytes) { onUploaded(textureID, bytes); });
+    }
+
+    TextureCache(const TextureCache&) = delete;
+    TextureCache& operator=(const TextureCache&) = delete;
+
+    // context thread only: returns the texture for the given file, loading it on a miss. Adds a reference.
+    unsigned int Acquire(const std::string &filename, const TextureParams &params = TextureParams())
+    {
+        const std::string key = MakeKey(filename, params);
+        auto it = entries.find(key);
+        if (it != entries.end())
+        {
+            Entry &entry = it->second;
+            if (entry.refCount++ == 0)
+                lru.erase(entry.lruPosition);
+            return entry.textureID;
+        }
+
+        Entry entry;
+        entry.textureID = loader.Load(filename, params);
+        entry.refCount = 1;
+        keys[entry.textureID] = key;
+        entries.emplace(key, entry);
+        trim();
+        return entry.textureID;
+    }
+
+    // drops a reference. Safe to call from destructors that run after the GL context is gone:
+    // textures are only ever deleted from Acquire()/SetBudget() on the context thread.
+    void Release(unsigned int textureID)
+    {
+        auto key = keys.find(textureID);
+        if (key == keys.end())
+            return;
+        Entry &entry = entries[key->second];
+        if (entry.refCount == 0)
+            return;
+        if (--entry.refCount == 0)
+            entry.lruPosition = lru.insert(lru.begin(), key->second);
+    }
+
+    // context thread only
+    void SetBudget(size_t budgetBytes)
+    {
+        budget = budgetBytes;
+        trim();
+    }
+
+    size_t Budget() const { return budget; }
+    size_t MemoryUsage() const { return usage; }
+    size_t Size() const { return entries.size(); }
+
+private:
+    struct Entry
+    {
+        unsigned int textureID = 0;
+        unsigned int refCount = 0;
+        size_t bytes = 0;
+        bool uploaded = false;
+        std::list<std::string>::iterator lruPosition; // only valid while refCount == 0
+    };
+
+    TextureLoader &loader;
+    std::unordered_map<std::string, Entry> entries;
+    std::unordered_map<unsigned int, std::string> keys; // texture name -> key
+    std::list<std::string> lru;                          // unreferenced entries, most recently used first
+    size_t budget;
+    size_t usage = 0;
+
+    static std::string MakeKey(const std::string &filename, const TextureParams &params)
+    {
+        std::error_code error;
+        std::filesystem::path canonical = std::filesystem::weakly_canonical(filename, error);
+        std::string key = error ? filename : canonical.generic_string();
+        key += '|';
+        key += params.srgb ? "srgb" : "linear";
+        key += '|' + std::to_string(params.wrap) + '|' + std::to_string(params.minFilter) + '|' + std::to_string(params.magFilter);
+        return key;
+    }
+
+    void onUploaded(unsigned int textureID, size_t bytes)
+    {
+        auto key = keys.find(textureID);
+        if (key == keys.end())
+            return;
+        Entry &entry = entries[key->second];
+        usage += bytes - entry.bytes;
+        entry.bytes = bytes;
+        entry.uploaded = true;
+        // an upload can push us over budget; evicting here would delete a texture that is being uploaded in a
+        // loop on this very thread, so eviction waits for the next Acquire()/SetBudget()
+    }
+
+    void trim()
+    {
+        auto candidate = lru.end();
+        while (usage > budget && candidate != lru.begin())
+        {
+            --candidate;
+            auto it = entries.find(*candidate);
+            // a texture still waiting for its upload can't go: its name would be recycled before the upload lands
+            if (!it->second.uploaded)
+                continue;
+            candidate = lru.erase(candidate);
+            glDeleteTextures(1, &it->second.textureID);
+            usage -= it->second.bytes;
+            keys.erase(it->second.textureID);
+            entries.erase(it);
+        }
+    }
+};
+#endif
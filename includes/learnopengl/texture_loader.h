@@ -0,0 +1,266 @@
+#ifndef TEXTURE_LOADER_H
+#define TEXTURE_LOADER_H
+
+#include <glad/glad.h>
+#include <stb_image.h>
+
+#include <algorithm>
+#include <condition_variable>
+#include <deque>
+#include <functional>
+#include <iostream>
+#include <mutex>
+#include <string>
+#include <thread>
+#include <vector>
+
+// sampler and colour-space state a texture is created with
+struct TextureParams
+{
+    bool  srgb      = false;
+    GLint wrap      = GL_REPEAT;
+    GLint minFilter = GL_LINEAR_MIPMAP_LINEAR;
+    GLint magFilter = GL_LINEAR;
+};
+
+// decodes image files on a pool of worker threads and finishes them on the thread that owns the GL context.
+// Load() hands out a texture name right away that shows a 1x1 placeholder until ProcessUploads()/Flush()
+// has uploaded the decoded image. Both the decode queue and the number of decoded images waiting for upload
+// are bounded, so at most (threads + maxReady) decoded images are held in memory at any time.
+class TextureLoader
+{
+public:
+    // process-wide loader shared by every Model
+    static TextureLoader& Instance()
+    {
+        static TextureLoader loader;
+        return loader;
+    }
+
+    TextureLoader(unsigned int threadCount = 0, size_t maxQueued = 256, size_t maxReady = 8)
+        : maxQueued(std::max<size_t>(maxQueued, 1)), maxReady(std::max<size_t>(maxReady, 1))
+    {
+        if (threadCount == 0)
+            threadCount = std::max(1u, std::thread::hardware_concurrency());
+        for (unsigned int i = 0; i < threadCount; i++)
+            workers.emplace_back(&TextureLoader::workerLoop, this);
+    }
+
+    TextureLoader(const TextureLoader&) = delete;
+    TextureLoader& operator=(const TextureLoader&) = delete;
+
+    ~TextureLoader()
+    {
+        {
+            std::lock_guard<std::mutex> lock(mutex);
+            stopping = true;
+        }
+        jobAvailable.notify_all();
+        readySpace.notify_all();
+        for (std::thread &worker : workers)
+            worker.join();
+        for (Decoded &image : ready)
+            stbi_image_free(image.data);
+    }
+
+    // context thread only: creates the texture object and queues the file for decoding.
+    unsigned int Load(const std::string &filename, const TextureParams &params = TextureParams())
+    {
+        unsigned int textureID;
+        glGenTextures(1, &textureID);
+        UploadPlaceholder(textureID);
+
+        std::unique_lock<std::mutex> lock(mutex);
+        // the decode queue is full: upload finished images ourselves until the workers catch up,
+        // waiting here without doing so could deadlock against workers blocked on a full ready queue
+        while (jobs.size() >= maxQueued)
+        {
+            if (!ready.empty())
+            {
+                lock.unlock();
+                ProcessUploads(maxReady);
+                lock.lock();
+            }
+            else
+                readyAvailable.wait(lock);
+        }
+        jobs.push_back({ filename, textureID, params });
+        pending++;
+        lock.unlock();
+        jobAvailable.notify_one();
+        return textureID;
+    }
+
+    // context thread only: uploads up to maxUploads decoded images, returns how many were uploaded.
+    // call once per frame to finish streamed textures without stalling the frame.
+    unsigned int ProcessUploads(unsigned int maxUploads = ~0u)
+    {
+        unsigned int uploaded = 0;
+        while (uploaded < maxUploads)
+        {
+            Decoded image;
+            {
+                std::lock_guard<std::mutex> lock(mutex);
+                if (ready.empty())
+                    break;
+                image = ready.front();
+                ready.pop_front();
+            }
+            readySpace.notify_one();
+
+            if (image.data)
+            {
+                Upload(image.textureID, image.data, image.width, image.height, image.components, image.params);
+                stbi_image_free(image.data);
+                if (uploadCallback)
+                    uploadCallback(image.textureID, ImageBytes(image.width, image.height, image.components));
+            }
+            else
+                std::cout << "Texture failed to load at path: " << image.filename << std::endl;
+
+            {
+                std::lock_guard<std::mutex> lock(mutex);
+                pending--;
+            }
+            uploaded++;
+        }
+        return uploaded;
+    }
+
+    // context thread only: blocks until every queued texture is decoded and uploaded.
+    void Flush()
+    {
+        std::unique_lock<std::mutex> lock(mutex);
+        while (pending > 0)
+        {
+            if (ready.empty())
+                readyAvailable.wait(lock);
+            lock.unlock();
+            ProcessUploads();
+            lock.lock();
+        }
+    }
+
+    // number of textures still waiting to be decoded or uploaded
+    size_t Pending()
+    {
+        std::lock_guard<std::mutex> lock(mutex);
+        return pending;
+    }
+
+    // context thread only: called after every completed upload with the texture and its estimated GPU size
+    void SetUploadCallback(std::function<void(unsigned int, size_t)> callback)
+    {
+        uploadCallback = std::move(callback);
+    }
+
+    // uploads a decoded image to the given texture and generates its mipmaps
+    static void Upload(unsigned int textureID, const unsigned char *data, int width, int height, int nrComponents,
+                       const TextureParams &params = TextureParams())
+    {
+        GLenum format = GL_RGBA;
+        GLenum internalFormat = GL_RGBA;
+        if (nrComponents == 1)
+            format = internalFormat = GL_RED;
+        else if (nrComponents == 3)
+        {
+            format = GL_RGB;
+            internalFormat = params.srgb ? GL_SRGB : GL_RGB;
+        }
+        else if (nrComponents == 4)
+        {
+            format = GL_RGBA;
+            internalFormat = params.srgb ? GL_SRGB_ALPHA : GL_RGBA;
+        }
+
+        glBindTexture(GL_TEXTURE_2D, textureID);
+        glTexImage2D(GL_TEXTURE_2D, 0, internalFormat, width, height, 0, format, GL_UNSIGNED_BYTE, data);
+        glGenerateMipmap(GL_TEXTURE_2D);
+
+        glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_S, params.wrap);
+        glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_T, params.wrap);
+        glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MIN_FILTER, params.minFilter);
+        glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MAG_FILTER, params.magFilter);
+    }
+
+    // a 1x1 grey image shown until the real one is uploaded
+    static void UploadPlaceholder(unsigned int textureID)
+    {
+        const unsigned char grey[4] = { 128, 128, 128, 255 };
+        glBindTexture(GL_TEXTURE_2D, textureID);
+        glTexImage2D(GL_TEXTURE_2D, 0, GL_RGBA, 1, 1, 0, GL_RGBA, GL_UNSIGNED_BYTE, grey);
+        glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MIN_FILTER, GL_LINEAR);
+        glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MAG_FILTER, GL_LINEAR);
+    }
+
+    // rough GPU footprint of an 8-bit image with a full mip chain
+    static size_t ImageBytes(int width, int height, int nrComponents)
+    {
+        return static_cast<size_t>(width) * height * (nrComponents == 3 ? 4 : nrComponents) * 4 / 3;
+    }
+
+private:
+    struct Job
+    {
+        std::string filename;
+        unsigned int textureID;
+        TextureParams params;
+    };
+
+    struct Decoded
+    {
+        std::string filename;
+        unsigned int textureID = 0;
+        unsigned char *data = nullptr;
+        int width = 0, height = 0, components = 0;
+        TextureParams params;
+    };
+
+    std::vector<std::thread> workers;
+    std::deque<Job> jobs;
+    std::deque<Decoded> ready;
+    size_t maxQueued, maxReady;
+    size_t pending = 0;
+    bool stopping = false;
+    std::function<void(unsigned int, size_t)> uploadCallback;
+
+    std::mutex mutex;
+    std::condition_variable jobAvailable;   // workers wait for jobs
+    std::condition_variable readySpace;     // workers wait for room in the ready queue
+    std::condition_variable readyAvailable; // context thread waits for decoded images
+
+    void workerLoop()
+    {
+        for (;;)
+        {
+            Job job;
+            {
+                std::unique_lock<std::mutex> lock(mutex);
+                jobAvailable.wait(lock, [this] { return stopping || !jobs.empty(); });
+                if (stopping)
+                    return;
+                job = std::move(jobs.front());
+                jobs.pop_front();
+            }
+
+            Decoded image;
+            image.filename = std::move(job.filename);
+            image.textureID = job.textureID;
+            image.params = job.params;
+            image.data = stbi_load(image.filename.c_str(), &image.width, &image.height, &image.components, 0);
+
+            {
+                std::unique_lock<std::mutex> lock(mutex);
+                readySpace.wait(lock, [this] { return stopping || ready.size() < maxReady; });
+                if (stopping)
+                {
+                    stbi_image_free(image.data);
+                    return;
+                }
+                ready.push_back(std::move(image));
+            }
+            readyAvailable.notify_one();
+        }
+    }
+};
+#endif
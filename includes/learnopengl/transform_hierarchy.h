@@ -0,0 +1,290 @@
+#ifndef TRANSFORM_HIERARCHY_H
+#define TRANSFORM_HIERARCHY_H
+
+#include <glm/glm.hpp>
+#include <glm/gtc/quaternion.hpp>
+
+#include <learnopengl/job_system.h>
+
+#include <algorithm>
+#include <cmath>
+#include <cstdint>
+#include <vector>
+
+// every node of a transform tree stored as structure of arrays. Nodes are only ever appended and a parent has to
+// exist before its children, so the arrays are in parent-before-child order and Update() computes all world
+// matrices in one linear pass: by the time a node is reached its parent's world matrix is final.
+// Update(jobs) does the same level by level, every node of a level only depends on the level above.
+// Rotations are quaternions; the local matrix is cached and only rebuilt when the node's own TRS changed, a node
+// whose parent moved only redoes parent's world * local.
+// UpdateSubtree() does the same for one node and its descendants only.
+// Every update records the nodes whose world matrix it recomputed in ChangedNodes(), so whatever mirrors the world
+// matrices (bounding volume trees, grids) walks the moved nodes instead of testing every node.
+class TransformHierarchy
+{
+public:
+    static const uint32_t None = ~0u;
+
+    // local space. Write them through the setters, which keep the caches and flags right.
+    std::vector<glm::vec3> localPosition;
+    std::vector<glm::quat> localOrientation;
+    std::vector<glm::vec3> localRotation; // the same rotation as euler angles in degrees applied Y * X * Z, for editing
+    std::vector<glm::vec3> localScale;
+    std::vector<uint32_t>  parent;     // None for roots, always smaller than the node's own index otherwise
+    std::vector<glm::mat4> world;      // parent's world * local, valid after Update()
+    std::vector<uint8_t>   dirty;      // local TRS changed since the last update
+
+    // appends a node under parent (None for a root) with an identity local transform
+    uint32_t Create(uint32_t parentNode = None)
+    {
+        uint32_t node = static_cast<uint32_t>(parent.size());
+        localPosition.push_back(glm::vec3(0.0f));
+        localOrientation.push_back(glm::quat(1.0f, 0.0f, 0.0f, 0.0f));
+        localRotation.push_back(glm::vec3(0.0f));
+        localScale.push_back(glm::vec3(1.0f));
+        parent.push_back(parentNode);
+        world.push_back(glm::mat4(1.0f));
+        dirty.push_back(1);
+        local.push_back(glm::mat4(1.0f));
+        localStale.push_back(0);
+        changed.push_back(0);
+        size_t depth = parentNode == None ? 0 : nodeDepth[parentNode] + 1;
+        nodeDepth.push_back(static_cast<uint32_t>(depth));
+        if (levels.size() <= depth)
+            levels.resize(depth + 1);
+        levels[depth].push_back(node);
+        return node;
+    }
+
+    size_t Size() const { return parent.size(); }
+
+    void Reserve(size_t count)
+    {
+        localPosition.reserve(count);
+        localOrientation.reserve(count);
+        localRotation.reserve(count);
+        localScale.reserve(count);
+        parent.reserve(count);
+        world.reserve(count);
+        dirty.reserve(count);
+        local.reserve(count);
+        localStale.reserve(count);
+        changed.reserve(count);
+        nodeDepth.reserve(count);
+    }
+
+    // replaces every node with count nodes taken from flat arrays, as a scene file stores them (see scene_file.h).
+    // parents[i] has to be None or smaller than i. One bulk copy per array and nothing allocated per node; every
+    // node is dirty, so the next Update() computes all local and world matrices.
+    void Assign(size_t count, const uint32_t *parents, const glm::vec3 *positions, const glm::quat *orientations,
+                const glm::vec3 *rotations, const glm::vec3 *scales)
+    {
+        localPosition.assign(positions, positions + count);
+        localOrientation.assign(orientations, orientations + count);
+        localRotation.assign(rotations, rotations + count);
+        localScale.assign(scales, scales + count);
+        parent.assign(parents, parents + count);
+        world.resize(count);
+        dirty.assign(count, 1);
+        local.resize(count);
+        localStale.assign(count, 1);
+        changed.assign(count, 0);
+        changedNodes.clear();
+
+        // depths in one pass, then the levels sized by counting before they are filled
+        nodeDepth.resize(count);
+        std::vector<size_t> levelSize;
+        for (size_t i = 0; i < count; i++)
+        {
+            const uint32_t depth = parents[i] == None ? 0 : nodeDepth[parents[i]] + 1;
+            nodeDepth[i] = depth;
+            if (levelSize.size() <= depth)
+                levelSize.resize(depth + 1, 0);
+            levelSize[depth]++;
+        }
+        levels.resize(levelSize.size());
+        for (size_t depth = 0; depth < levels.size(); depth++)
+        {
+            levels[depth].clear();
+            levels[depth].reserve(levelSize[depth]);
+        }
+        for (size_t i = 0; i < count; i++)
+            levels[nodeDepth[i]].push_back(static_cast<uint32_t>(i));
+    }
+
+    void SetLocalPosition(uint32_t node, const glm::vec3 &position) { localPosition[node] = position; markDirty(node); }
+    void SetLocalScale(uint32_t node, const glm::vec3 &scale) { localScale[node] = scale; markDirty(node); }
+
+    // euler angles in degrees, applied Y * X * Z
+    void SetLocalRotation(uint32_t node, const glm::vec3 &rotation)
+    {
+        localRotation[node] = rotation;
+        localOrientation[node] = OrientationFromEuler(rotation);
+        markDirty(node);
+    }
+
+    void SetLocalOrientation(uint32_t node, const glm::quat &orientation)
+    {
+        localOrientation[node] = glm::normalize(orientation);
+        localRotation[node] = EulerFromOrientation(localOrientation[node]);
+        markDirty(node);
+    }
+
+    // the cached local matrix, rebuilt first if the TRS changed since
+    const glm::mat4& LocalMatrix(uint32_t node)
+    {
+        if (localStale[node])
+            refreshLocal(node);
+        return local[node];
+    }
+
+    // recomputes the world matrix of every dirty node and of everything below one; with force every node
+    void Update(bool force = false)
+    {
+        beginPass();
+        const uint32_t count = static_cast<uint32_t>(parent.size());
+        for (uint32_t i = 0; i < count; i++)
+            if (updateNode(i, force))
+                changedNodes.push_back(i);
+    }
+
+    // same result as Update(), with the levels that have at least grain nodes split over the job system's threads.
+    // Each chunk of a level collects its changed nodes on its own, they are appended in chunk order afterwards.
+    void Update(JobSystem &jobs, bool force = false, size_t grain = 2048)
+    {
+        beginPass();
+        grain = std::max<size_t>(grain, 1);
+        for (const std::vector<uint32_t> &level : levels)
+        {
+            if (level.size() < grain)
+            {
+                for (uint32_t node : level)
+                    if (updateNode(node, force))
+                        changedNodes.push_back(node);
+                continue;
+            }
+            const size_t chunks = (level.size() + grain - 1) / grain;
+            if (chunkChanged.size() < chunks)
+                chunkChanged.resize(chunks);
+            jobs.ParallelFor(level.size(), grain, [this, &level, force, grain](size_t begin, size_t end)
+            {
+                std::vector<uint32_t> &out = chunkChanged[begin / grain];
+                out.clear();
+                for (size_t k = begin; k < end; k++)
+                    if (updateNode(level[k], force))
+                        out.push_back(level[k]);
+            });
+            for (size_t c = 0; c < chunks; c++)
+                changedNodes.insert(changedNodes.end(), chunkChanged[c].begin(), chunkChanged[c].end());
+        }
+    }
+
+    // only root and the nodes below it; the rest keeps its world matrix and dirty flag for a later update. root's
+    // parent is taken as it is. Children always come after their parent, so the subtree is found in one pass over
+    // the nodes from root on.
+    void UpdateSubtree(uint32_t root, bool force = false)
+    {
+        beginPass();
+        const uint32_t count = static_cast<uint32_t>(parent.size());
+        inSubtree.assign(count - root, 0);
+        for (uint32_t i = root; i < count; i++)
+        {
+            const uint32_t p = parent[i];
+            if (i != root && (p == None || p < root || !inSubtree[p - root]))
+                continue;
+            inSubtree[i - root] = 1;
+            if (updateNode(i, force))
+                changedNodes.push_back(i);
+        }
+    }
+
+    // world matrix recomputed by the last update
+    bool Changed(uint32_t node) const { return changed[node] != 0; }
+
+    // every node Changed() is true for, parents before children
+    const std::vector<uint32_t>& ChangedNodes() const { return changedNodes; }
+
+    // number of nodes on the longest root to leaf path
+    size_t Depth() const { return levels.size(); }
+
+    // translation * rotation * scale (also know as TRS matrix), written out from the quaternion's components instead of
+    // multiplied from separate matrices. orientation has to be normalised.
+    static glm::mat4 ComposeLocal(const glm::vec3 &position, const glm::quat &orientation, const glm::vec3 &scale)
+    {
+        const float x = orientation.x, y = orientation.y, z = orientation.z, w = orientation.w;
+        const float xx = x * x, yy = y * y, zz = z * z;
+        const float xy = x * y, xz = x * z, yz = y * z, wx = w * x, wy = w * y, wz = w * z;
+
+        glm::mat4 m;
+        m[0] = glm::vec4(1.0f - 2.0f * (yy + zz), 2.0f * (xy + wz), 2.0f * (xz - wy), 0.0f) * scale.x;
+        m[1] = glm::vec4(2.0f * (xy - wz), 1.0f - 2.0f * (xx + zz), 2.0f * (yz + wx), 0.0f) * scale.y;
+        m[2] = glm::vec4(2.0f * (xz + wy), 2.0f * (yz - wx), 1.0f - 2.0f * (xx + yy), 0.0f) * scale.z;
+        m[3] = glm::vec4(position, 1.0f);
+        return m;
+    }
+
+    // Y * X * Z euler angles in degrees to a quaternion
+    static glm::quat OrientationFromEuler(const glm::vec3 &eulerDegrees)
+    {
+        const glm::vec3 half = glm::radians(eulerDegrees) * 0.5f;
+        const glm::quat qx(std::cos(half.x), std::sin(half.x), 0.0f, 0.0f);
+        const glm::quat qy(std::cos(half.y), 0.0f, std::sin(half.y), 0.0f);
+        const glm::quat qz(std::cos(half.z), 0.0f, 0.0f, std::sin(half.z));
+        return qy * qx * qz;
+    }
+
+    // inverse of OrientationFromEuler(), x within [-90, 90]
+    static glm::vec3 EulerFromOrientation(const glm::quat &orientation)
+    {
+        const glm::mat3 r = glm::mat3_cast(orientation);
+        const float sx = glm::clamp(-r[2].y, -1.0f, 1.0f);
+        return glm::degrees(glm::vec3(std::asin(sx), std::atan2(r[2].x, r[2].z), std::atan2(r[0].y, r[1].y)));
+    }
+
+private:
+    std::vector<glm::mat4> local;      // ComposeLocal() of the node's TRS
+    std::vector<uint8_t>   localStale; // local needs rebuilding; unlike dirty, not cleared by computing world
+    std::vector<uint8_t> changed; // world matrix recomputed in the last pass, so the children's parent changed
+    std::vector<uint32_t> changedNodes; // the nodes changed is set for
+    std::vector<std::vector<uint32_t>> chunkChanged; // scratch of Update(jobs), changed nodes per chunk of a level
+    std::vector<uint8_t> inSubtree; // scratch of UpdateSubtree(), indexed from its root
+    std::vector<uint32_t> nodeDepth;
+    std::vector<std::vector<uint32_t>> levels; // nodes by depth, each in index order
+
+    void markDirty(uint32_t node)
+    {
+        dirty[node] = 1;
+        localStale[node] = 1;
+    }
+
+    void refreshLocal(uint32_t node)
+    {
+        local[node] = ComposeLocal(localPosition[node], localOrientation[node], localScale[node]);
+        localStale[node] = 0;
+    }
+
+    // clears the changed flags of the previous pass, a node outside a subtree update must not look changed
+    void beginPass()
+    {
+        for (uint32_t node : changedNodes)
+            changed[node] = 0;
+        changedNodes.clear();
+    }
+
+    // local changed: rebuild the local matrix and the world matrix. Only the parent changed: just the world matrix.
+    bool updateNode(uint32_t i, bool force)
+    {
+        const uint32_t p = parent[i];
+        const uint8_t localChanged = force | dirty[i];
+        const uint8_t parentChanged = p != None ? changed[p] : 0;
+        changed[i] = localChanged | parentChanged;
+        if (!changed[i])
+            return false;
+        if (force | localStale[i])
+            refreshLocal(i);
+        world[i] = p != None ? world[p] * local[i] : local[i];
+        dirty[i] = 0;
+        return true;
+    }
+};
+#endif
@@ -0,0 +1,133 @@
+#ifndef UNIFORM_TABLE_H
+#define UNIFORM_TABLE_H
+
+#include <glad/glad.h>
+
+#include <cstdint>
+#include <cstring>
+#include <string>
+#include <vector>
+
+// a uniform name reduced to its 64-bit FNV-1a hash. Built from a literal it hashes at compile time when used in a
+// constant expression (constexpr UniformName model("model"); or "model"_uniform), from a std::string it hashes at
+// run time without allocating. Either way a lookup in a UniformTable is a single probe in the common case.
+struct UniformName
+{
+    uint64_t hash;
+
+    constexpr UniformName(const char *name) : hash(Hash(name, Length(name))) {}
+    UniformName(const std::string &name) : hash(Hash(name.c_str(), name.size())) {}
+
+    static constexpr uint64_t Hash(const char *name, size_t length)
+    {
+        uint64_t hash = 14695981039346656037ull;
+        for (size_t i = 0; i < length; i++)
+            hash = (hash ^ static_cast<unsigned char>(name[i])) * 1099511628211ull;
+        return hash;
+    }
+
+private:
+    static constexpr size_t Length(const char *name)
+    {
+        size_t length = 0;
+        while (name[length] != '\0')
+            length++;
+        return length;
+    }
+};
+
+constexpr UniformName operator""_uniform(const char *name, size_t)
+{
+    return UniformName(name);
+}
+
+// the active uniforms of a linked program, introspected once. Arrays are registered under "name", "name[0]" and
+// every "name[i]", array-of-struct members under their full "name[i].member" path, as glGetUniformLocation accepts them.
+class UniformTable
+{
+public:
+    void Build(GLuint program)
+    {
+        slots.clear();
+        GLint count = 0, maxLength = 0;
+        glGetProgramiv(program, GL_ACTIVE_UNIFORMS, &count);
+        glGetProgramiv(program, GL_ACTIVE_UNIFORM_MAX_LENGTH, &maxLength);
+
+        std::vector<std::pair<uint64_t, GLint>> entries;
+        std::vector<GLchar> buffer(maxLength > 0 ? maxLength : 1);
+        for (GLint i = 0; i < count; i++)
+        {
+            GLsizei length = 0;
+            GLint size = 0;
+            GLenum type;
+            glGetActiveUniform(program, static_cast<GLuint>(i), static_cast<GLsizei>(buffer.size()), &length, &size, &type, buffer.data());
+            std::string name(buffer.data(), length);
+            GLint location = glGetUniformLocation(program, name.c_str());
+            if (location == -1)
+                continue; // lives in a uniform block, not settable with glUniform*
+            entries.push_back({ UniformName(name).hash, location });
+
+            // arrays are reported as "name[0]"
+            if (size > 1 || (name.size() > 3 && name.compare(name.size() - 3, 3, "[0]") == 0))
+            {
+                std::string base = name.substr(0, name.find_last_of('['));
+                entries.push_back({ UniformName(base).hash, location });
+                for (GLint element = 0; element < size; element++)
+                {
+                    std::string elementName = base + '[' + std::to_string(element) + ']';
+                    entries.push_back({ UniformName(elementName).hash, glGetUniformLocation(program, elementName.c_str()) });
+                }
+            }
+        }
+
+        // open addressing with linear probing at most half full
+        size_t capacity = 16;
+        while (capacity < entries.size() * 2)
+            capacity *= 2;
+        slots.assign(capacity, Slot{ 0, Empty });
+        mask = capacity - 1;
+        for (const auto &entry : entries)
+        {
+            size_t index = entry.first & mask;
+            while (slots[index].location != Empty && slots[index].hash != entry.first)
+                index = (index + 1) & mask;
+            slots[index] = Slot{ entry.first, entry.second };
+        }
+    }
+
+    // location of the uniform, -1 for names the program doesn't have (which glUniform* ignores)
+    GLint Location(UniformName name) const
+    {
+        if (slots.empty())
+            return -1;
+        for (size_t index = name.hash & mask; ; index = (index + 1) & mask)
+        {
+            const Slot &slot = slots[index];
+            if (slot.hash == name.hash && slot.location != Empty)
+                return slot.location;
+            if (slot.location == Empty)
+                return -1;
+        }
+    }
+
+    size_t Size() const
+    {
+        size_t size = 0;
+        for (const Slot &slot : slots)
+            size += slot.location != Empty;
+        return size;
+    }
+
+private:
+    static const GLint Empty = -2;
+
+    struct Slot
+    {
+        uint64_t hash;
+        GLint location;
+    };
+
+    std::vector<Slot> slots;
+    size_t mask = 0;
+};
+#endif
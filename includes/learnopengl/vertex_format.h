@@ -0,0 +1,144 @@
+#ifndef VERTEX_FORMAT_H
+#define VERTEX_FORMAT_H
+
+#include <glad/glad.h>
+
+#include <glm/glm.hpp>
+
+#include <cstddef>
+#include <cstdint>
+#include <iterator>
+#include <utility>
+
+#define MAX_BONE_INFLUENCE 4
+
+// vertex of a static mesh. The bitangent is not stored: it is cross(Normal, Tangent.xyz) * Tangent.w
+struct StaticVertex {
+    // position
+    glm::vec3 Position;
+    // normal
+    glm::vec3 Normal;
+    // texCoords
+    glm::vec2 TexCoords;
+    // tangent, w holds the handedness of the tangent frame (+1 or -1)
+    glm::vec4 Tangent;
+};
+
+// vertex of a skinned mesh, carries the full tangent frame plus bone influences
+struct SkinnedVertex {
+    // position
+    glm::vec3 Position;
+    // normal
+    glm::vec3 Normal;
+    // texCoords
+    glm::vec2 TexCoords;
+    // tangent
+    glm::vec3 Tangent;
+    // bitangent
+    glm::vec3 Bitangent;
+	//bone indexes which will influence this vertex
+	int m_BoneIDs[MAX_BONE_INFLUENCE];
+	//weights from each bone
+	float m_Weights[MAX_BONE_INFLUENCE];
+};
+
+// compressed vertex of a static mesh (see vertex_packing.h for the encoders and the matching GLSL decode).
+// QTangent is the whole tangent frame as a snorm16 quaternion, the sign of w is the bitangent handedness.
+struct PackedVertex {
+    glm::vec3 Position;
+    int16_t   QTangent[4];
+    uint16_t  TexCoords[2]; // half float
+};
+
+// as PackedVertex, with the position quantised to unorm16 inside the mesh bounds.
+// the shader restores it as positionOffset + aPos * positionScale.
+struct QuantizedVertex {
+    uint16_t  Position[4];  // w is padding
+    int16_t   QTangent[4];
+    uint16_t  TexCoords[2]; // half float
+};
+
+// describes one vertex attribute as handed to glVertexAttrib(I)Pointer
+struct VertexAttribute {
+    GLuint    location;
+    GLint     size;       // number of components
+    GLenum    type;
+    GLboolean normalized;
+    bool      integer;    // read as an integer attribute in the shader (glVertexAttribIPointer)
+    size_t    offset;
+};
+
+// vertex format descriptors: one specialisation per vertex type, listing its attributes.
+// SetupVertexAttributes<VertexT>() is generated from this list at compile time.
+template<typename VertexT>
+struct VertexFormat;
+
+template<>
+struct VertexFormat<StaticVertex> {
+    static constexpr bool quantizedPosition = false;
+    static constexpr VertexAttribute attributes[] = {
+        { 0, 3, GL_FLOAT, GL_FALSE, false, offsetof(StaticVertex, Position) },
+        { 1, 3, GL_FLOAT, GL_FALSE, false, offsetof(StaticVertex, Normal) },
+        { 2, 2, GL_FLOAT, GL_FALSE, false, offsetof(StaticVertex, TexCoords) },
+        { 3, 4, GL_FLOAT, GL_FALSE, false, offsetof(StaticVertex, Tangent) },
+    };
+};
+
+template<>
+struct VertexFormat<SkinnedVertex> {
+    static constexpr bool quantizedPosition = false;
+    static constexpr VertexAttribute attributes[] = {
+        { 0, 3, GL_FLOAT, GL_FALSE, false, offsetof(SkinnedVertex, Position) },
+        { 1, 3, GL_FLOAT, GL_FALSE, false, offsetof(SkinnedVertex, Normal) },
+        { 2, 2, GL_FLOAT, GL_FALSE, false, offsetof(SkinnedVertex, TexCoords) },
+        { 3, 3, GL_FLOAT, GL_FALSE, false, offsetof(SkinnedVertex, Tangent) },
+        { 4, 3, GL_FLOAT, GL_FALSE, false, offsetof(SkinnedVertex, Bitangent) },
+        { 5, MAX_BONE_INFLUENCE, GL_INT, GL_FALSE, true, offsetof(SkinnedVertex, m_BoneIDs) },
+        { 6, MAX_BONE_INFLUENCE, GL_FLOAT, GL_FALSE, false, offsetof(SkinnedVertex, m_Weights) },
+    };
+};
+
+template<>
+struct VertexFormat<PackedVertex> {
+    static constexpr bool quantizedPosition = false;
+    static constexpr VertexAttribute attributes[] = {
+        { 0, 3, GL_FLOAT, GL_FALSE, false, offsetof(PackedVertex, Position) },
+        { 1, 4, GL_SHORT, GL_TRUE, false, offsetof(PackedVertex, QTangent) },
+        { 2, 2, GL_HALF_FLOAT, GL_FALSE, false, offsetof(PackedVertex, TexCoords) },
+    };
+};
+
+template<>
+struct VertexFormat<QuantizedVertex> {
+    static constexpr bool quantizedPosition = true;
+    static constexpr VertexAttribute attributes[] = {
+        { 0, 4, GL_UNSIGNED_SHORT, GL_TRUE, false, offsetof(QuantizedVertex, Position) },
+        { 1, 4, GL_SHORT, GL_TRUE, false, offsetof(QuantizedVertex, QTangent) },
+        { 2, 2, GL_HALF_FLOAT, GL_FALSE, false, offsetof(QuantizedVertex, TexCoords) },
+    };
+};
+
+template<typename VertexT, size_t I>
+void SetupVertexAttribute()
+{
+    constexpr VertexAttribute attribute = VertexFormat<VertexT>::attributes[I];
+    glEnableVertexAttribArray(attribute.location);
+    if constexpr (attribute.integer)
+        glVertexAttribIPointer(attribute.location, attribute.size, attribute.type, sizeof(VertexT), (void*)attribute.offset);
+    else
+        glVertexAttribPointer(attribute.location, attribute.size, attribute.type, attribute.normalized, sizeof(VertexT), (void*)attribute.offset);
+}
+
+template<typename VertexT, size_t... I>
+void SetupVertexAttributes(std::index_sequence<I...>)
+{
+    (SetupVertexAttribute<VertexT, I>(), ...);
+}
+
+// points the attributes of the bound VAO at the bound GL_ARRAY_BUFFER, one call per attribute of the vertex format
+template<typename VertexT>
+void SetupVertexAttributes()
+{
+    SetupVertexAttributes<VertexT>(std::make_index_sequence<std::size(VertexFormat<VertexT>::attributes)>());
+}
+#endif
@@ -0,0 +1,394 @@
+#ifndef VERTEX_PACKING_H
+#define VERTEX_PACKING_H
+
+#include <glm/glm.hpp>
+#include <glm/gtc/quaternion.hpp>
+
+#include <learnopengl/mesh.h>
+#include <learnopengl/simd.h>
+
+#include <algorithm>
+#include <cmath>
+#include <cstdint>
+#include <cstring>
+#include <limits>
+#include <ostream>
+#include <vector>
+
+// Opt-in compressed vertex encodings for static meshes:
+//   PackedVertex    float3 position | snorm16x4 QTangent | half2 uv  = 24 bytes
+//   QuantizedVertex unorm16x4 position in the mesh AABB | snorm16x4 QTangent | half2 uv = 20 bytes
+// against 48 bytes for StaticVertex. The shader side decodes them like this:
+//
+//   layout (location = 0) in vec4 aPos;       // for PackedVertex: in vec3 aPos and skip the dequantisation
+//   layout (location = 1) in vec4 aQTangent;
+//   layout (location = 2) in vec2 aTexCoords;
+//   uniform vec3 positionOffset;
+//   uniform vec3 positionScale;
+//
+//   vec3 quatRotate(vec4 q, vec3 v) { return v + 2.0 * cross(q.xyz, cross(q.xyz, v) + q.w * v); }
+//
+//   vec3 position  = positionOffset + aPos.xyz * positionScale;
+//   vec4 q         = normalize(aQTangent);
+//   vec3 normal    = quatRotate(q, vec3(0.0, 0.0, 1.0));
+//   vec3 tangent   = quatRotate(q, vec3(1.0, 0.0, 0.0));
+//   vec3 bitangent = cross(normal, tangent) * (aQTangent.w < 0.0 ? -1.0 : 1.0);
+
+// quantisation error and memory of one packed mesh, see VertexPacking::Pack
+struct PackingReport
+{
+    size_t vertexCount = 0;
+    size_t bytesBefore = 0;         // as StaticVertex
+    size_t bytesAfter = 0;
+    float  maxPositionError = 0.0f; // object space units
+    float  maxNormalError = 0.0f;   // degrees
+    float  meanNormalError = 0.0f;  // degrees
+    float  maxTangentError = 0.0f;  // degrees
+    float  maxTexCoordError = 0.0f;
+    size_t handednessErrors = 0;
+
+    // accumulates another mesh so a whole model can be summarised in one report
+    void merge(const PackingReport &other)
+    {
+        if (vertexCount + other.vertexCount > 0)
+            meanNormalError = (meanNormalError * vertexCount + other.meanNormalError * other.vertexCount) / (vertexCount + other.vertexCount);
+        vertexCount += other.vertexCount;
+        bytesBefore += other.bytesBefore;
+        bytesAfter += other.bytesAfter;
+        maxPositionError = std::max(maxPositionError, other.maxPositionError);
+        maxNormalError = std::max(maxNormalError, other.maxNormalError);
+        maxTangentError = std::max(maxTangentError, other.maxTangentError);
+        maxTexCoordError = std::max(maxTexCoordError, other.maxTexCoordError);
+        handednessErrors += other.handednessErrors;
+    }
+};
+
+inline std::ostream& operator<<(std::ostream &out, const PackingReport &report)
+{
+    return out << report.vertexCount << " vertices, " << report.bytesBefore << " -> " << report.bytesAfter << " bytes ("
+               << (report.bytesBefore ? 100.0 * report.bytesAfter / report.bytesBefore : 0.0) << "%), max position error "
+               << report.maxPositionError << ", normal error max/mean " << report.maxNormalError << "/" << report.meanNormalError
+               << " deg, max tangent error " << report.maxTangentError << " deg, max uv error " << report.maxTexCoordError
+               << ", handedness errors " << report.handednessErrors;
+}
+
+class VertexPacking
+{
+public:
+    // converts a static mesh into one of the packed formats. Optionally measures the error against the source.
+    template<typename PackedT>
+    static BasicMesh<PackedT> Pack(const Mesh &mesh, PackingReport *report = nullptr)
+    {
+        const size_t count = mesh.vertices.size();
+
+        // gather the streams the batch encoders work on
+        std::vector<float> uvs(count * 2), frames(count * 4), positions(count * 4);
+        glm::vec3 minPos(std::numeric_limits<float>::max()), maxPos(-std::numeric_limits<float>::max());
+        for (size_t i = 0; i < count; i++)
+        {
+            const StaticVertex &v = mesh.vertices[i];
+            uvs[i * 2 + 0] = v.TexCoords.x;
+            uvs[i * 2 + 1] = v.TexCoords.y;
+            glm::quat q = EncodeQTangent(v.Normal, v.Tangent);
+            frames[i * 4 + 0] = q.x;
+            frames[i * 4 + 1] = q.y;
+            frames[i * 4 + 2] = q.z;
+            frames[i * 4 + 3] = q.w;
+            positions[i * 4 + 0] = v.Position.x;
+            positions[i * 4 + 1] = v.Position.y;
+            positions[i * 4 + 2] = v.Position.z;
+            positions[i * 4 + 3] = 0.0f;
+            minPos = glm::min(minPos, v.Position);
+            maxPos = glm::max(maxPos, v.Position);
+        }
+        if (count == 0)
+            minPos = maxPos = glm::vec3(0.0f);
+
+        std::vector<uint16_t> halfUVs(count * 2), quantizedPositions;
+        std::vector<int16_t> snormFrames(count * 4);
+        FloatToHalf(uvs.data(), halfUVs.data(), uvs.size());
+        FloatToSnorm16(frames.data(), snormFrames.data(), frames.size());
+
+        glm::vec3 scale = maxPos - minPos;
+        for (int c = 0; c < 3; c++)
+            if (scale[c] <= 0.0f)
+                scale[c] = 1.0f;
+        if (VertexFormat<PackedT>::quantizedPosition)
+        {
+            quantizedPositions.resize(count * 4);
+            QuantizeUnorm16(positions.data(), quantizedPositions.data(), count, minPos, scale);
+        }
+
+        std::vector<PackedT> packed(count);
+        for (size_t i = 0; i < count; i++)
+        {
+            PackedT &v = packed[i];
+            if constexpr (VertexFormat<PackedT>::quantizedPosition)
+                std::memcpy(v.Position, &quantizedPositions[i * 4], sizeof(v.Position));
+            else
+                v.Position = mesh.vertices[i].Position;
+            std::memcpy(v.QTangent, &snormFrames[i * 4], sizeof(v.QTangent));
+            std::memcpy(v.TexCoords, &halfUVs[i * 2], sizeof(v.TexCoords));
+        }
+
+        if (report)
+            *report = Measure(mesh, packed, minPos, scale);
+
+        BasicMesh<PackedT> result(packed, mesh.indices, mesh.textures);
+        if constexpr (VertexFormat<PackedT>::quantizedPosition)
+        {
+            result.positionOffset = minPos;
+            result.positionScale = scale;
+        }
+        return result;
+    }
+
+    // tangent frame -> quaternion whose w is never zero, so its sign can carry the bitangent handedness
+    static glm::quat EncodeQTangent(const glm::vec3 &normal, const glm::vec4 &tangent)
+    {
+        glm::vec3 n = SafeNormalize(normal, glm::vec3(0.0f, 0.0f, 1.0f));
+        // orthonormalise the tangent against the normal, invent one if the mesh has none
+        glm::vec3 t = glm::vec3(tangent) - n * glm::dot(n, glm::vec3(tangent));
+        if (glm::dot(t, t) < 1e-12f)
+            t = std::abs(n.x) < 0.9f ? glm::cross(glm::vec3(1.0f, 0.0f, 0.0f), n) : glm::cross(glm::vec3(0.0f, 1.0f, 0.0f), n);
+        t = glm::normalize(t);
+        glm::vec3 b = glm::cross(n, t);
+
+        glm::quat q = glm::normalize(glm::quat_cast(glm::mat3(t, b, n)));
+        if (q.w < 0.0f)
+            q = -q;
+        // keep |w| above the smallest snorm16 step so the sign survives quantisation
+        const float bias = 1.0f / 32767.0f;
+        if (q.w < bias)
+        {
+            const float factor = std::sqrt(1.0f - bias * bias);
+            q = glm::quat(bias, q.x * factor, q.y * factor, q.z * factor);
+        }
+        if (tangent.w < 0.0f)
+            q = -q;
+        return q;
+    }
+
+    // inverse of EncodeQTangent, returns the normal and the tangent with handedness in w
+    static void DecodeQTangent(glm::quat q, glm::vec3 &normal, glm::vec4 &tangent)
+    {
+        const float handedness = q.w < 0.0f ? -1.0f : 1.0f;
+        q = glm::normalize(q);
+        normal = q * glm::vec3(0.0f, 0.0f, 1.0f);
+        tangent = glm::vec4(q * glm::vec3(1.0f, 0.0f, 0.0f), handedness);
+    }
+
+    // batch float -> half conversion, round to nearest even
+    static void FloatToHalf(const float *in, uint16_t *out, size_t count)
+    {
+        size_t i = 0;
+#ifdef LOGL_SSE2
+        for (; i + 8 <= count; i += 8)
+        {
+            __m128i a = FloatToHalf4(_mm_loadu_ps(in + i));
+            __m128i b = FloatToHalf4(_mm_loadu_ps(in + i + 4));
+            // sign extend the low 16 bits so the saturating pack keeps them intact
+            a = _mm_srai_epi32(_mm_slli_epi32(a, 16), 16);
+            b = _mm_srai_epi32(_mm_slli_epi32(b, 16), 16);
+            _mm_storeu_si128(reinterpret_cast<__m128i*>(out + i), _mm_packs_epi32(a, b));
+        }
+#endif
+        for (; i < count; i++)
+            out[i] = FloatToHalf(in[i]);
+    }
+
+    static uint16_t FloatToHalf(float value)
+    {
+        uint32_t x;
+        std::memcpy(&x, &value, 4);
+        const uint32_t sign = x & 0x80000000u;
+        x ^= sign;
+        uint32_t result;
+        if (x >= 0x47800000u) // overflows to infinity, or is NaN
+            result = x > 0x7f800000u ? 0x7e00u : 0x7c00u;
+        else if (x < 0x38800000u) // subnormal or zero: let the FPU align the mantissa
+        {
+            float f;
+            std::memcpy(&f, &x, 4);
+            f += Magic();
+            std::memcpy(&result, &f, 4);
+            result -= 126u << 23;
+        }
+        else
+        {
+            const uint32_t mantissaOdd = (x >> 13) & 1u;
+            x += ((15u - 127u) << 23) + 0xfffu + mantissaOdd;
+            result = x >> 13;
+        }
+        return static_cast<uint16_t>(result | (sign >> 16));
+    }
+
+    static float HalfToFloat(uint16_t value)
+    {
+        const uint32_t sign = uint32_t(value & 0x8000u) << 16;
+        const uint32_t exponent = (value >> 10) & 0x1fu;
+        const uint32_t mantissa = value & 0x3ffu;
+        float result;
+        if (exponent == 0)
+            result = std::ldexp(static_cast<float>(mantissa), -24);
+        else if (exponent == 31)
+            result = mantissa ? std::numeric_limits<float>::quiet_NaN() : std::numeric_limits<float>::infinity();
+        else
+            result = std::ldexp(static_cast<float>(mantissa | 0x400u), int(exponent) - 25);
+        uint32_t bits;
+        std::memcpy(&bits, &result, 4);
+        bits |= sign;
+        std::memcpy(&result, &bits, 4);
+        return result;
+    }
+
+    // batch [-1, 1] float -> snorm16. Both paths round half to even, as _mm_cvtps_epi32 does in the default mode
+    static void FloatToSnorm16(const float *in, int16_t *out, size_t count)
+    {
+        size_t i = 0;
+#ifdef LOGL_SSE2
+        const __m128 one = _mm_set1_ps(1.0f), minusOne = _mm_set1_ps(-1.0f), range = _mm_set1_ps(32767.0f);
+        for (; i + 8 <= count; i += 8)
+        {
+            __m128 a = _mm_mul_ps(_mm_min_ps(_mm_max_ps(_mm_loadu_ps(in + i), minusOne), one), range);
+            __m128 b = _mm_mul_ps(_mm_min_ps(_mm_max_ps(_mm_loadu_ps(in + i + 4), minusOne), one), range);
+            _mm_storeu_si128(reinterpret_cast<__m128i*>(out + i), _mm_packs_epi32(_mm_cvtps_epi32(a), _mm_cvtps_epi32(b)));
+        }
+#endif
+        for (; i < count; i++)
+            out[i] = static_cast<int16_t>(std::nearbyint(std::min(std::max(in[i], -1.0f), 1.0f) * 32767.0f));
+    }
+
+    static float Snorm16ToFloat(int16_t value)
+    {
+        return std::max(value / 32767.0f, -1.0f);
+    }
+
+    // quantises xyz_ position quadruples to unorm16 inside [offset, offset + scale], rounding half to even
+    static void QuantizeUnorm16(const float *in, uint16_t *out, size_t count, const glm::vec3 &offset, const glm::vec3 &scale)
+    {
+        size_t i = 0;
+#ifdef LOGL_SSE2
+        const __m128 origin = _mm_setr_ps(offset.x, offset.y, offset.z, 0.0f);
+        const __m128 factor = _mm_setr_ps(65535.0f / scale.x, 65535.0f / scale.y, 65535.0f / scale.z, 0.0f);
+        const __m128 zero = _mm_setzero_ps(), top = _mm_set1_ps(65535.0f);
+        const __m128i bias = _mm_set1_epi32(32768);
+        const __m128i flip = _mm_set1_epi16(static_cast<short>(0x8000));
+        for (; i + 2 <= count; i += 2)
+        {
+            __m128 a = _mm_min_ps(_mm_max_ps(_mm_mul_ps(_mm_sub_ps(_mm_loadu_ps(in + i * 4), origin), factor), zero), top);
+            __m128 b = _mm_min_ps(_mm_max_ps(_mm_mul_ps(_mm_sub_ps(_mm_loadu_ps(in + i * 4 + 4), origin), factor), zero), top);
+            // shift into the signed range for the saturating pack, then flip the top bit back
+            __m128i packed = _mm_packs_epi32(_mm_sub_epi32(_mm_cvtps_epi32(a), bias), _mm_sub_epi32(_mm_cvtps_epi32(b), bias));
+            _mm_storeu_si128(reinterpret_cast<__m128i*>(out + i * 4), _mm_xor_si128(packed, flip));
+        }
+#endif
+        for (; i < count; i++)
+        {
+            for (int c = 0; c < 3; c++)
+            {
+                float v = (in[i * 4 + c] - offset[c]) * (65535.0f / scale[c]);
+                out[i * 4 + c] = static_cast<uint16_t>(std::nearbyint(std::min(std::max(v, 0.0f), 65535.0f)));
+            }
+            out[i * 4 + 3] = 0;
+        }
+    }
+
+private:
+    static float Magic()
+    {
+        const uint32_t bits = 126u << 23;
+        float f;
+        std::memcpy(&f, &bits, 4);
+        return f;
+    }
+
+#ifdef LOGL_SSE2
+    // four lanes of FloatToHalf(float), results in the low 16 bits of each lane
+    static __m128i FloatToHalf4(__m128 value)
+    {
+        const __m128i x0 = _mm_castps_si128(value);
+        const __m128i sign = _mm_and_si128(x0, _mm_set1_epi32(static_cast<int>(0x80000000u)));
+        const __m128i x = _mm_xor_si128(x0, sign);
+
+        const __m128i isInfNan = _mm_cmpgt_epi32(x, _mm_set1_epi32(0x477fffff));
+        const __m128i isNan = _mm_cmpgt_epi32(x, _mm_set1_epi32(0x7f800000));
+        const __m128i infNan = _mm_or_si128(_mm_set1_epi32(0x7c00), _mm_and_si128(isNan, _mm_set1_epi32(0x0200)));
+
+        const __m128i isSubnormal = _mm_cmpgt_epi32(_mm_set1_epi32(0x38800000), x);
+        const __m128i subnormal = _mm_sub_epi32(_mm_castps_si128(_mm_add_ps(_mm_castsi128_ps(x), _mm_set1_ps(Magic()))),
+                                                _mm_set1_epi32(126 << 23));
+
+        const __m128i mantissaOdd = _mm_and_si128(_mm_srli_epi32(x, 13), _mm_set1_epi32(1));
+        __m128i normal = _mm_add_epi32(x, _mm_set1_epi32(static_cast<int>(((15u - 127u) << 23) + 0xfffu)));
+        normal = _mm_srli_epi32(_mm_add_epi32(normal, mantissaOdd), 13);
+
+        __m128i result = _mm_or_si128(_mm_and_si128(isSubnormal, subnormal), _mm_andnot_si128(isSubnormal, normal));
+        result = _mm_or_si128(_mm_and_si128(isInfNan, infNan), _mm_andnot_si128(isInfNan, result));
+        return _mm_or_si128(result, _mm_srli_epi32(sign, 16));
+    }
+#endif
+
+    static glm::vec3 SafeNormalize(const glm::vec3 &v, const glm::vec3 &fallback)
+    {
+        const float length2 = glm::dot(v, v);
+        return length2 > 1e-20f ? v / std::sqrt(length2) : fallback;
+    }
+
+    static float AngleDegrees(const glm::vec3 &a, const glm::vec3 &b)
+    {
+        return glm::degrees(std::acos(std::min(std::max(glm::dot(a, b), -1.0f), 1.0f)));
+    }
+
+    template<typename PackedT>
+    static PackingReport Measure(const Mesh &mesh, const std::vector<PackedT> &packed, const glm::vec3 &offset, const glm::vec3 &scale)
+    {
+        PackingReport report;
+        report.vertexCount = packed.size();
+        report.bytesBefore = packed.size() * sizeof(StaticVertex);
+        report.bytesAfter = packed.size() * sizeof(PackedT);
+        double normalErrorSum = 0.0;
+        size_t normalCount = 0;
+        for (size_t i = 0; i < packed.size(); i++)
+        {
+            const StaticVertex &source = mesh.vertices[i];
+            const PackedT &v = packed[i];
+
+            glm::vec3 position;
+            if constexpr (VertexFormat<PackedT>::quantizedPosition)
+                position = offset + glm::vec3(v.Position[0], v.Position[1], v.Position[2]) / 65535.0f * scale;
+            else
+                position = v.Position;
+            report.maxPositionError = std::max(report.maxPositionError, glm::length(position - source.Position));
+
+            glm::vec3 normal;
+            glm::vec4 tangent;
+            DecodeQTangent(glm::quat(Snorm16ToFloat(v.QTangent[3]), Snorm16ToFloat(v.QTangent[0]),
+                                     Snorm16ToFloat(v.QTangent[1]), Snorm16ToFloat(v.QTangent[2])), normal, tangent);
+            if (glm::dot(source.Normal, source.Normal) > 1e-20f)
+            {
+                float error = AngleDegrees(glm::normalize(source.Normal), normal);
+                report.maxNormalError = std::max(report.maxNormalError, error);
+                normalErrorSum += error;
+                normalCount++;
+            }
+            glm::vec3 sourceTangent = glm::vec3(source.Tangent);
+            if (glm::dot(sourceTangent, sourceTangent) > 1e-20f)
+            {
+                // compare against the orthonormalised source tangent, that is what the encoding is defined on
+                glm::vec3 n = SafeNormalize(source.Normal, glm::vec3(0.0f, 0.0f, 1.0f));
+                glm::vec3 t = sourceTangent - n * glm::dot(n, sourceTangent);
+                if (glm::dot(t, t) > 1e-20f)
+                    report.maxTangentError = std::max(report.maxTangentError, AngleDegrees(glm::normalize(t), glm::vec3(tangent)));
+                if ((source.Tangent.w < 0.0f) != (tangent.w < 0.0f))
+                    report.handednessErrors++;
+            }
+
+            report.maxTexCoordError = std::max(report.maxTexCoordError,
+                std::max(std::abs(HalfToFloat(v.TexCoords[0]) - source.TexCoords.x), std::abs(HalfToFloat(v.TexCoords[1]) - source.TexCoords.y)));
+        }
+        report.meanNormalError = normalCount ? static_cast<float>(normalErrorSum / normalCount) : 0.0f;
+        return report;
+    }
+};
+#endif
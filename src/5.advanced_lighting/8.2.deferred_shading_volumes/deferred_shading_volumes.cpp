@@ -160,6 +160,14 @@ int main()
         float bColor = static_cast<float>(((rand() % 100) / 200.0f) + 0.5); // between 0.5 and 1.)
         lightColors.push_back(glm::vec3(rColor, gColor, bColor));
     }
+    // hash the per light uniform names once instead of building strings every frame
+    struct LightUniforms { UniformName position, color, linear, quadratic, radius; };
+    std::vector<LightUniforms> lightUniforms;
+    for (unsigned int i = 0; i < NR_LIGHTS; i++)
+    {
+        std::string light = "lights[" + std::to_string(i) + "]";
+        lightUniforms.push_back({ light + ".Position", light + ".Color", light + ".Linear", light + ".Quadratic", light + ".Radius" });
+    }
 
     // shader configuration
     // --------------------
@@ -220,18 +228,18 @@ int main()
         // send light relevant uniforms
         for (unsigned int i = 0; i < lightPositions.size(); i++)
         {
-            shaderLightingPass.setVec3("lights[" + std::to_string(i) + "].Position", lightPositions[i]);
-            shaderLightingPass.setVec3("lights[" + std::to_string(i) + "].Color", lightColors[i]);
+            shaderLightingPass.setVec3(lightUniforms[i].position, lightPositions[i]);
+            shaderLightingPass.setVec3(lightUniforms[i].color, lightColors[i]);
             // update attenuation parameters and calculate radius
             const float constant = 1.0f; // note that we don't send this to the shader, we assume it is always 1.0 (in our case)
             const float linear = 0.7f;
             const float quadratic = 1.8f;
-            shaderLightingPass.setFloat("lights[" + std::to_string(i) + "].Linear", linear);
-            shaderLightingPass.setFloat("lights[" + std::to_string(i) + "].Quadratic", quadratic);
+            shaderLightingPass.setFloat(lightUniforms[i].linear, linear);
+            shaderLightingPass.setFloat(lightUniforms[i].quadratic, quadratic);
             // then calculate radius of light volume/sphere
             const float maxBrightness = std::fmaxf(std::fmaxf(lightColors[i].r, lightColors[i].g), lightColors[i].b);
             float radius = (-linear + std::sqrt(linear * linear - 4 * quadratic * (constant - (256.0f / 5.0f) * maxBrightness))) / (2.0f * quadratic);
-            shaderLightingPass.setFloat("lights[" + std::to_string(i) + "].Radius", radius);
+            shaderLightingPass.setFloat(lightUniforms[i].radius, radius);
         }
         shaderLightingPass.setVec3("viewPos", camera.Position);
         // finally render quad
@@ -180,6 +180,10 @@ int main()
         sample *= scale;
         ssaoKernel.push_back(sample);
     }
+    // hash the sample uniform names once instead of building strings every frame
+    std::vector<UniformName> ssaoKernelNames;
+    for (unsigned int i = 0; i < 64; ++i)
+        ssaoKernelNames.push_back("samples[" + std::to_string(i) + "]");
 
     // generate noise texture
     // ----------------------
@@ -270,7 +274,7 @@ int main()
             shaderSSAO.use();
             // Send kernel + rotation 
             for (unsigned int i = 0; i < 64; ++i)
-                shaderSSAO.setVec3("samples[" + std::to_string(i) + "]", ssaoKernel[i]);
+                shaderSSAO.setVec3(ssaoKernelNames[i], ssaoKernel[i]);
             shaderSSAO.setMat4("projection", projection);
             glActiveTexture(GL_TEXTURE0);
             glBindTexture(GL_TEXTURE_2D, gPosition);
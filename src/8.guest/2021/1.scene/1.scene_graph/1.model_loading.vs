@@ -2,15 +2,17 @@
 layout (location = 0) in vec3 aPos;
 layout (location = 1) in vec3 aNormal;
 layout (location = 2) in vec2 aTexCoords;
+layout (location = 8) in mat4 aInstanceModel; // read instead of model when instanced is set
 
 out vec2 TexCoords;
 
 uniform mat4 model;
 uniform mat4 view;
 uniform mat4 projection;
+uniform bool instanced;
 
 void main()
 {
     TexCoords = aTexCoords;    
-    gl_Position = projection * view * model * vec4(aPos, 1.0);
+    gl_Position = projection * view * (instanced ? aInstanceModel : model) * vec4(aPos, 1.0);
 }
\ No newline at end of file
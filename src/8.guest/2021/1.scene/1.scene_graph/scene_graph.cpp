@@ -118,6 +118,7 @@ int main()
 		}
 	}
 	ourEntity.updateSelfAndChild();
+	RenderQueue renderQueue;
 
 	// draw in wireframe
 	//glPolygonMode(GL_FRONT_AND_BACK, GL_LINE);
@@ -150,14 +151,16 @@ int main()
 		ourShader.setMat4("projection", projection);
 		ourShader.setMat4("view", view);
 
-		// draw our scene graph
+		// draw our scene graph, the queue sorts the draws by state before submitting them
+		renderQueue.Begin(camera.Position, 100.0f);
 		Entity* lastEntity = &ourEntity;
 		while (lastEntity->children.size())
 		{
-			ourShader.setMat4("model", lastEntity->transform.getModelMatrix());
-			lastEntity->pModel->Draw(ourShader);
+			renderQueue.Push(0, ourShader, *lastEntity->pModel, lastEntity->transform.getModelMatrix());
 			lastEntity = lastEntity->children.back().get();
 		}
+		renderQueue.Sort();
+		renderQueue.Submit();
 
 		ourEntity.transform.setLocalRotation({ 0.f, ourEntity.transform.getLocalRotation().y + 20 * deltaTime, 0.f });
 		ourEntity.updateSelfAndChild();
@@ -168,6 +171,8 @@ int main()
 		glfwPollEvents();
 	}
 
+	renderQueue.Release();
+
 	// glfw: terminate, clearing all previously allocated GLFW resources.
 	// ------------------------------------------------------------------
 	glfwTerminate();
@@ -123,6 +123,9 @@ int main()
 		}
 	}
 	ourEntity.updateSelfAndChild();
+	EntityBVH sceneBVH(ourEntity);
+	OcclusionCuller occlusion;
+	RenderQueue renderQueue;
 
 	// draw in wireframe
 	//glPolygonMode(GL_FRONT_AND_BACK, GL_LINE);
@@ -164,11 +167,23 @@ int main()
 
 		// draw our scene graph
 		unsigned int total = 0, display = 0;
-		ourEntity.drawSelfAndChild(camFrustum, ourShader, display, total);
-		std::cout << "Total process in CPU : " << total << " / Total send to GPU : " << display << std::endl;
+		// the planets close to the camera hide most of the others, rasterise them on the CPU as occluders
+		occlusion.Begin(projection * view);
+		for (auto&& child : ourEntity.children)
+		{
+			if (glm::distance(glm::vec3(child->transform.getModelMatrix()[3]), camera.Position) < 30.f)
+				occlusion.AddOccluder(model, child->transform.getModelMatrix());
+		}
+		occlusion.Rasterize(JobSystem::Instance());
+		renderQueue.Begin(camera.Position, 100.0f);
+		sceneBVH.queueVisible(camFrustum, occlusion, ourShader, renderQueue, display, total);
+		renderQueue.Sort();
+		renderQueue.Submit();
+		std::cout << "Total process in CPU : " << total << " / Total send to GPU : " << display << " in " << renderQueue.stats.draws << " draws" << std::endl;
 
 		//ourEntity.transform.setLocalRotation({ 0.f, ourEntity.transform.getLocalRotation().y + 20 * deltaTime, 0.f });
 		ourEntity.updateSelfAndChild();
+		sceneBVH.refit();
 
 		// glfw: swap buffers and poll IO events (keys pressed/released, mouse moved etc.)
 		// -------------------------------------------------------------------------------
@@ -176,6 +191,8 @@ int main()
 		glfwPollEvents();
 	}
 
+	renderQueue.Release();
+
 	// glfw: terminate, clearing all previously allocated GLFW resources.
 	// ------------------------------------------------------------------
 	glfwTerminate();
@@ -0,0 +1,156 @@
+// Animator::UpdateAnimation over the node list Animation compiles on load, against the recursive evaluation it
+// replaced (a name lookup and a copy of the bone info map per node), on a synthetic Mixamo-like rig: a spine,
+// arms, legs and fingers, most nodes animated. Both must produce the same bone matrices every frame.
+// Argument after --quick: keys per channel (default 120).
+#include "benchmark.h"
+
+#include <glm/gtc/matrix_transform.hpp>
+#include <learnopengl/animator.h>
+
+#include <algorithm>
+#include <cmath>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <map>
+#include <random>
+#include <string>
+#include <vector>
+
+using namespace Benchmark;
+
+// the evaluation Animator used before it compiled the nodes
+class ReferenceAnimator
+{
+public:
+    explicit ReferenceAnimator(Animation *animation) : animation(animation), finalBoneMatrices(100, glm::mat4(1.0f)) {}
+
+    void UpdateAnimation(float dt)
+    {
+        currentTime += animation->GetTicksPerSecond() * dt;
+        currentTime = fmod(currentTime, animation->GetDuration());
+        CalculateBoneTransform(&animation->GetRootNode(), glm::mat4(1.0f));
+    }
+
+    void CalculateBoneTransform(const AssimpNodeData *node, glm::mat4 parentTransform)
+    {
+        std::string nodeName = node->name;
+        glm::mat4 nodeTransform = node->transformation;
+        Bone *bone = animation->FindBone(nodeName);
+        if (bone)
+        {
+            bone->Update(currentTime);
+            nodeTransform = bone->GetLocalTransform();
+        }
+        glm::mat4 globalTransformation = parentTransform * nodeTransform;
+
+        auto boneInfoMap = animation->GetBoneIDMap();
+        if (boneInfoMap.find(nodeName) != boneInfoMap.end())
+            finalBoneMatrices[boneInfoMap[nodeName].id] = globalTransformation * boneInfoMap[nodeName].offset;
+
+        for (int i = 0; i < node->childrenCount; i++)
+            CalculateBoneTransform(&node->children[i], globalTransformation);
+    }
+
+    Animation *animation;
+    std::vector<glm::mat4> finalBoneMatrices;
+    float currentTime = 0.0f;
+};
+
+// root with three limbs, two way branches near the root and the odd split further out, up to maxNodes nodes
+static aiNode* BuildNode(int depth, int maxNodes, std::mt19937 &rng, std::vector<std::string> &names)
+{
+    aiNode *node = new aiNode("mixamorig:Node" + std::to_string(names.size()));
+    names.push_back(node->mName.data);
+    node->mTransformation = aiMatrix4x4(1, 0, 0, 0, 0, 1, 0, 1, 0, 0, 1, 0, 0, 0, 0, 1);
+    int children = depth == 0 ? 3 : depth < 3 ? 2 : depth < 6 ? (rng() % 3 == 0 ? 2 : 1) : 0;
+    children = std::min(children, std::max(0, maxNodes - static_cast<int>(names.size())));
+    if (children > 0)
+    {
+        node->mNumChildren = children;
+        node->mChildren = new aiNode*[children];
+        for (int i = 0; i < children; i++)
+        {
+            node->mChildren[i] = BuildNode(depth + 1, maxNodes, rng, names);
+            node->mChildren[i]->mParent = node;
+        }
+    }
+    return node;
+}
+
+int main(int argc, char **argv)
+{
+    const bool quick = Quick(argc, argv);
+    unsigned int keys = 120;
+    for (int i = 1; i < argc; i++)
+        if (argv[i][0] != '-')
+            keys = static_cast<unsigned int>(std::strtoul(argv[i], nullptr, 10));
+    const int frames = quick ? 2000 : 20000;
+    const float dt = 1.0f / 60.0f;
+
+    // one channel per node except every fifth, 52 at most; the skin gave every animated bone an offset
+    std::mt19937 rng(9);
+    std::vector<std::string> names;
+    aiScene scene;
+    scene.mRootNode = BuildNode(0, 67, rng, names);
+    aiAnimation *clip = new aiAnimation();
+    clip->mDuration = 120.0;
+    clip->mTicksPerSecond = 30.0;
+    std::vector<aiNodeAnim*> channels;
+    std::map<std::string, BoneInfo> boneInfoMap;
+    int boneCount = 0;
+    for (size_t i = 0; i < names.size() && channels.size() < 52; i++)
+    {
+        if (i % 5 == 4)
+            continue;
+        aiNodeAnim *channel = new aiNodeAnim();
+        channel->mNodeName = aiString(names[i]);
+        channel->mNumPositionKeys = channel->mNumRotationKeys = channel->mNumScalingKeys = keys;
+        channel->mPositionKeys = new aiVectorKey[keys];
+        channel->mRotationKeys = new aiQuatKey[keys];
+        channel->mScalingKeys = new aiVectorKey[keys];
+        for (unsigned int k = 0; k < keys; k++)
+        {
+            const double time = k * clip->mDuration / std::max(1u, keys - 1);
+            const float a = 0.02f * k + i;
+            channel->mPositionKeys[k] = aiVectorKey(time, aiVector3D(0.0f, 1.0f + 0.01f * k, 0.0f));
+            channel->mRotationKeys[k] = aiQuatKey(time, aiQuaternion(std::cos(a), std::sin(a) * 0.3f, std::sin(a) * 0.5f, std::sin(a) * 0.1f));
+            channel->mScalingKeys[k] = aiVectorKey(time, aiVector3D(1.0f));
+        }
+        channels.push_back(channel);
+        boneInfoMap[names[i]] = BoneInfo{ boneCount++, glm::translate(glm::mat4(1.0f), glm::vec3(-1.0f, 0.0f, 0.5f * i)) };
+    }
+    clip->mNumChannels = static_cast<unsigned int>(channels.size());
+    clip->mChannels = new aiNodeAnim*[channels.size()];
+    std::copy(channels.begin(), channels.end(), clip->mChannels);
+    scene.mNumAnimations = 1;
+    scene.mAnimations = new aiAnimation*[1]{ clip };
+
+    Animation animation(&scene, boneInfoMap, boneCount);
+    Animator animator(&animation);
+    ReferenceAnimator reference(&animation);
+    std::printf("%zu nodes, %u channels, %u keys per channel\n", names.size(), clip->mNumChannels, keys);
+
+    // same clock on both, checked every frame
+    bool identical = true;
+    for (int f = 0; f < 200; f++)
+    {
+        animator.UpdateAnimation(dt);
+        reference.UpdateAnimation(dt);
+        identical = identical && std::memcmp(animator.GetFinalBoneMatrices().data(), reference.finalBoneMatrices.data(),
+                                             reference.finalBoneMatrices.size() * sizeof(glm::mat4)) == 0;
+    }
+    Check(identical, "ANIMATOR::BONE_MATRICES_DIFFER");
+
+    const auto referenceStart = Clock::now();
+    for (int f = 0; f < frames; f++)
+        reference.UpdateAnimation(dt);
+    const auto compiledStart = Clock::now();
+    for (int f = 0; f < frames; f++)
+        animator.UpdateAnimation(dt);
+    const auto end = Clock::now();
+    std::printf("  recursive, by name %8.2f us per character update\n  compiled nodes      %8.2f us per character update | %s\n",
+                Microseconds(referenceStart, compiledStart) / frames, Microseconds(compiledStart, end) / frames,
+                identical ? "bit identical" : "MISMATCH");
+    return Failures() != 0;
+}
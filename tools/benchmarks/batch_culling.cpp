@@ -0,0 +1,112 @@
+// BatchCulling::CullBoxes/CullSpheres against one virtual isOnFrustum() call per volume, the way entity.h tested
+// every entity before EntityBatch. Builds with whichever of AVX2/SSE2/scalar simd.h selects for the compiler flags.
+#include "benchmark.h"
+
+#include <learnopengl/batch_culling.h>
+
+#include <cstdio>
+#include <memory>
+#include <random>
+#include <vector>
+
+using namespace Benchmark;
+
+// same shape as BoundingVolume/AABB/Sphere in entity.h, world space already applied
+struct Volume
+{
+    virtual ~Volume() = default;
+    virtual bool isOnOrForwardPlane(const Plane &plane) const = 0;
+
+    bool isOnFrustum(const Frustum &frustum) const
+    {
+        return isOnOrForwardPlane(frustum.leftFace) && isOnOrForwardPlane(frustum.rightFace) &&
+               isOnOrForwardPlane(frustum.topFace) && isOnOrForwardPlane(frustum.bottomFace) &&
+               isOnOrForwardPlane(frustum.nearFace) && isOnOrForwardPlane(frustum.farFace);
+    }
+};
+
+struct Box : Volume
+{
+    glm::vec3 center, extents;
+    Box(const glm::vec3 &c, const glm::vec3 &e) : center(c), extents(e) {}
+
+    bool isOnOrForwardPlane(const Plane &plane) const final
+    {
+        const float r = extents.x * std::abs(plane.normal.x) + extents.y * std::abs(plane.normal.y) + extents.z * std::abs(plane.normal.z);
+        return -r <= plane.getSignedDistanceToPlane(center);
+    }
+};
+
+struct Ball : Volume
+{
+    glm::vec3 center;
+    float radius;
+    Ball(const glm::vec3 &c, float r) : center(c), radius(r) {}
+
+    bool isOnOrForwardPlane(const Plane &plane) const final
+    {
+        return plane.getSignedDistanceToPlane(center) > -radius;
+    }
+};
+
+template<typename CullF>
+static void Run(const char *name, size_t n, int reps, const std::vector<std::unique_ptr<Volume>> &volumes, const Frustum &frustum, CullF cull)
+{
+    std::vector<uint8_t> expected(n);
+    const auto virtualStart = Clock::now();
+    for (int r = 0; r < reps; r++)
+        for (size_t i = 0; i < n; i++)
+            expected[i] = volumes[i]->isOnFrustum(frustum);
+    const auto batchStart = Clock::now();
+    std::vector<uint64_t> mask(BatchCulling::MaskWords(n));
+    for (int r = 0; r < reps; r++)
+        cull(mask.data());
+    const auto end = Clock::now();
+
+    size_t visible = 0, mismatches = 0;
+    for (size_t i = 0; i < n; i++)
+    {
+        visible += expected[i];
+        mismatches += expected[i] != BatchCulling::IsVisible(mask.data(), i);
+    }
+    Check(mismatches == 0, "BATCH_CULLING::MISMATCH");
+    Check(n % 64 == 0 || (mask.back() >> (n % 64)) == 0, "BATCH_CULLING::TAIL_BITS_SET");
+    std::printf("  %-7s %7zu: virtual %7.2f ms, batch %6.2f ms, %zu visible, %zu mismatches\n", name, n,
+                Milliseconds(virtualStart, batchStart) / reps, Milliseconds(batchStart, end) / reps, visible, mismatches);
+}
+
+int main(int argc, char **argv)
+{
+    const bool quick = Quick(argc, argv);
+#if defined(LOGL_AVX2)
+    std::printf("AVX2 path\n");
+#elif defined(LOGL_SSE2)
+    std::printf("SSE2 path\n");
+#else
+    std::printf("scalar path\n");
+#endif
+    const Frustum frustum = MakeFrustum(glm::vec3(0.0f, 10.0f, 0.0f), glm::normalize(glm::vec3(1.0f, -0.1f, 0.3f)), 16.0f / 9.0f,
+                                        glm::radians(45.0f), 0.1f, 1000.0f);
+    const std::vector<size_t> sizes = quick ? std::vector<size_t>{ 1003 } : std::vector<size_t>{ 100000, 1000000 };
+    for (size_t n : sizes)
+    {
+        std::mt19937 rng(3);
+        std::uniform_real_distribution<float> position(-1000.0f, 1000.0f), size(0.5f, 4.0f);
+        VolumeBatch boxes, spheres;
+        std::vector<std::unique_ptr<Volume>> boxVolumes, sphereVolumes;
+        for (size_t i = 0; i < n; i++)
+        {
+            const glm::vec3 center(position(rng), position(rng) * 0.1f, position(rng));
+            const glm::vec3 extents(size(rng), size(rng), size(rng));
+            const float radius = size(rng);
+            boxes.AddBox(center, extents);
+            spheres.AddSphere(center, radius);
+            boxVolumes.push_back(std::make_unique<Box>(center, extents));
+            sphereVolumes.push_back(std::make_unique<Ball>(center, radius));
+        }
+        const int reps = quick ? 2 : 10;
+        Run("boxes", n, reps, boxVolumes, frustum, [&](uint64_t *mask) { BatchCulling::CullBoxes(frustum, boxes, mask); });
+        Run("spheres", n, reps, sphereVolumes, frustum, [&](uint64_t *mask) { BatchCulling::CullSpheres(frustum, spheres, mask); });
+    }
+    return Failures() != 0;
+}
@@ -0,0 +1,73 @@
+#ifndef BENCHMARK_H
+#define BENCHMARK_H
+
+#include <glm/glm.hpp>
+
+#include <learnopengl/frustum.h>
+
+#include <chrono>
+#include <cmath>
+#include <cstdio>
+#include <cstring>
+
+// helpers shared by the programs in tools/benchmarks. Each one prints its timings, compares its results against a
+// straightforward reference and returns non-zero on any mismatch. --quick shrinks the workload so ctest can run it
+// as a correctness check.
+namespace Benchmark
+{
+    using Clock = std::chrono::steady_clock;
+
+    inline double Milliseconds(Clock::time_point begin, Clock::time_point end)
+    {
+        return std::chrono::duration<double, std::milli>(end - begin).count();
+    }
+
+    inline double Microseconds(Clock::time_point begin, Clock::time_point end)
+    {
+        return std::chrono::duration<double, std::micro>(end - begin).count();
+    }
+
+    inline bool Quick(int argc, char **argv)
+    {
+        for (int i = 1; i < argc; i++)
+            if (std::strcmp(argv[i], "--quick") == 0)
+                return true;
+        return false;
+    }
+
+    inline int &Failures()
+    {
+        static int failures = 0;
+        return failures;
+    }
+
+    inline void Check(bool ok, const char *what)
+    {
+        if (!ok)
+        {
+            std::printf("ERROR::BENCHMARK::%s\n", what);
+            Failures()++;
+        }
+    }
+
+    // the frustum createFrustumFromCamera() in entity.h builds, for a camera at position looking along front
+    inline Frustum MakeFrustum(const glm::vec3 &position, const glm::vec3 &front, float aspect, float fovY, float zNear, float zFar)
+    {
+        const glm::vec3 right = glm::normalize(glm::cross(front, glm::vec3(0.0f, 1.0f, 0.0f)));
+        const glm::vec3 up = glm::normalize(glm::cross(right, front));
+        const float halfVSide = zFar * std::tan(fovY * 0.5f);
+        const float halfHSide = halfVSide * aspect;
+        const glm::vec3 frontMultFar = zFar * front;
+
+        Frustum frustum;
+        frustum.nearFace = { position + zNear * front, front };
+        frustum.farFace = { position + frontMultFar, -front };
+        frustum.rightFace = { position, glm::cross(frontMultFar - right * halfHSide, up) };
+        frustum.leftFace = { position, glm::cross(up, frontMultFar + right * halfHSide) };
+        frustum.topFace = { position, glm::cross(right, frontMultFar - up * halfVSide) };
+        frustum.bottomFace = { position, glm::cross(frontMultFar + up * halfVSide, right) };
+        return frustum;
+    }
+}
+
+#endif
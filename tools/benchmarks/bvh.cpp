@@ -0,0 +1,128 @@
+// DynamicBVH::Cull against testing every box, on random boxes spread over a 2000x2000 area, plus the cost of keeping
+// the tree current while 1% of it moves each frame and of a full Refit()
+#include "benchmark.h"
+
+#include <learnopengl/bvh.h>
+
+#include <cstdio>
+#include <random>
+#include <vector>
+
+using namespace Benchmark;
+
+// the test AABB::isOnFrustum() applies to every entity without a BVH
+static bool LinearTest(const BoundingBox &box, const Frustum &frustum)
+{
+    const Plane planes[6] = { frustum.leftFace, frustum.rightFace, frustum.nearFace, frustum.farFace, frustum.topFace, frustum.bottomFace };
+    const glm::vec3 center = box.Center(), extents = box.Extents();
+    for (const Plane &plane : planes)
+        if (plane.getSignedDistanceToPlane(center) < -glm::dot(extents, glm::abs(plane.normal)))
+            return false;
+    return true;
+}
+
+static std::vector<uint8_t> Reference(const std::vector<BoundingBox> &boxes, const Frustum &frustum)
+{
+    std::vector<uint8_t> visible(boxes.size());
+    for (size_t i = 0; i < boxes.size(); i++)
+        visible[i] = LinearTest(boxes[i], frustum);
+    return visible;
+}
+
+static std::vector<uint8_t> Culled(const DynamicBVH &bvh, size_t count, const Frustum &frustum)
+{
+    std::vector<uint8_t> visible(count);
+    bvh.Cull(frustum, [&](uint32_t i) { visible[i] = 1; });
+    return visible;
+}
+
+int main(int argc, char **argv)
+{
+    const bool quick = Quick(argc, argv);
+    const std::vector<size_t> sizes = quick ? std::vector<size_t>{ 10000 } : std::vector<size_t>{ 10000, 100000, 1000000 };
+    const glm::vec3 eye(0.0f, 10.0f, 0.0f), front = glm::normalize(glm::vec3(1.0f, -0.1f, 0.3f));
+    const Frustum nearView = MakeFrustum(eye, front, 16.0f / 9.0f, glm::radians(45.0f), 0.1f, 100.0f);
+    const Frustum farView = MakeFrustum(eye, front, 16.0f / 9.0f, glm::radians(45.0f), 0.1f, 1000.0f);
+
+    for (size_t n : sizes)
+    {
+        std::mt19937 rng(1);
+        std::uniform_real_distribution<float> position(-1000.0f, 1000.0f), size(0.5f, 3.0f);
+        std::vector<BoundingBox> boxes(n);
+        std::vector<uint32_t> userData(n);
+        for (size_t i = 0; i < n; i++)
+        {
+            const glm::vec3 center(position(rng), position(rng) * 0.1f, position(rng)), extents(size(rng));
+            boxes[i] = { center - extents, center + extents };
+            userData[i] = static_cast<uint32_t>(i);
+        }
+
+        DynamicBVH bvh;
+        const auto buildStart = Clock::now();
+        bvh.Build(boxes, userData);
+        const double build = Milliseconds(buildStart, Clock::now());
+
+        std::printf("%zu boxes, build %.1f ms, SAH cost %.1f\n", n, build, bvh.Cost());
+        for (const Frustum *view : { &nearView, &farView })
+        {
+            const std::vector<uint8_t> expected = Reference(boxes, *view);
+            Check(Culled(bvh, n, *view) == expected, "BVH::CULL_MISMATCH");
+            size_t visible = 0;
+            for (uint8_t v : expected)
+                visible += v;
+
+            const int reps = quick ? 2 : 20;
+            size_t sink = 0;
+            const auto linearStart = Clock::now();
+            for (int r = 0; r < reps; r++)
+                for (size_t i = 0; i < n; i++)
+                    sink += LinearTest(boxes[i], *view);
+            const auto bvhStart = Clock::now();
+            for (int r = 0; r < reps; r++)
+                bvh.Cull(*view, [&](uint32_t) { sink++; });
+            const auto end = Clock::now();
+            std::printf("  far plane %4.0f: %6zu visible, linear %8.3f ms, bvh %8.3f ms\n", view == &nearView ? 100.0f : 1000.0f,
+                        visible, Milliseconds(linearStart, bvhStart) / reps, Milliseconds(bvhStart, end) / reps);
+            if (sink == 42)
+                std::printf("\n");
+        }
+
+        // 1% of the leaves move every frame, through Move() with its rotations
+        const size_t moves = n / 100;
+        const int frames = quick ? 2 : 10;
+        std::uniform_int_distribution<size_t> pick(0, n - 1);
+        const auto moveStart = Clock::now();
+        for (int frame = 0; frame < frames; frame++)
+            for (size_t k = 0; k < moves; k++)
+            {
+                const size_t i = pick(rng);
+                const glm::vec3 delta(position(rng) * 0.01f, 0.0f, position(rng) * 0.01f);
+                boxes[i].min += delta;
+                boxes[i].max += delta;
+                bvh.Move(static_cast<int32_t>(i), boxes[i]);
+            }
+        const double move = Milliseconds(moveStart, Clock::now()) / frames;
+        Check(Culled(bvh, n, nearView) == Reference(boxes, nearView), "BVH::CULL_MISMATCH_AFTER_MOVE");
+
+        // every box moved: SetBox() on all leaves, then one Refit()
+        for (size_t i = 0; i < n; i++)
+        {
+            boxes[i].min.x += 1.0f;
+            boxes[i].max.x += 1.0f;
+            bvh.SetBox(static_cast<int32_t>(i), boxes[i]);
+        }
+        const auto refitStart = Clock::now();
+        bvh.Refit();
+        const double refit = Milliseconds(refitStart, Clock::now());
+        Check(Culled(bvh, n, nearView) == Reference(boxes, nearView), "BVH::CULL_MISMATCH_AFTER_REFIT");
+        std::printf("  move %zu leaves %.3f ms per frame, full refit %.2f ms, SAH cost now %.1f\n", moves, move, refit, bvh.Cost());
+
+        // leaves removed and inserted again get new proxy ids but keep their user data
+        for (size_t i = 0; i < 1000 && i < n; i++)
+            bvh.Remove(static_cast<int32_t>(i));
+        for (size_t i = 0; i < 1000 && i < n; i++)
+            bvh.Insert(boxes[i], static_cast<uint32_t>(i));
+        Check(Culled(bvh, n, nearView) == Reference(boxes, nearView), "BVH::CULL_MISMATCH_AFTER_REINSERT");
+    }
+    return Failures() != 0;
+}
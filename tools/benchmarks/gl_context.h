@@ -0,0 +1,75 @@
+#ifndef GL_CONTEXT_H
+#define GL_CONTEXT_H
+
+#include <glad/glad.h>
+#ifdef LOGL_BENCHMARK_EGL
+#include <EGL/egl.h>
+#include <EGL/eglext.h>
+#else
+#include <GLFW/glfw3.h>
+#endif
+
+#include <cstdio>
+
+// an offscreen GL 4.5 core context for the benchmarks that upload or draw. Built with LOGL_BENCHMARK_EGL it is a
+// surfaceless EGL context, so it runs on machines without a display; otherwise a hidden GLFW window like the demos
+// open. Nothing is presented, render into a framebuffer object.
+namespace Benchmark
+{
+    inline bool CreateContext()
+    {
+#ifdef LOGL_BENCHMARK_EGL
+        PFNEGLGETPLATFORMDISPLAYEXTPROC getPlatformDisplay = (PFNEGLGETPLATFORMDISPLAYEXTPROC)eglGetProcAddress("eglGetPlatformDisplayEXT");
+        EGLDisplay display = getPlatformDisplay ? getPlatformDisplay(EGL_PLATFORM_SURFACELESS_MESA, EGL_DEFAULT_DISPLAY, nullptr)
+                                                : eglGetDisplay(EGL_DEFAULT_DISPLAY);
+        EGLint major, minor;
+        if (display == EGL_NO_DISPLAY || !eglInitialize(display, &major, &minor) || !eglBindAPI(EGL_OPENGL_API))
+        {
+            std::printf("ERROR::BENCHMARK::EGL_INIT_FAILED\n");
+            return false;
+        }
+        const EGLint attributes[] = { EGL_CONTEXT_MAJOR_VERSION, 4, EGL_CONTEXT_MINOR_VERSION, 5,
+                                      EGL_CONTEXT_OPENGL_PROFILE_MASK, EGL_CONTEXT_OPENGL_CORE_PROFILE_BIT, EGL_NONE };
+        EGLContext context = eglCreateContext(display, nullptr, EGL_NO_CONTEXT, attributes);
+        if (context == EGL_NO_CONTEXT || !eglMakeCurrent(display, EGL_NO_SURFACE, EGL_NO_SURFACE, context))
+        {
+            std::printf("ERROR::BENCHMARK::EGL_CONTEXT_FAILED\n");
+            return false;
+        }
+        const bool loaded = gladLoadGLLoader((GLADloadproc)eglGetProcAddress);
+#else
+        if (!glfwInit())
+        {
+            std::printf("ERROR::BENCHMARK::GLFW_INIT_FAILED\n");
+            return false;
+        }
+        glfwWindowHint(GLFW_CONTEXT_VERSION_MAJOR, 4);
+        glfwWindowHint(GLFW_CONTEXT_VERSION_MINOR, 5);
+        glfwWindowHint(GLFW_OPENGL_PROFILE, GLFW_OPENGL_CORE_PROFILE);
+        glfwWindowHint(GLFW_VISIBLE, GLFW_FALSE);
+        GLFWwindow* window = glfwCreateWindow(64, 64, "benchmark", NULL, NULL);
+        if (window == NULL)
+        {
+            std::printf("ERROR::BENCHMARK::GLFW_WINDOW_FAILED\n");
+            glfwTerminate();
+            return false;
+        }
+        glfwMakeContextCurrent(window);
+        const bool loaded = gladLoadGLLoader((GLADloadproc)glfwGetProcAddress);
+#endif
+        if (!loaded)
+            std::printf("ERROR::BENCHMARK::GLAD_LOAD_FAILED\n");
+        else
+            std::printf("%s, OpenGL %s\n", reinterpret_cast<const char*>(glGetString(GL_RENDERER)), reinterpret_cast<const char*>(glGetString(GL_VERSION)));
+        return loaded;
+    }
+
+    inline void DestroyContext()
+    {
+#ifndef LOGL_BENCHMARK_EGL
+        glfwTerminate();
+#endif
+    }
+}
+
+#endif
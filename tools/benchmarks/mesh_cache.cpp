@@ -0,0 +1,136 @@
+// MeshCache write, open and read back of a synthetic model, plus the rejection of stale or damaged cache files. This
+// is the CPU side of a cache hit only, without the Assimp import it replaces or the GL upload.
+// Arguments after --quick: mesh count (default 64) and vertices per mesh (default 50000).
+#include "benchmark.h"
+
+#include <learnopengl/mesh_cache.h>
+
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <fstream>
+#include <iterator>
+#include <random>
+#include <string>
+#include <vector>
+
+using namespace Benchmark;
+
+// what Model hands to MeshCache::Write, without the GL buffers of a Mesh
+struct SourceMesh
+{
+    vector<StaticVertex> vertices;
+    vector<unsigned int> indices;
+    vector<Texture> textures;
+};
+
+static bool Matches(const MeshCache &cache, const vector<SourceMesh> &meshes)
+{
+    if (cache.meshCount() != meshes.size())
+        return false;
+    for (unsigned int i = 0; i < cache.meshCount(); i++)
+    {
+        const MeshCacheEntry &entry = cache.mesh(i);
+        const SourceMesh &mesh = meshes[i];
+        if (entry.vertexCount != mesh.vertices.size() || entry.indexCount != mesh.indices.size() || entry.textureCount != mesh.textures.size() ||
+            std::memcmp(cache.vertices(i), mesh.vertices.data(), mesh.vertices.size() * sizeof(StaticVertex)) != 0 ||
+            std::memcmp(cache.indices(i), mesh.indices.data(), mesh.indices.size() * sizeof(unsigned int)) != 0)
+            return false;
+        for (unsigned int t = 0; t < entry.textureCount; t++)
+            if (cache.textureType(entry.firstTexture + t) != mesh.textures[t].type || cache.texturePath(entry.firstTexture + t) != mesh.textures[t].path)
+                return false;
+    }
+    return true;
+}
+
+int main(int argc, char **argv)
+{
+    const bool quick = Quick(argc, argv);
+    std::vector<const char*> values;
+    for (int i = 1; i < argc; i++)
+        if (argv[i][0] != '-')
+            values.push_back(argv[i]);
+    const size_t meshCount = values.size() > 0 ? std::strtoul(values[0], nullptr, 10) : quick ? 8 : 64;
+    const size_t vertexCount = values.size() > 1 ? std::strtoul(values[1], nullptr, 10) : quick ? 1000 : 50000;
+    const std::string source = "benchmark_mesh_cache.obj", material = "benchmark_mesh_cache.mtl";
+    const uint32_t flags = 0x8b;
+
+    // the "source" only has to exist and hash; the cache stands in for whatever the importer produced from it
+    std::ofstream(source, std::ios::binary) << std::string(1 << 20, 'v');
+    std::ofstream(material, std::ios::binary) << "newmtl benchmark\n";
+    std::mt19937 rng(11);
+    std::uniform_real_distribution<float> unit(-1.0f, 1.0f);
+    vector<SourceMesh> meshes(meshCount);
+    size_t bytes = 0;
+    for (size_t m = 0; m < meshCount; m++)
+    {
+        SourceMesh &mesh = meshes[m];
+        mesh.vertices.resize(vertexCount);
+        for (StaticVertex &v : mesh.vertices)
+        {
+            std::memset(&v, 0, sizeof(v));
+            v.Position = glm::vec3(unit(rng), unit(rng), unit(rng)) * 10.0f;
+            v.Normal = glm::normalize(glm::vec3(unit(rng), unit(rng), unit(rng)));
+            v.TexCoords = glm::vec2(unit(rng), unit(rng));
+        }
+        for (size_t t = 0; t + 2 < vertexCount * 2; t += 3)
+            mesh.indices.insert(mesh.indices.end(), { unsigned(rng() % vertexCount), unsigned(rng() % vertexCount), unsigned(rng() % vertexCount) });
+        mesh.textures.push_back({ 0, "texture_diffuse", "diffuse_" + std::to_string(m) + ".png" });
+        if (m % 2)
+            mesh.textures.push_back({ 0, "texture_normal", "normal_" + std::to_string(m) + ".png" });
+        bytes += mesh.vertices.size() * sizeof(StaticVertex) + mesh.indices.size() * sizeof(unsigned int);
+    }
+
+    const auto hashStart = Clock::now();
+    const uint64_t hash = MeshCache::HashFile(source);
+    const auto writeStart = Clock::now();
+    const bool written = MeshCache::Write(source, hash, flags, meshes, { material });
+    const auto writeEnd = Clock::now();
+    Check(written, "MESH_CACHE::WRITE_FAILED");
+    std::printf("%zu meshes of %zu vertices, %.1f MB: hash 1 MB source %.2f ms, write %.1f ms\n", meshCount, vertexCount,
+                bytes / 1048576.0, Milliseconds(hashStart, writeStart), Milliseconds(writeStart, writeEnd));
+
+    for (int rep = 0; rep < 3; rep++)
+    {
+        const auto openStart = Clock::now();
+        MeshCache cache;
+        const bool opened = cache.open(source, MeshCache::HashFile(source), flags);
+        const auto readStart = Clock::now();
+        // touch every page once, as the upload from the mapping does
+        uint64_t sum = 0;
+        for (unsigned int i = 0; opened && i < cache.meshCount(); i++)
+        {
+            const unsigned char *data = reinterpret_cast<const unsigned char*>(cache.vertices(i));
+            for (size_t b = 0; b < cache.mesh(i).vertexCount * sizeof(StaticVertex); b += 4096)
+                sum += data[b];
+        }
+        const auto end = Clock::now();
+        Check(opened && Matches(cache, meshes), "MESH_CACHE::ROUND_TRIP_MISMATCH");
+        std::printf("hash + open + validate %.2f ms, first touch of the vertex pages %.2f ms%s\n", Milliseconds(openStart, readStart),
+                    Milliseconds(readStart, end), sum == 42 ? " " : "");
+    }
+
+    // a cache must not be used once the flags, the source or a dependency changed, or when the file is cut short
+    {
+        MeshCache cache;
+        Check(!cache.open(source, hash, flags ^ 1u), "MESH_CACHE::STALE_FLAGS_ACCEPTED");
+        Check(!cache.open(source, hash + 1, flags), "MESH_CACHE::STALE_SOURCE_ACCEPTED");
+        std::ofstream(material, std::ios::binary) << "newmtl changed\n";
+        Check(!cache.open(source, hash, flags), "MESH_CACHE::STALE_DEPENDENCY_ACCEPTED");
+        std::ofstream(material, std::ios::binary) << "newmtl benchmark\n";
+        Check(cache.open(source, hash, flags), "MESH_CACHE::REOPEN_FAILED");
+    }
+    {
+        std::ifstream in(MeshCache::CachePath(source), std::ios::binary);
+        const std::string contents((std::istreambuf_iterator<char>(in)), std::istreambuf_iterator<char>());
+        in.close();
+        std::ofstream(MeshCache::CachePath(source), std::ios::binary | std::ios::trunc) << contents.substr(0, contents.size() / 2);
+    }
+    MeshCache truncated;
+    Check(!truncated.open(source, hash, flags), "MESH_CACHE::TRUNCATED_FILE_ACCEPTED");
+
+    std::remove(MeshCache::CachePath(source).c_str());
+    std::remove(source.c_str());
+    std::remove(material.c_str());
+    return Failures() != 0;
+}
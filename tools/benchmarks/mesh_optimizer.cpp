@@ -0,0 +1,177 @@
+// MeshOptimizer::Optimize on every model in resources/objects: vertex count, ACMR and ATVR of each mesh before and
+// after, and the time the pipeline takes. The OBJ files are read the way Model imports them, without Assimp: one
+// vertex per face corner (JoinIdenticalVertices is not among Model::ImportFlags), V flipped, a mesh per object, group
+// or material. Tangents are left zero. No vertex is shared before welding, so ATVR starts at 1. Optimize must keep
+// the set of triangles, with their winding, unchanged.
+// Arguments after --quick: model paths relative to the repository (default every model in resources/objects, with
+// --quick the planet and the rock).
+#include "benchmark.h"
+
+#include <learnopengl/filesystem.h>
+#include <learnopengl/mesh_optimizer.h>
+#include <learnopengl/vertex_format.h>
+
+#include <algorithm>
+#include <array>
+#include <cstdio>
+#include <cstring>
+#include <filesystem>
+#include <fstream>
+#include <iostream>
+#include <sstream>
+#include <string>
+#include <vector>
+
+using namespace Benchmark;
+
+struct ObjMesh
+{
+    std::string name;
+    std::vector<StaticVertex> vertices;
+    std::vector<unsigned int> indices;
+};
+
+// 1-based, negative counts back from the end
+static size_t ObjIndex(const std::string &token, size_t count)
+{
+    const long index = token.empty() ? 0 : std::stol(token);
+    return index < 0 ? count + index : size_t(index - 1);
+}
+
+static std::vector<ObjMesh> LoadObj(const std::string &path)
+{
+    std::vector<ObjMesh> meshes(1);
+    std::vector<glm::vec3> positions, normals;
+    std::vector<glm::vec2> texCoords;
+    std::ifstream file(path);
+    if (!file)
+        std::printf("ERROR::BENCHMARK::OBJ_NOT_FOUND %s\n", path.c_str());
+    std::string line;
+    while (std::getline(file, line))
+    {
+        std::istringstream in(line);
+        std::string tag;
+        in >> tag;
+        if (tag == "v")
+        {
+            glm::vec3 p;
+            in >> p.x >> p.y >> p.z;
+            positions.push_back(p);
+        }
+        else if (tag == "vn")
+        {
+            glm::vec3 n;
+            in >> n.x >> n.y >> n.z;
+            normals.push_back(n);
+        }
+        else if (tag == "vt")
+        {
+            glm::vec2 t;
+            in >> t.x >> t.y;
+            texCoords.push_back(glm::vec2(t.x, 1.0f - t.y));
+        }
+        else if (tag == "o" || tag == "g" || tag == "usemtl")
+        {
+            if (!meshes.back().indices.empty())
+                meshes.emplace_back();
+            std::string name;
+            in >> name;
+            meshes.back().name = name;
+        }
+        else if (tag == "f")
+        {
+            ObjMesh &mesh = meshes.back();
+            std::vector<unsigned int> face;
+            std::string corner;
+            while (in >> corner)
+            {
+                // v, v/vt, v//vn or v/vt/vn
+                std::string fields[3];
+                for (size_t f = 0, begin = 0; f < 3 && begin <= corner.size(); f++)
+                {
+                    const size_t end = std::min(corner.find('/', begin), corner.size());
+                    fields[f] = corner.substr(begin, end - begin);
+                    begin = end + 1;
+                }
+                StaticVertex v{};
+                v.Position = positions[ObjIndex(fields[0], positions.size())];
+                if (!fields[1].empty())
+                    v.TexCoords = texCoords[ObjIndex(fields[1], texCoords.size())];
+                if (!fields[2].empty())
+                    v.Normal = normals[ObjIndex(fields[2], normals.size())];
+                face.push_back(static_cast<unsigned int>(mesh.vertices.size()));
+                mesh.vertices.push_back(v);
+            }
+            for (size_t k = 1; k + 1 < face.size(); k++)
+                mesh.indices.insert(mesh.indices.end(), { face[0], face[k], face[k + 1] });
+        }
+    }
+    if (meshes.back().indices.empty())
+        meshes.pop_back();
+    return meshes;
+}
+
+// every triangle as its three vertices, rotated so the smallest comes first (which keeps the winding), sorted
+static std::vector<std::array<float, 36>> Triangles(const std::vector<StaticVertex> &vertices, const std::vector<unsigned int> &indices)
+{
+    static_assert(sizeof(StaticVertex) == 12 * sizeof(float), "StaticVertex is read as 12 floats");
+    auto less = [&](unsigned int a, unsigned int b)
+    {
+        const float *x = reinterpret_cast<const float*>(&vertices[a]), *y = reinterpret_cast<const float*>(&vertices[b]);
+        return std::lexicographical_compare(x, x + 12, y, y + 12);
+    };
+    std::vector<std::array<float, 36>> triangles(indices.size() / 3);
+    for (size_t t = 0; t < triangles.size(); t++)
+    {
+        const unsigned int *corner = &indices[t * 3];
+        size_t first = 0;
+        for (size_t k = 1; k < 3; k++)
+            if (less(corner[k], corner[first]))
+                first = k;
+        for (size_t k = 0; k < 3; k++)
+            std::memcpy(&triangles[t][k * 12], &vertices[corner[(first + k) % 3]], sizeof(StaticVertex));
+    }
+    std::sort(triangles.begin(), triangles.end());
+    return triangles;
+}
+
+int main(int argc, char **argv)
+{
+    const bool quick = Quick(argc, argv);
+    std::vector<std::string> models;
+    for (int i = 1; i < argc; i++)
+        if (argv[i][0] != '-')
+            models.push_back(argv[i]);
+    if (models.empty() && quick)
+        models = { "resources/objects/planet/planet.obj", "resources/objects/rock/rock.obj" };
+    if (models.empty())
+    {
+        const std::filesystem::path objects(FileSystem::getPath("resources/objects"));
+        for (const auto &entry : std::filesystem::recursive_directory_iterator(objects))
+            if (entry.path().extension() == ".obj")
+                models.push_back("resources/objects/" + std::filesystem::relative(entry.path(), objects).generic_string());
+        std::sort(models.begin(), models.end());
+    }
+    Check(!models.empty(), "MESH_OPTIMIZER::NO_MODELS");
+
+    for (const std::string &model : models)
+    {
+        std::vector<ObjMesh> meshes = LoadObj(FileSystem::getPath(model));
+        Check(!meshes.empty(), "MESH_OPTIMIZER::LOAD_FAILED");
+        std::printf("%s: %zu meshes\n", model.c_str(), meshes.size());
+        double total = 0.0;
+        for (ObjMesh &mesh : meshes)
+        {
+            const auto before = Triangles(mesh.vertices, mesh.indices);
+            const auto start = Clock::now();
+            const MeshOptimizationStatistics stats = MeshOptimizer::Optimize(mesh.vertices, mesh.indices);
+            const auto end = Clock::now();
+            total += Milliseconds(start, end);
+            std::cout << "  " << (mesh.name.empty() ? "(unnamed)" : mesh.name.c_str()) << ": " << stats << std::endl;
+            Check(stats.after.acmr <= stats.before.acmr, "MESH_OPTIMIZER::ACMR_WORSE");
+            Check(Triangles(mesh.vertices, mesh.indices) == before, "MESH_OPTIMIZER::TRIANGLES_CHANGED");
+        }
+        std::printf("  optimised in %.2f ms\n", total);
+    }
+    return Failures() != 0;
+}
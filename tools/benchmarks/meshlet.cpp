@@ -0,0 +1,149 @@
+// MeshletSet::Cull (four meshlets per SSE2 step) against CullScalar (one at a time) on a finely tessellated sphere,
+// after MeshOptimizer as Model builds it, under random rotations, non-uniform scales and mirrors. CPU only. Neither
+// may cull a front-facing triangle with a vertex inside the frustum; mirrored transforms flip which side faces the
+// camera and skip the cone test.
+#include "benchmark.h"
+
+#include <learnopengl/mesh_optimizer.h>
+#include <learnopengl/meshlet.h>
+#include <learnopengl/vertex_format.h>
+
+#include <glm/gtc/matrix_transform.hpp>
+#include <glm/gtc/quaternion.hpp>
+
+#include <cstdio>
+#include <random>
+#include <vector>
+
+using namespace Benchmark;
+
+// unit latitude/longitude sphere, counter-clockwise seen from outside
+static void Sphere(int rings, int segments, std::vector<StaticVertex> &vertices, std::vector<unsigned int> &indices)
+{
+    const float pi = 3.14159265358979f;
+    for (int r = 0; r <= rings; r++)
+        for (int s = 0; s <= segments; s++)
+        {
+            const float theta = pi * r / rings, phi = 2.0f * pi * s / segments;
+            StaticVertex v{};
+            v.Normal = glm::vec3(std::sin(theta) * std::cos(phi), std::cos(theta), std::sin(theta) * std::sin(phi));
+            v.Position = v.Normal;
+            v.TexCoords = glm::vec2(float(s) / segments, float(r) / rings);
+            vertices.push_back(v);
+        }
+    for (int r = 0; r < rings; r++)
+        for (int s = 0; s < segments; s++)
+        {
+            const unsigned int a = r * (segments + 1) + s, b = a + segments + 1;
+            indices.insert(indices.end(), { a, a + 1, b, a + 1, b + 1, b });
+        }
+}
+
+// the triangles covered by the index ranges of the draw list
+static std::vector<uint8_t> VisibleTriangles(const MeshletDrawList &list, size_t triangleCount)
+{
+    std::vector<uint8_t> visible(triangleCount, 0);
+    for (size_t r = 0; r < list.counts.size(); r++)
+    {
+        const size_t first = reinterpret_cast<uintptr_t>(list.offsets[r]) / sizeof(unsigned int) / 3;
+        std::fill(visible.begin() + first, visible.begin() + first + list.counts[r] / 3, 1);
+    }
+    return visible;
+}
+
+// front-facing triangles with a vertex strictly inside the frustum that the draw list leaves out
+static size_t WronglyCulled(const std::vector<StaticVertex> &vertices, const std::vector<unsigned int> &indices, const glm::mat4 &model,
+                            const Frustum &frustum, const glm::vec3 &camera, const std::vector<uint8_t> &visible)
+{
+    const Plane planes[6] = { frustum.leftFace, frustum.rightFace, frustum.nearFace, frustum.farFace, frustum.topFace, frustum.bottomFace };
+    size_t wrong = 0;
+    for (size_t t = 0; t < visible.size(); t++)
+    {
+        if (visible[t])
+            continue;
+        glm::vec3 p[3];
+        for (int k = 0; k < 3; k++)
+            p[k] = glm::vec3(model * glm::vec4(vertices[indices[t * 3 + k]].Position, 1.0f));
+        if (glm::dot(glm::cross(p[1] - p[0], p[2] - p[0]), camera - p[0]) <= 0.0f)
+            continue; // back facing, or degenerate
+        bool inside = false;
+        for (int k = 0; k < 3 && !inside; k++)
+        {
+            inside = true;
+            for (const Plane &plane : planes)
+                inside = inside && plane.getSignedDistanceToPlane(p[k]) > 0.0f;
+        }
+        wrong += inside;
+    }
+    return wrong;
+}
+
+int main(int argc, char **argv)
+{
+    const bool quick = Quick(argc, argv);
+    const int rings = quick ? 64 : 400, segments = quick ? 64 : 400;
+    const int transforms = 20, reps = quick ? 10 : 200;
+
+    std::vector<StaticVertex> vertices;
+    std::vector<unsigned int> indices;
+    Sphere(rings, segments, vertices, indices);
+    MeshOptimizer::Optimize(vertices, indices);
+    MeshletSet set;
+    set.Build(vertices, indices);
+    const size_t triangleCount = indices.size() / 3;
+#if defined(LOGL_SSE2)
+    std::printf("SSE2 path\n");
+#else
+    std::printf("scalar path\n");
+#endif
+    std::printf("sphere of %zu triangles, %zu meshlets, %d transforms (every other one mirrored):\n", triangleCount, set.meshlets.size(), transforms);
+
+    std::mt19937 rng(5);
+    std::normal_distribution<float> gaussian;
+    std::uniform_real_distribution<float> unit(-1.0f, 1.0f), scale(0.5f, 2.0f), distance(2.5f, 6.0f);
+    double cullTime = 0.0, scalarTime = 0.0;
+    size_t wrong = 0, differing = 0, visibleMeshlets = 0, visibleTriangles = 0;
+    MeshletDrawList list, scalarList;
+    for (int t = 0; t < transforms; t++)
+    {
+        const glm::quat rotation = glm::normalize(glm::quat(gaussian(rng), gaussian(rng), gaussian(rng), gaussian(rng)));
+        glm::vec3 scaling(scale(rng), scale(rng), scale(rng));
+        if (t % 2 == 1)
+            scaling.x = -scaling.x;
+        const glm::vec3 translation(unit(rng) * 50.0f, unit(rng) * 50.0f, unit(rng) * 50.0f);
+        const glm::mat4 model = glm::translate(glm::mat4(1.0f), translation) * glm::mat4_cast(rotation) * glm::scale(glm::mat4(1.0f), scaling);
+
+        // looking at a point near the sphere, so some of it usually falls outside the frustum
+        const glm::vec3 direction = glm::normalize(glm::vec3(gaussian(rng), gaussian(rng), gaussian(rng)));
+        const float extent = std::max(std::abs(scaling.x), std::max(scaling.y, scaling.z));
+        const glm::vec3 camera = translation + direction * distance(rng) * extent;
+        const glm::vec3 target = translation + glm::vec3(unit(rng), unit(rng), unit(rng)) * extent;
+        const Frustum frustum = MakeFrustum(camera, glm::normalize(target - camera), 16.0f / 9.0f, glm::radians(45.0f), 0.1f, 1000.0f);
+
+        const auto cullStart = Clock::now();
+        for (int r = 0; r < reps; r++)
+            set.Cull(frustum, model, camera, list);
+        const auto scalarStart = Clock::now();
+        for (int r = 0; r < reps; r++)
+            set.CullScalar(frustum, model, camera, scalarList);
+        const auto end = Clock::now();
+        cullTime += Microseconds(cullStart, scalarStart);
+        scalarTime += Microseconds(scalarStart, end);
+
+        const std::vector<uint8_t> visible = VisibleTriangles(list, triangleCount), scalarVisible = VisibleTriangles(scalarList, triangleCount);
+        wrong += WronglyCulled(vertices, indices, model, frustum, camera, visible);
+        wrong += WronglyCulled(vertices, indices, model, frustum, camera, scalarVisible);
+        // the two paths sum the plane equation in a different order, so a meshlet touching a plane may go either way
+        differing += list.visibleMeshlets > scalarList.visibleMeshlets ? list.visibleMeshlets - scalarList.visibleMeshlets
+                                                                      : scalarList.visibleMeshlets - list.visibleMeshlets;
+        visibleMeshlets += list.visibleMeshlets;
+        visibleTriangles += list.visibleTriangles;
+    }
+    Check(wrong == 0, "MESHLET::FRONT_FACING_CULLED");
+
+    std::printf("  Cull %8.2f us, CullScalar %8.2f us per cull\n", cullTime / (double(transforms) * reps), scalarTime / (double(transforms) * reps));
+    std::printf("  %.1f%% of the meshlets and %.1f%% of the triangles kept, %zu visible meshlet count differences, %zu front-facing triangles culled\n",
+                100.0 * visibleMeshlets / (double(transforms) * set.meshlets.size()), 100.0 * visibleTriangles / (double(transforms) * triangleCount),
+                differing, wrong);
+    return Failures() != 0;
+}
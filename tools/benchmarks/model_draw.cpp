@@ -0,0 +1,117 @@
+// CPU cost of submitting a model: Model::Draw (one glDrawElements per mesh) against UseArena() + DrawIndirect (one
+// multi-draw per batch), read from Model::lastDrawStats. The model is synthetic and loaded through its mesh cache,
+// so Assimp is linked but never runs. Both paths must produce the same image.
+// Arguments after --quick: mesh count (default 79) and rows of quads per mesh (default 1, at most 9; 38 triangles
+// a row).
+#include "gl_context.h"
+#include "benchmark.h"
+
+#include <learnopengl/filesystem.h>
+#include <learnopengl/model.h>
+#include <learnopengl/shader.h>
+
+#include <cstdio>
+#include <cstdlib>
+#include <fstream>
+#include <string>
+#include <vector>
+
+using namespace Benchmark;
+
+struct SourceMesh
+{
+    vector<StaticVertex> vertices;
+    vector<unsigned int> indices;
+    vector<Texture> textures;
+};
+
+static std::vector<unsigned char> ReadPixels(int size)
+{
+    std::vector<unsigned char> pixels(size_t(size) * size * 4);
+    glReadPixels(0, 0, size, size, GL_RGBA, GL_UNSIGNED_BYTE, pixels.data());
+    return pixels;
+}
+
+int main(int argc, char **argv)
+{
+    const bool quick = Quick(argc, argv);
+    std::vector<const char*> values;
+    for (int i = 1; i < argc; i++)
+        if (argv[i][0] != '-')
+            values.push_back(argv[i]);
+    const int meshCount = values.size() > 0 ? std::atoi(values[0]) : 79;
+    const int rows = values.size() > 1 ? std::atoi(values[1]) : 1;
+    const int frames = quick ? 20 : 500;
+    if (!CreateContext())
+        return 1;
+
+    // a 20x10 vertex grid per mesh, each mesh shifted so they cover different pixels
+    const std::string path = "benchmark_model_draw.obj";
+    std::ofstream(path) << "# stands in for the source asset, the meshes come from its cache\n";
+    vector<SourceMesh> meshes(meshCount);
+    for (int m = 0; m < meshCount; m++)
+    {
+        for (int i = 0; i < 200; i++)
+        {
+            StaticVertex v{};
+            v.Position = glm::vec3((i % 20) * 0.05f - 1.0f + (m % 8) * 0.1f, (i / 20) * 0.05f - 1.0f + (m / 8 % 8) * 0.1f, 0.0f);
+            meshes[m].vertices.push_back(v);
+        }
+        for (int y = 0; y < rows && y < 9; y++)
+            for (int x = 0; x < 19; x++)
+            {
+                const unsigned int a = y * 20 + x;
+                meshes[m].indices.insert(meshes[m].indices.end(), { a, a + 1, a + 20, a + 1, a + 21, a + 20 });
+            }
+    }
+    MeshCache::Write(path, MeshCache::HashFile(path), Model::ImportFlags, meshes);
+
+    {
+        const int size = 64;
+        GLuint framebuffer, colorbuffer;
+        glGenFramebuffers(1, &framebuffer);
+        glGenRenderbuffers(1, &colorbuffer);
+        glBindRenderbuffer(GL_RENDERBUFFER, colorbuffer);
+        glRenderbufferStorage(GL_RENDERBUFFER, GL_RGBA8, size, size);
+        glBindFramebuffer(GL_FRAMEBUFFER, framebuffer);
+        glFramebufferRenderbuffer(GL_FRAMEBUFFER, GL_COLOR_ATTACHMENT0, GL_RENDERBUFFER, colorbuffer);
+        glViewport(0, 0, size, size);
+
+        Model model(path);
+        Shader shader(FileSystem::getPath("tools/benchmarks/model_draw.vs").c_str(), FileSystem::getPath("tools/benchmarks/model_draw.fs").c_str());
+        shader.use();
+        shader.setMat4("model", glm::mat4(1.0f));
+        model.collectDrawStats = true;
+        Check(model.meshes.size() == size_t(meshCount), "MODEL_DRAW::CACHE_NOT_USED");
+
+        std::vector<unsigned char> images[2];
+        auto run = [&](const char *name, int slot, auto draw)
+        {
+            for (int i = 0; i < 20; i++)
+                draw();
+            glFinish();
+            double submit = 0.0;
+            for (int i = 0; i < frames; i++)
+            {
+                glClear(GL_COLOR_BUFFER_BIT);
+                draw();
+                submit += model.lastDrawStats.submitMicroseconds;
+            }
+            glFinish();
+            images[slot] = ReadPixels(size);
+            std::printf("  %-22s %5u draw calls, CPU submit %8.1f us per model\n", name, model.lastDrawStats.drawCalls, submit / frames);
+        };
+        std::printf("%d meshes of %zu triangles\n", meshCount, meshes[0].indices.size() / 3);
+        run("Draw (per mesh)", 0, [&] { model.Draw(shader); });
+        model.UseArena();
+        run("DrawIndirect (arena)", 1, [&] { model.DrawIndirect(shader); });
+        Check(images[0] == images[1], "MODEL_DRAW::IMAGES_DIFFER");
+
+        glDeleteRenderbuffers(1, &colorbuffer);
+        glDeleteFramebuffers(1, &framebuffer);
+    }
+    std::remove(MeshCache::CachePath(path).c_str());
+    std::remove(path.c_str());
+    DestroyContext();
+    return Failures() != 0;
+}
@@ -0,0 +1,134 @@
+// Load times of the models in resources/objects, cold against warm: an Assimp import (Model with useCache off)
+// against a mesh cache hit, both including the GL upload of the meshes. Each model directory is copied next to the
+// benchmark so the cache file isn't written into resources/. A warm-up load first makes the textures resident in the
+// TextureCache, so neither side pays for decoding them. Both loads must produce the same vertices and indices. The
+// import also prints what MeshOptimizer did to each mesh (a cache hit leaves Model::optimizationStats empty), and a
+// table of all models closes the run, with the size of their index buffers as 32-bit elements against
+// Model::IndexBytes(), which counts 16 bits per index for every mesh of at most 65536 vertices.
+// Arguments after --quick: model paths relative to the repository (default every model in resources/objects, with
+// --quick the planet).
+#include "gl_context.h"
+#include "benchmark.h"
+
+#include <learnopengl/filesystem.h>
+#include <learnopengl/model.h>
+
+#include <algorithm>
+#include <cstdio>
+#include <cstring>
+#include <filesystem>
+#include <iostream>
+#include <string>
+#include <system_error>
+#include <vector>
+
+using namespace Benchmark;
+
+static bool SameMeshes(const Model &a, const Model &b)
+{
+    if (a.meshes.size() != b.meshes.size())
+        return false;
+    for (size_t i = 0; i < a.meshes.size(); i++)
+        if (a.meshes[i].indices != b.meshes[i].indices || a.meshes[i].vertices.size() != b.meshes[i].vertices.size() ||
+            std::memcmp(a.meshes[i].vertices.data(), b.meshes[i].vertices.data(), a.meshes[i].vertices.size() * sizeof(StaticVertex)) != 0)
+            return false;
+    return true;
+}
+
+// one line of the table
+struct LoadTimes
+{
+    std::string model;
+    size_t meshes = 0;
+    size_t triangles = 0;
+    double cold = 0.0; // Assimp import + upload, ms
+    double warm = 0.0; // mesh cache + upload, ms
+    size_t indexBytes32 = 0; // every index buffer with 32-bit elements
+    size_t indexBytes = 0;   // Model::IndexBytes()
+};
+
+static LoadTimes Measure(const std::string &model, int reps)
+{
+    LoadTimes times;
+    times.model = model;
+    const std::filesystem::path source(FileSystem::getPath(model));
+    const std::filesystem::path directory = "benchmark_model_load";
+    std::error_code error;
+    std::filesystem::remove_all(directory, error);
+    std::filesystem::copy(source.parent_path(), directory, std::filesystem::copy_options::recursive, error);
+    Check(!error, "MODEL_LOAD::COPY_FAILED");
+    const std::string path = (directory / source.filename()).generic_string();
+
+    {
+        // the warm-up writes the cache and leaves the textures resident
+        Model warmUp(path);
+        Check(!warmUp.meshes.empty(), "MODEL_LOAD::LOAD_FAILED");
+        times.meshes = warmUp.meshes.size();
+        times.triangles = warmUp.TriangleCount();
+        for (const Mesh &mesh : warmUp.meshes)
+            times.indexBytes32 += mesh.indices.size() * sizeof(unsigned int);
+        times.indexBytes = warmUp.IndexBytes();
+        std::printf("%s: %zu meshes, %zu triangles\n", model.c_str(), times.meshes, times.triangles);
+
+        for (int rep = 0; rep < reps; rep++)
+        {
+            const auto assimpStart = Clock::now();
+            Model imported(path, false, false);
+            glFinish();
+            const auto cacheStart = Clock::now();
+            Model loaded(path);
+            glFinish();
+            const auto end = Clock::now();
+            times.cold += Milliseconds(assimpStart, cacheStart) / reps;
+            times.warm += Milliseconds(cacheStart, end) / reps;
+            Check(SameMeshes(imported, loaded) && SameMeshes(imported, warmUp), "MODEL_LOAD::CACHE_MISMATCH");
+            if (rep == 0)
+                for (size_t i = 0; i < imported.optimizationStats.size(); i++)
+                    std::cout << "  mesh " << i << ": " << imported.optimizationStats[i] << std::endl;
+        }
+    }
+    std::filesystem::remove_all(directory, error);
+    return times;
+}
+
+int main(int argc, char **argv)
+{
+    const bool quick = Quick(argc, argv);
+    std::vector<std::string> models;
+    for (int i = 1; i < argc; i++)
+        if (argv[i][0] != '-')
+            models.push_back(argv[i]);
+    if (models.empty() && quick)
+        models = { "resources/objects/planet/planet.obj" };
+    if (models.empty())
+    {
+        const std::filesystem::path objects(FileSystem::getPath("resources/objects"));
+        for (const auto &entry : std::filesystem::recursive_directory_iterator(objects))
+            if (entry.path().extension() == ".obj")
+                models.push_back("resources/objects/" + std::filesystem::relative(entry.path(), objects).generic_string());
+        std::sort(models.begin(), models.end());
+    }
+    Check(!models.empty(), "MODEL_LOAD::NO_MODELS");
+    const int reps = quick ? 2 : 5;
+    if (!CreateContext())
+        return 1;
+
+    std::vector<LoadTimes> table;
+    for (const std::string &model : models)
+        table.push_back(Measure(model, reps));
+
+    std::printf("%-42s %7s %10s %12s %12s %8s %14s %14s\n", "model", "meshes", "triangles", "cold (ms)", "warm (ms)", "speedup",
+                "32-bit indices", "IndexBytes()");
+    size_t total32 = 0, total = 0;
+    for (const LoadTimes &row : table)
+    {
+        std::printf("%-42s %7zu %10zu %12.2f %12.2f %7.1fx %11.1f KB %11.1f KB\n", row.model.c_str(), row.meshes, row.triangles, row.cold,
+                    row.warm, row.warm > 0.0 ? row.cold / row.warm : 0.0, row.indexBytes32 / 1024.0, row.indexBytes / 1024.0);
+        total32 += row.indexBytes32;
+        total += row.indexBytes;
+    }
+    std::printf("index memory of all models %.1f KB -> %.1f KB (%.0f%% saved, the same share of index fetch bandwidth per draw)\n",
+                total32 / 1024.0, total / 1024.0, total32 > 0 ? 100.0 * (total32 - total) / total32 : 0.0);
+    DestroyContext();
+    return Failures() != 0;
+}
@@ -0,0 +1,327 @@
+// OcclusionCuller on two scenes:
+// - a city of rock.obj buildings on a street grid with small props between them, seen from three cameras. Objects
+//   the culler rejects are checked against an independent full resolution z-buffer with object ids; culling
+//   anything that buffer shows is an error.
+// - planet.obj as a single occluder at three distances: a box right behind it must be culled, and a box beside it
+//   must stay visible whenever the reference buffer shows any of it.
+#include "benchmark.h"
+
+#include <glm/gtc/matrix_transform.hpp>
+
+#include <learnopengl/filesystem.h>
+#include <learnopengl/occlusion_culling.h>
+
+#include <algorithm>
+#include <cstdio>
+#include <fstream>
+#include <limits>
+#include <random>
+#include <sstream>
+#include <string>
+#include <vector>
+
+using namespace Benchmark;
+
+struct Vertex { glm::vec3 Position; };
+
+struct ObjMesh
+{
+    std::vector<Vertex> vertices;
+    std::vector<unsigned int> indices;
+    glm::vec3 min = glm::vec3(std::numeric_limits<float>::max()), max = -glm::vec3(std::numeric_limits<float>::max());
+};
+
+// positions and faces only, fanned into triangles
+static ObjMesh LoadObj(const std::string &path)
+{
+    ObjMesh mesh;
+    std::ifstream file(path);
+    if (!file)
+        std::printf("ERROR::BENCHMARK::OBJ_NOT_FOUND %s\n", path.c_str());
+    std::string line;
+    while (std::getline(file, line))
+    {
+        std::istringstream in(line);
+        std::string tag;
+        in >> tag;
+        if (tag == "v")
+        {
+            Vertex v;
+            in >> v.Position.x >> v.Position.y >> v.Position.z;
+            mesh.vertices.push_back(v);
+            mesh.min = glm::min(mesh.min, v.Position);
+            mesh.max = glm::max(mesh.max, v.Position);
+        }
+        else if (tag == "f")
+        {
+            std::vector<unsigned int> face;
+            std::string corner;
+            while (in >> corner)
+                face.push_back(static_cast<unsigned int>(std::stoi(corner) - 1));
+            for (size_t k = 1; k + 1 < face.size(); k++)
+                mesh.indices.insert(mesh.indices.end(), { face[0], face[k], face[k + 1] });
+        }
+    }
+    return mesh;
+}
+
+// box test in clip space: false when all corners are outside one plane
+static bool InFrustum(const glm::mat4 &viewProjection, const glm::vec3 &min, const glm::vec3 &max)
+{
+    int outside[6] = { 0 };
+    for (int c = 0; c < 8; c++)
+    {
+        const glm::vec4 p = viewProjection * glm::vec4(c & 1 ? max.x : min.x, c & 2 ? max.y : min.y, c & 4 ? max.z : min.z, 1.0f);
+        outside[0] += p.x < -p.w; outside[1] += p.x > p.w;
+        outside[2] += p.y < -p.w; outside[3] += p.y > p.w;
+        outside[4] += p.z < -p.w; outside[5] += p.z > p.w;
+    }
+    for (int i = 0; i < 6; i++)
+        if (outside[i] == 8)
+            return false;
+    return true;
+}
+
+// plain per-pixel z-buffer storing the id of the nearest object, the ground truth for what a camera sees
+struct ReferenceBuffer
+{
+    int width, height;
+    std::vector<float> depth;
+    std::vector<int> id;
+
+    ReferenceBuffer(int w, int h) : width(w), height(h), depth(size_t(w) * h, std::numeric_limits<float>::max()), id(size_t(w) * h, -1) {}
+
+    void triangle(const glm::vec4 &a, const glm::vec4 &b, const glm::vec4 &c, int object)
+    {
+        // triangles reaching behind the camera are skipped; only buildings far from the camera are affected
+        if (a.w <= 1e-5f || b.w <= 1e-5f || c.w <= 1e-5f)
+            return;
+        const glm::vec4 clip[3] = { a, b, c };
+        glm::vec3 p[3];
+        for (int i = 0; i < 3; i++)
+            p[i] = glm::vec3((clip[i].x / clip[i].w * 0.5f + 0.5f) * width, (0.5f - clip[i].y / clip[i].w * 0.5f) * height, clip[i].z / clip[i].w);
+        const float area = (p[1].x - p[0].x) * (p[2].y - p[0].y) - (p[2].x - p[0].x) * (p[1].y - p[0].y);
+        if (area == 0.0f)
+            return;
+        const int x0 = std::max(0, int(std::floor(std::min({ p[0].x, p[1].x, p[2].x }))));
+        const int x1 = std::min(width - 1, int(std::ceil(std::max({ p[0].x, p[1].x, p[2].x }))));
+        const int y0 = std::max(0, int(std::floor(std::min({ p[0].y, p[1].y, p[2].y }))));
+        const int y1 = std::min(height - 1, int(std::ceil(std::max({ p[0].y, p[1].y, p[2].y }))));
+        for (int y = y0; y <= y1; y++)
+            for (int x = x0; x <= x1; x++)
+            {
+                const double px = x + 0.5, py = y + 0.5;
+                double weight[3];
+                for (int e = 0; e < 3; e++)
+                {
+                    const glm::vec3 &from = p[(e + 1) % 3], &to = p[(e + 2) % 3];
+                    weight[e] = ((to.x - from.x) * (py - from.y) - (to.y - from.y) * (px - from.x)) / area;
+                }
+                if (weight[0] < 0.0 || weight[1] < 0.0 || weight[2] < 0.0)
+                    continue;
+                const float z = float(weight[0] * p[0].z + weight[1] * p[1].z + weight[2] * p[2].z);
+                const size_t i = size_t(y) * width + x;
+                if (z < depth[i])
+                {
+                    depth[i] = z;
+                    id[i] = object;
+                }
+            }
+    }
+
+    void box(const glm::mat4 &viewProjection, const glm::vec3 &min, const glm::vec3 &max, int object)
+    {
+        glm::vec4 corner[8];
+        for (int c = 0; c < 8; c++)
+            corner[c] = viewProjection * glm::vec4(c & 1 ? max.x : min.x, c & 2 ? max.y : min.y, c & 4 ? max.z : min.z, 1.0f);
+        const int faces[6][4] = { { 0, 1, 3, 2 }, { 4, 5, 7, 6 }, { 0, 1, 5, 4 }, { 2, 3, 7, 6 }, { 0, 2, 6, 4 }, { 1, 3, 7, 5 } };
+        for (const auto &face : faces)
+        {
+            triangle(corner[face[0]], corner[face[1]], corner[face[2]], object);
+            triangle(corner[face[0]], corner[face[2]], corner[face[3]], object);
+        }
+    }
+};
+
+struct Model { std::vector<ObjMesh> meshes; };
+
+static void City(bool quick)
+{
+    Model rock;
+    rock.meshes.push_back(LoadObj(FileSystem::getPath("resources/objects/rock/rock.obj")));
+    const ObjMesh &mesh = rock.meshes[0];
+    if (mesh.indices.empty())
+    {
+        Check(false, "OCCLUSION::ROCK_MISSING");
+        return;
+    }
+    const glm::vec3 size = mesh.max - mesh.min, center = (mesh.max + mesh.min) * 0.5f;
+
+    // blocks of 12x12 and 10-60 high on a 20 unit street grid, unit props in the streets
+    struct Object { glm::mat4 world; glm::vec3 min, max; bool building; };
+    std::vector<Object> objects;
+    std::mt19937 rng(7);
+    std::uniform_real_distribution<float> height(10.0f, 60.0f), unit(0.0f, 1.0f);
+    const int grid = 60;
+    for (int i = 0; i < grid; i++)
+        for (int j = 0; j < grid; j++)
+        {
+            const float h = height(rng);
+            const glm::mat4 world = glm::translate(glm::mat4(1.0f), glm::vec3(i * 20.0f, h * 0.5f, j * 20.0f)) *
+                                    glm::scale(glm::mat4(1.0f), glm::vec3(12.0f / size.x, h / size.y, 12.0f / size.z)) *
+                                    glm::translate(glm::mat4(1.0f), -center);
+            glm::vec3 min(std::numeric_limits<float>::max()), max(-std::numeric_limits<float>::max());
+            for (const Vertex &v : mesh.vertices)
+            {
+                const glm::vec3 p = glm::vec3(world * glm::vec4(v.Position, 1.0f));
+                min = glm::min(min, p);
+                max = glm::max(max, p);
+            }
+            objects.push_back({ world, min, max, true });
+        }
+    const size_t buildings = objects.size();
+    for (int k = 0; k < 40000; k++)
+    {
+        const glm::vec3 p(unit(rng) * grid * 20.0f, 0.5f, unit(rng) * grid * 20.0f);
+        const float cx = std::floor((p.x + 10.0f) / 20.0f) * 20.0f, cz = std::floor((p.z + 10.0f) / 20.0f) * 20.0f;
+        if (std::abs(p.x - cx) < 7.0f && std::abs(p.z - cz) < 7.0f)
+            continue; // inside a building
+        objects.push_back({ glm::translate(glm::mat4(1.0f), p), p - 0.5f, p + 0.5f, false });
+    }
+    std::printf("city: %zu buildings of %zu triangles, %zu props\n", buildings, mesh.indices.size() / 3, objects.size() - buildings);
+
+    struct View { glm::vec3 position, target; const char *name; };
+    const View views[] = {
+        { { 10.0f, 2.0f, 10.0f }, { 10.0f, 2.0f, 600.0f }, "street, down the avenue" },
+        { { 305.0f, 3.0f, 310.0f }, { 800.0f, 3.0f, 900.0f }, "street corner, diagonal" },
+        { { 600.0f, 80.0f, 600.0f }, { 900.0f, 0.0f, 900.0f }, "above the roofs" } };
+    JobSystem jobs;
+    for (const View &view : views)
+    {
+        const glm::mat4 viewProjection = glm::perspective(glm::radians(60.0f), 16.0f / 9.0f, 0.1f, 1000.0f) *
+                                         glm::lookAt(view.position, view.target, glm::vec3(0.0f, 1.0f, 0.0f));
+        std::vector<size_t> candidates;
+        for (size_t i = 0; i < objects.size(); i++)
+            if (InFrustum(viewProjection, objects[i].min, objects[i].max))
+                candidates.push_back(i);
+
+        // buildings within 150 units are the occluders
+        OcclusionCuller culler;
+        std::vector<uint8_t> culled(objects.size(), 0);
+        const int frames = quick ? 1 : 20;
+        double raster = 0.0, tests = 0.0;
+        size_t occluders = 0, occluded = 0;
+        for (int frame = 0; frame < frames; frame++)
+        {
+            const auto rasterStart = Clock::now();
+            culler.Begin(viewProjection);
+            occluders = 0;
+            for (size_t i = 0; i < buildings; i++)
+                if (glm::distance((objects[i].min + objects[i].max) * 0.5f, view.position) < 150.0f)
+                {
+                    culler.AddOccluder(rock, objects[i].world);
+                    occluders++;
+                }
+            culler.Rasterize(jobs);
+            const auto testStart = Clock::now();
+            occluded = 0;
+            for (size_t i : candidates)
+            {
+                culled[i] = !culler.IsVisible(objects[i].min, objects[i].max);
+                occluded += culled[i];
+            }
+            const auto end = Clock::now();
+            raster += Milliseconds(rasterStart, testStart);
+            tests += Milliseconds(testStart, end);
+        }
+
+        // the reference draws buildings as meshes and props as boxes at 1024x576
+        ReferenceBuffer reference(1024, 576);
+        for (size_t i : candidates)
+        {
+            if (!objects[i].building)
+            {
+                reference.box(viewProjection, objects[i].min, objects[i].max, int(i));
+                continue;
+            }
+            const glm::mat4 transform = viewProjection * objects[i].world;
+            for (size_t k = 0; k + 2 < mesh.indices.size(); k += 3)
+                reference.triangle(transform * glm::vec4(mesh.vertices[mesh.indices[k]].Position, 1.0f),
+                                   transform * glm::vec4(mesh.vertices[mesh.indices[k + 1]].Position, 1.0f),
+                                   transform * glm::vec4(mesh.vertices[mesh.indices[k + 2]].Position, 1.0f), int(i));
+        }
+        std::vector<uint8_t> seen(objects.size(), 0);
+        for (int id : reference.id)
+            if (id >= 0)
+                seen[id] = 1;
+        size_t hidden = 0, wrong = 0;
+        for (size_t i : candidates)
+        {
+            hidden += !seen[i];
+            wrong += seen[i] && culled[i];
+        }
+        Check(wrong == 0, "OCCLUSION::VISIBLE_OBJECT_CULLED");
+        std::printf("  %-24s %6zu in frustum, %6zu culled (%.1f%%, ideal %.1f%%), %zu wrongly | %3zu occluders, %6zu triangles: "
+                    "raster %.2f ms, tests %.2f ms\n", view.name, candidates.size(), occluded, 100.0 * occluded / candidates.size(),
+                    100.0 * hidden / candidates.size(), wrong, occluders, culler.TriangleCount(), raster / frames, tests / frames);
+    }
+}
+
+static void Planet()
+{
+    const ObjMesh planet = LoadObj(FileSystem::getPath("resources/objects/planet/planet.obj"));
+    if (planet.indices.empty())
+    {
+        Check(false, "OCCLUSION::PLANET_MISSING");
+        return;
+    }
+    const float radius = (planet.max.x - planet.min.x) * 0.5f, half = radius * 0.3f;
+    const glm::mat4 projection = glm::perspective(glm::radians(45.0f), 800.0f / 600.0f, 0.1f, 100.0f);
+    // a box right behind the planet and one reaching out beside it
+    const glm::vec3 boxes[2][2] = { { glm::vec3(-half, -half, -radius - 2.0f * half), glm::vec3(half, half, -radius - 0.01f) },
+                                    { glm::vec3(radius * 0.9f, -half, -radius - 2.0f * half), glm::vec3(radius * 1.3f, half, -radius - 0.01f) } };
+    for (float distance : { 30.0f, 15.0f, 8.0f })
+    {
+        const glm::mat4 viewProjection = projection * glm::lookAt(glm::vec3(0.0f, 0.0f, distance), glm::vec3(0.0f), glm::vec3(0.0f, 1.0f, 0.0f));
+        OcclusionCuller culler;
+        culler.Begin(viewProjection);
+        culler.AddOccluder(planet.vertices, planet.indices, glm::mat4(1.0f));
+        culler.Rasterize();
+        size_t written = 0;
+        for (int i = 0; i < culler.Width() * culler.Height(); i++)
+            written += culler.Depth()[i] < std::numeric_limits<float>::max();
+
+        ReferenceBuffer reference(800, 600);
+        for (size_t k = 0; k + 2 < planet.indices.size(); k += 3)
+            reference.triangle(viewProjection * glm::vec4(planet.vertices[planet.indices[k]].Position, 1.0f),
+                               viewProjection * glm::vec4(planet.vertices[planet.indices[k + 1]].Position, 1.0f),
+                               viewProjection * glm::vec4(planet.vertices[planet.indices[k + 2]].Position, 1.0f), 0);
+        bool visible[2], seen[2] = { false, false };
+        for (int b = 0; b < 2; b++)
+        {
+            visible[b] = culler.IsVisible(boxes[b][0], boxes[b][1]);
+            reference.box(viewProjection, boxes[b][0], boxes[b][1], b + 1);
+            for (int id : reference.id)
+                seen[b] = seen[b] || id == b + 1;
+        }
+        // the planet is one closed mesh; it has to hide what sits straight behind it
+        Check(!visible[0], "OCCLUSION::BOX_BEHIND_PLANET_VISIBLE");
+        Check(visible[0] || !seen[0], "OCCLUSION::VISIBLE_OBJECT_CULLED");
+        Check(visible[1] || !seen[1], "OCCLUSION::VISIBLE_OBJECT_CULLED");
+        std::printf("planet at %4.0f: %6zu pixels written, box behind %s, box beside it %s (reference: %s)\n", distance, written,
+                    visible[0] ? "visible" : "culled", visible[1] ? "visible" : "culled", seen[1] ? "visible" : "hidden");
+    }
+}
+
+int main(int argc, char **argv)
+{
+    const bool quick = Quick(argc, argv);
+#if defined(LOGL_SSE2)
+    std::printf("SSE2 path\n");
+#else
+    std::printf("scalar path\n");
+#endif
+    City(quick);
+    Planet();
+    return Failures() != 0;
+}
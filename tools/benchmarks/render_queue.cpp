@@ -0,0 +1,229 @@
+// The same scene drawn the way drawSelfAndChild() draws it, one Model::Draw per entity in traversal order, and
+// through RenderQueue (Push, Sort, Submit), with the instanced shader of the frustum culling demo. Prints the draw
+// calls, program / material / vertex array binds and CPU time of each. The entities use a handful of models of two
+// meshes each, spread in front of the camera in random order. The queue must draw every mesh once per entity and
+// produce the same image.
+// Arguments after --quick: entity count (default 20000) and model count (default 8).
+#include "gl_context.h"
+#include "benchmark.h"
+
+#include <learnopengl/filesystem.h>
+#include <learnopengl/mesh.h>
+#include <learnopengl/render_queue.h>
+#include <learnopengl/shader.h>
+
+#include <glm/gtc/matrix_transform.hpp>
+
+#include <cstdio>
+#include <cstdlib>
+#include <random>
+#include <string>
+#include <vector>
+
+using namespace Benchmark;
+
+// the part of Model the two paths use
+struct SceneModel
+{
+    std::vector<Mesh> meshes;
+
+    void Draw(Shader &shader)
+    {
+        for (Mesh &mesh : meshes)
+            mesh.Draw(shader);
+    }
+};
+
+// what drawing through Model::Draw binds, counted the way RenderQueueStats counts the queue's binds
+struct InlineStats
+{
+    unsigned int draws = 0;
+    unsigned int programBinds = 0;
+    unsigned int materialBinds = 0;
+    unsigned int vertexArrayBinds = 0;
+};
+
+// latitude/longitude sphere of the given radius, counter-clockwise seen from outside
+static Mesh Sphere(float radius, int rings, int segments, const Texture &texture)
+{
+    const float pi = 3.14159265358979f;
+    std::vector<StaticVertex> vertices;
+    std::vector<unsigned int> indices;
+    for (int r = 0; r <= rings; r++)
+        for (int s = 0; s <= segments; s++)
+        {
+            const float theta = pi * r / rings, phi = 2.0f * pi * s / segments;
+            StaticVertex v{};
+            v.Normal = glm::vec3(std::sin(theta) * std::cos(phi), std::cos(theta), std::sin(theta) * std::sin(phi));
+            v.Position = v.Normal * radius;
+            v.TexCoords = glm::vec2(float(s) / segments, float(r) / rings);
+            vertices.push_back(v);
+        }
+    for (int r = 0; r < rings; r++)
+        for (int s = 0; s < segments; s++)
+        {
+            const unsigned int a = r * (segments + 1) + s, b = a + segments + 1;
+            indices.insert(indices.end(), { a, a + 1, b, a + 1, b + 1, b });
+        }
+    return Mesh(vertices, indices, { texture });
+}
+
+// 2x2 texels of one colour
+static Texture SolidTexture(const glm::u8vec4 &color)
+{
+    const glm::u8vec4 texels[4] = { color, color, color, color };
+    Texture texture{ 0, "texture_diffuse", "" };
+    glGenTextures(1, &texture.id);
+    glBindTexture(GL_TEXTURE_2D, texture.id);
+    glTexImage2D(GL_TEXTURE_2D, 0, GL_RGBA8, 2, 2, 0, GL_RGBA, GL_UNSIGNED_BYTE, texels);
+    glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MIN_FILTER, GL_NEAREST);
+    glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MAG_FILTER, GL_NEAREST);
+    return texture;
+}
+
+static std::vector<unsigned char> ReadPixels(int size)
+{
+    std::vector<unsigned char> pixels(size_t(size) * size * 4);
+    glReadPixels(0, 0, size, size, GL_RGBA, GL_UNSIGNED_BYTE, pixels.data());
+    return pixels;
+}
+
+int main(int argc, char **argv)
+{
+    const bool quick = Quick(argc, argv);
+    std::vector<const char*> values;
+    for (int i = 1; i < argc; i++)
+        if (argv[i][0] != '-')
+            values.push_back(argv[i]);
+    const int entityCount = values.size() > 0 ? std::atoi(values[0]) : quick ? 2000 : 20000;
+    const int modelCount = values.size() > 1 ? std::atoi(values[1]) : 8;
+    const int frames = quick ? 3 : 10;
+    if (!CreateContext())
+        return 1;
+    {
+        const int size = 128;
+        GLuint framebuffer, colorbuffer, depthbuffer;
+        glGenFramebuffers(1, &framebuffer);
+        glGenRenderbuffers(1, &colorbuffer);
+        glBindRenderbuffer(GL_RENDERBUFFER, colorbuffer);
+        glRenderbufferStorage(GL_RENDERBUFFER, GL_RGBA8, size, size);
+        glGenRenderbuffers(1, &depthbuffer);
+        glBindRenderbuffer(GL_RENDERBUFFER, depthbuffer);
+        glRenderbufferStorage(GL_RENDERBUFFER, GL_DEPTH_COMPONENT24, size, size);
+        glBindFramebuffer(GL_FRAMEBUFFER, framebuffer);
+        glFramebufferRenderbuffer(GL_FRAMEBUFFER, GL_COLOR_ATTACHMENT0, GL_RENDERBUFFER, colorbuffer);
+        glFramebufferRenderbuffer(GL_FRAMEBUFFER, GL_DEPTH_ATTACHMENT, GL_RENDERBUFFER, depthbuffer);
+        glViewport(0, 0, size, size);
+        glEnable(GL_DEPTH_TEST);
+
+        const std::string demo = "src/8.guest/2021/1.scene/2.frustum_culling/";
+        Shader shader(FileSystem::getPath(demo + "1.model_loading.vs").c_str(), FileSystem::getPath(demo + "1.model_loading.fs").c_str());
+        Check(shader.uniforms.Location("instanced") >= 0, "RENDER_QUEUE::NOT_INSTANCED");
+
+        // every model a body and a smaller second mesh, each with its own texture
+        std::mt19937 rng(11);
+        std::vector<Texture> textures;
+        std::vector<SceneModel> models(modelCount);
+        for (int m = 0; m < modelCount; m++)
+        {
+            textures.push_back(SolidTexture(glm::u8vec4(rng() % 256, rng() % 256, rng() % 256, 255)));
+            textures.push_back(SolidTexture(glm::u8vec4(rng() % 256, rng() % 256, rng() % 256, 255)));
+            models[m].meshes.push_back(Sphere(1.0f, 4 + m % 4, 6 + m, textures[textures.size() - 2]));
+            models[m].meshes.push_back(Sphere(0.4f, 3, 4 + m, textures.back()));
+        }
+
+        std::uniform_real_distribution<float> unit(-1.0f, 1.0f), depth(10.0f, 150.0f);
+        std::vector<SceneModel*> entityModels(entityCount);
+        std::vector<glm::mat4> matrices(entityCount);
+        for (int e = 0; e < entityCount; e++)
+        {
+            const float z = depth(rng);
+            const glm::vec3 position(unit(rng) * z * 0.4f, unit(rng) * z * 0.4f, -z);
+            entityModels[e] = &models[rng() % models.size()];
+            matrices[e] = glm::translate(glm::mat4(1.0f), position) * glm::rotate(glm::mat4(1.0f), unit(rng) * 3.0f, glm::vec3(0.0f, 1.0f, 0.0f));
+        }
+        const glm::vec3 cameraPosition(0.0f);
+        const glm::mat4 projection = glm::perspective(glm::radians(45.0f), 1.0f, 0.1f, 200.0f);
+        const glm::mat4 view = glm::lookAt(cameraPosition, glm::vec3(0.0f, 0.0f, -1.0f), glm::vec3(0.0f, 1.0f, 0.0f));
+
+        InlineStats inlineStats;
+        auto drawInline = [&]
+        {
+            inlineStats = InlineStats();
+            shader.use();
+            inlineStats.programBinds++;
+            shader.setMat4("projection", projection);
+            shader.setMat4("view", view);
+            for (int e = 0; e < entityCount; e++)
+            {
+                shader.setMat4("model", matrices[e]);
+                entityModels[e]->Draw(shader);
+                // Mesh::Draw binds the material and the vertex array of every mesh it draws
+                const unsigned int meshes = static_cast<unsigned int>(entityModels[e]->meshes.size());
+                inlineStats.draws += meshes;
+                inlineStats.materialBinds += meshes;
+                inlineStats.vertexArrayBinds += meshes;
+            }
+        };
+
+        RenderQueue queue;
+        auto drawQueued = [&]
+        {
+            shader.use();
+            shader.setMat4("projection", projection);
+            shader.setMat4("view", view);
+            queue.Begin(cameraPosition, 200.0f);
+            for (int e = 0; e < entityCount; e++)
+                queue.Push(0, shader, *entityModels[e], matrices[e]);
+            queue.Sort();
+            queue.Submit();
+        };
+
+        std::vector<unsigned char> images[2];
+        double times[2] = {};
+        auto run = [&](int slot, auto draw)
+        {
+            draw(); // materials compiled, instance buffer allocated
+            glFinish();
+            for (int f = 0; f < frames; f++)
+            {
+                glClear(GL_COLOR_BUFFER_BIT | GL_DEPTH_BUFFER_BIT);
+                const auto start = Clock::now();
+                draw();
+                times[slot] += Milliseconds(start, Clock::now());
+                glFinish();
+            }
+            times[slot] /= frames;
+            images[slot] = ReadPixels(size);
+        };
+        run(0, drawInline);
+        run(1, drawQueued);
+        Check(glGetError() == GL_NO_ERROR, "RENDER_QUEUE::GL_ERROR");
+
+        const RenderQueueStats &stats = queue.stats;
+        Check(stats.instances + (stats.draws - stats.instancedDraws) == inlineStats.draws, "RENDER_QUEUE::MESHES_LOST");
+        size_t differing = 0;
+        for (size_t i = 0; i < images[0].size(); i += 4)
+            differing += images[0][i] != images[1][i] || images[0][i + 1] != images[1][i + 1] || images[0][i + 2] != images[1][i + 2];
+        // both draw the nearest surface of every pixel, only exact depth ties may resolve the other way
+        Check(differing <= images[0].size() / 4 / 1000, "RENDER_QUEUE::IMAGES_DIFFER");
+
+        std::printf("%d entities, %d models of 2 meshes, %d frames:\n", entityCount, modelCount, frames);
+        std::printf("  inline (Model::Draw per entity) %6u draws, %6u program, %6u material, %6u vertex array binds, CPU %7.2f ms\n",
+                    inlineStats.draws, inlineStats.programBinds, inlineStats.materialBinds, inlineStats.vertexArrayBinds, times[0]);
+        std::printf("  RenderQueue                     %6u draws, %6u program, %6u material, %6u vertex array binds, CPU %7.2f ms"
+                    " (sort %.2f ms, submit %.2f ms)\n", stats.draws, stats.programBinds, stats.materialBinds, stats.vertexArrayBinds,
+                    times[1], stats.sortMicroseconds / 1000.0, stats.submitMicroseconds / 1000.0);
+        std::printf("  %u of the queue's draws instanced, covering %u entries; %zu pixels differ\n", stats.instancedDraws, stats.instances, differing);
+
+        queue.Release();
+        for (const Texture &texture : textures)
+            glDeleteTextures(1, &texture.id);
+        glDeleteProgram(shader.ID);
+        glDeleteRenderbuffers(1, &depthbuffer);
+        glDeleteRenderbuffers(1, &colorbuffer);
+        glDeleteFramebuffers(1, &framebuffer);
+    }
+    DestroyContext();
+    return Failures() != 0;
+}
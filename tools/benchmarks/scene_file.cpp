@@ -0,0 +1,102 @@
+// SceneFile round trip of a TransformHierarchy: build a tree procedurally, write it, then open, Assign() and update
+// it again and compare the world matrices. Entity::loadScene() adds one Entity allocation per node on top of this.
+// Argument after --quick: node count (default 1000000).
+#include "benchmark.h"
+
+#include <learnopengl/scene_file.h>
+
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <random>
+#include <string>
+#include <vector>
+
+using namespace Benchmark;
+
+int main(int argc, char **argv)
+{
+    const bool quick = Quick(argc, argv);
+    size_t n = quick ? 20000 : 1000000;
+    for (int i = 1; i < argc; i++)
+        if (argv[i][0] != '-')
+            n = std::strtoul(argv[i], nullptr, 10);
+    const std::string path = "benchmark.scene";
+
+    // eight children per node, two models, a box per model
+    std::mt19937 rng(5);
+    std::uniform_real_distribution<float> position(-500.0f, 500.0f), angle(-180.0f, 180.0f);
+    const auto buildStart = Clock::now();
+    TransformHierarchy hierarchy;
+    hierarchy.Reserve(n);
+    std::vector<uint32_t> models(n);
+    std::vector<BoundingBox> bounds(n);
+    const BoundingBox modelBounds[2] = { { glm::vec3(-1.0f), glm::vec3(1.0f) }, { glm::vec3(-2.0f, 0.0f, -2.0f), glm::vec3(2.0f, 3.0f, 2.0f) } };
+    for (size_t i = 0; i < n; i++)
+    {
+        const uint32_t node = hierarchy.Create(i == 0 ? TransformHierarchy::None : static_cast<uint32_t>((i - 1) / 8));
+        hierarchy.SetLocalPosition(node, glm::vec3(position(rng), position(rng), position(rng)));
+        hierarchy.SetLocalRotation(node, glm::vec3(angle(rng) * 0.4f, angle(rng), angle(rng)));
+        hierarchy.SetLocalScale(node, glm::vec3(1.0f + (i % 5) * 0.1f));
+        models[i] = i % 3 ? 0 : 1;
+        bounds[i] = modelBounds[models[i]];
+    }
+    hierarchy.Update();
+    const auto saveStart = Clock::now();
+    const bool saved = SceneFile::Write(path, hierarchy, models, bounds, { "resources/objects/planet/planet.obj", "resources/objects/rock/rock.obj" });
+    const auto saveEnd = Clock::now();
+    Check(saved, "SCENE_FILE::WRITE_FAILED");
+    std::printf("%zu nodes, %zu levels: procedural build %.0f ms, save %.0f ms\n", n, hierarchy.Depth(),
+                Milliseconds(buildStart, saveStart), Milliseconds(saveStart, saveEnd));
+
+    // a fresh hierarchy pays the page faults of its arrays, one that already held the scene does not
+    TransformHierarchy reused;
+    {
+        SceneFile scene;
+        if (scene.open(path))
+            scene.assignTo(reused);
+    }
+    for (int rep = 0; rep < 3; rep++)
+    {
+        const auto openStart = Clock::now();
+        SceneFile scene;
+        const bool opened = scene.open(path);
+        const auto assignStart = Clock::now();
+        TransformHierarchy fresh;
+        TransformHierarchy &loaded = rep == 0 ? fresh : reused;
+        scene.assignTo(loaded);
+        const auto updateStart = Clock::now();
+        loaded.Update();
+        const auto end = Clock::now();
+        Check(opened, "SCENE_FILE::OPEN_FAILED");
+        if (!opened)
+            break;
+
+        bool identical = loaded.Size() == n && scene.modelCount() == 2;
+        for (size_t i = 0; identical && i < n; i++)
+            identical = std::memcmp(&loaded.world[i], &hierarchy.world[i], sizeof(glm::mat4)) == 0 &&
+                        scene.models()[i] == models[i] && scene.bounds()[i].min == bounds[i].min && scene.bounds()[i].max == bounds[i].max;
+        Check(identical, "SCENE_FILE::ROUND_TRIP_MISMATCH");
+        std::printf("open %.2f ms | assign into a %s hierarchy %.1f ms | world update %.1f ms | %s\n",
+                    Milliseconds(openStart, assignStart), rep == 0 ? "fresh" : "reused", Milliseconds(assignStart, updateStart),
+                    Milliseconds(updateStart, end), identical ? "bit identical" : "MISMATCH");
+    }
+
+    // a child whose parent index isn't smaller than its own is rejected
+    {
+        std::FILE *file = std::fopen(path.c_str(), "r+b");
+        if (file)
+        {
+            SceneFileHeader header;
+            const bool read = std::fread(&header, sizeof(header), 1, file) == 1;
+            const uint32_t bad = static_cast<uint32_t>(n + 1);
+            const bool written = read && std::fseek(file, static_cast<long>(header.parentsOffset + sizeof(uint32_t) * (n / 2)), SEEK_SET) == 0 &&
+                                 std::fwrite(&bad, sizeof(bad), 1, file) == 1;
+            std::fclose(file);
+            SceneFile scene;
+            Check(written && !scene.open(path), "SCENE_FILE::CORRUPT_FILE_ACCEPTED");
+        }
+    }
+    std::remove(path.c_str());
+    return Failures() != 0;
+}
@@ -0,0 +1,284 @@
+// SpatialHash inserts, per-frame moves and box / k-nearest / ray queries against linear scans over the same boxes.
+// Then the same number of entities under one root, kept in an EntityGrid: each frame moves 1% and then all of them,
+// runs updateSelfAndChild() and EntityGrid::update(), which only walks the hierarchy's changed nodes, next to the
+// scan of every entity's Changed() flag the grid did before. Box queries must match a linear scan of the entities.
+// Arguments after --quick: box count (default 1000000) and the half width of the area (default 1000).
+#include "benchmark.h"
+
+#include <learnopengl/bounds.h>
+#include <learnopengl/camera.h>
+#include <learnopengl/mesh.h>
+#include <learnopengl/shader.h>
+#include <learnopengl/spatial_hash.h>
+
+#include <string>
+
+// entity.h only reads the bounds and path of a model and draws it; this stands in for model.h, which needs Assimp
+struct Model
+{
+    MeshBounds bounds;
+    std::string path;
+    std::vector<Mesh> meshes;
+
+    void Draw(Shader &) {}
+};
+
+#include <learnopengl/entity.h>
+
+#include <algorithm>
+#include <cstdio>
+#include <cstdlib>
+#include <random>
+#include <utility>
+#include <vector>
+
+using namespace Benchmark;
+
+static bool Overlaps(const BoundingBox &a, const BoundingBox &b)
+{
+    return glm::all(glm::lessThanEqual(a.min, b.max)) && glm::all(glm::lessThanEqual(b.min, a.max));
+}
+
+static float DistanceSquared(const BoundingBox &box, const glm::vec3 &point)
+{
+    const glm::vec3 d = glm::max(glm::max(box.min - point, point - box.max), glm::vec3(0.0f));
+    return glm::dot(d, d);
+}
+
+static bool RayHit(const BoundingBox &box, const glm::vec3 &origin, const glm::vec3 &inverseDirection, float maxDistance, float &t)
+{
+    const glm::vec3 t0 = (box.min - origin) * inverseDirection, t1 = (box.max - origin) * inverseDirection;
+    const glm::vec3 near = glm::min(t0, t1), far = glm::max(t0, t1);
+    const float enter = std::max(near.x, std::max(near.y, near.z)), exit = std::min(far.x, std::min(far.y, far.z));
+    if (!(enter <= exit && exit >= 0.0f))
+        return false;
+    t = std::max(enter, 0.0f);
+    return t <= maxDistance;
+}
+
+// the world box EntityGrid keeps for an entity
+static BoundingBox WorldBox(Entity &entity)
+{
+    const AABB box = entity.getGlobalAABB();
+    return BoundingBox{ box.center - box.extents, box.center + box.extents };
+}
+
+static void EntityPath(size_t n, float width, int queries, std::mt19937 &rng)
+{
+    std::uniform_real_distribution<float> position(-width, width), jitter(-0.5f, 0.5f);
+    std::vector<Model> models(4);
+    for (size_t m = 0; m < models.size(); m++)
+    {
+        const glm::vec3 extents(0.2f + 0.4f * m);
+        models[m].bounds.box = { -extents, extents };
+        models[m].path = "model" + std::to_string(m);
+    }
+
+    Entity root(models[0]);
+    std::vector<Entity*> entities(n);
+    root.hierarchy->Reserve(n + 1);
+    root.children.reserve(n);
+    for (size_t i = 0; i < n; i++)
+    {
+        root.addChild(models[rng() % models.size()]);
+        entities[i] = root.children.back().get();
+        entities[i]->transform.setLocalPosition(glm::vec3(position(rng), position(rng) * 0.1f, position(rng)));
+    }
+    root.forceUpdateSelfAndChild();
+
+    const auto buildStart = Clock::now();
+    EntityGrid grid(root);
+    std::printf("%zu entities: EntityGrid built in %.1f ms\n", n, Milliseconds(buildStart, Clock::now()));
+
+    const size_t strides[] = { 100, 1 }; // every 100th entity moves, then all of them
+    for (int frame = 0; frame < 4; frame++)
+    {
+        const size_t step = strides[frame / 2];
+        size_t moving = 0;
+        for (size_t i = static_cast<size_t>(frame) % step; i < n; i += step, moving++)
+        {
+            const glm::vec3 delta(jitter(rng), jitter(rng) * 0.1f, jitter(rng));
+            entities[i]->transform.setLocalPosition(entities[i]->transform.getLocalPosition() + delta);
+        }
+        const auto updateStart = Clock::now();
+        root.updateSelfAndChild();
+        const auto gridStart = Clock::now();
+        grid.update();
+        const auto scanStart = Clock::now();
+        size_t scanned = 0;
+        for (Entity *entity : entities)
+            scanned += entity->hierarchy->Changed(entity->transform.getNode());
+        const auto end = Clock::now();
+        Check(root.hierarchy->ChangedNodes().size() == moving && scanned == moving, "SPATIAL_HASH::ENTITY_CHANGED_COUNT");
+        std::printf("frame %d, %zu moved: updateSelfAndChild %.2f ms, EntityGrid::update %.2f ms, scan of every Changed() flag %.2f ms\n",
+                    frame, moving, Milliseconds(updateStart, gridStart), Milliseconds(gridStart, scanStart), Milliseconds(scanStart, end));
+    }
+
+    double gridTime = 0.0, linearTime = 0.0;
+    size_t mismatches = 0, found = 0;
+    for (int q = 0; q < queries; q++)
+    {
+        const glm::vec3 center(position(rng), 0.0f, position(rng));
+        const BoundingBox range{ center - glm::vec3(10.0f), center + glm::vec3(10.0f) };
+        std::vector<Entity*> hits, expected;
+        const auto gridStart = Clock::now();
+        grid.queryBox(range, hits);
+        const auto linearStart = Clock::now();
+        for (Entity *entity : entities)
+            if (Overlaps(WorldBox(*entity), range))
+                expected.push_back(entity);
+        const auto end = Clock::now();
+        gridTime += Milliseconds(gridStart, linearStart);
+        linearTime += Milliseconds(linearStart, end);
+        hits.erase(std::remove(hits.begin(), hits.end(), &root), hits.end());
+        std::sort(hits.begin(), hits.end());
+        std::sort(expected.begin(), expected.end());
+        mismatches += hits != expected;
+        found += hits.size();
+    }
+    Check(mismatches == 0, "SPATIAL_HASH::ENTITY_QUERY_MISMATCH");
+    std::printf("entity box query (20 units): grid %.3f ms, linear %.2f ms, %zu mismatches, %.1f hits on average\n",
+                gridTime / queries, linearTime / queries, mismatches, found / double(queries));
+}
+
+int main(int argc, char **argv)
+{
+    const bool quick = Quick(argc, argv);
+    std::vector<const char*> values;
+    for (int i = 1; i < argc; i++)
+        if (argv[i][0] != '-')
+            values.push_back(argv[i]);
+    const size_t n = values.size() > 0 ? std::strtoul(values[0], nullptr, 10) : quick ? 20000 : 1000000;
+    const float width = values.size() > 1 ? std::strtof(values[1], nullptr) : quick ? 150.0f : 1000.0f;
+
+    std::mt19937 rng(7);
+    std::uniform_real_distribution<float> position(-width, width), size(0.2f, 1.5f), jitter(-0.5f, 0.5f);
+    std::vector<BoundingBox> boxes(n);
+    for (BoundingBox &box : boxes)
+    {
+        const glm::vec3 center(position(rng), position(rng) * 0.1f, position(rng));
+        glm::vec3 extents(size(rng));
+        if (rng() % 1000 == 0)
+            extents *= 10.0f; // a few boxes too large for one cell
+        box = { center - extents, center + extents };
+    }
+
+    SpatialHash grid(4.0f);
+    std::vector<int32_t> proxies(n);
+    const auto insertStart = Clock::now();
+    for (size_t i = 0; i < n; i++)
+        proxies[i] = grid.Insert(boxes[i], static_cast<uint32_t>(i));
+    const double insert = Milliseconds(insertStart, Clock::now());
+    std::printf("%zu boxes: insert %.1f ms (%.0f ns each), %zu cells\n", n, insert, insert * 1e6 / n, grid.CellCount());
+
+    for (int frame = 0; frame < 3; frame++)
+    {
+        for (BoundingBox &box : boxes)
+        {
+            const glm::vec3 delta(jitter(rng), jitter(rng) * 0.1f, jitter(rng));
+            box.min += delta;
+            box.max += delta;
+        }
+        const auto moveStart = Clock::now();
+        for (size_t i = 0; i < n; i++)
+            grid.Move(proxies[i], boxes[i]);
+        const double move = Milliseconds(moveStart, Clock::now());
+        std::printf("frame %d: move every box %.1f ms (%.0f ns each)\n", frame, move, move * 1e6 / n);
+    }
+    for (size_t i = 0; i < n; i += 97)
+        grid.Remove(proxies[i]);
+    for (size_t i = 0; i < n; i += 97)
+        proxies[i] = grid.Insert(boxes[i], static_cast<uint32_t>(i));
+
+    const int queries = quick ? 10 : 50;
+    double gridTime = 0.0, linearTime = 0.0;
+    size_t mismatches = 0, found = 0;
+    for (int q = 0; q < queries; q++)
+    {
+        const glm::vec3 center(position(rng), 0.0f, position(rng));
+        const BoundingBox range{ center - glm::vec3(10.0f), center + glm::vec3(10.0f) };
+        std::vector<uint32_t> hits, expected;
+        const auto gridStart = Clock::now();
+        grid.Query(range, [&](uint32_t i) { hits.push_back(i); });
+        const auto linearStart = Clock::now();
+        for (size_t i = 0; i < n; i++)
+            if (Overlaps(boxes[i], range))
+                expected.push_back(static_cast<uint32_t>(i));
+        const auto end = Clock::now();
+        gridTime += Milliseconds(gridStart, linearStart);
+        linearTime += Milliseconds(linearStart, end);
+        std::sort(hits.begin(), hits.end());
+        mismatches += hits != expected;
+        found += hits.size();
+    }
+    Check(mismatches == 0, "SPATIAL_HASH::QUERY_MISMATCH");
+    std::printf("box query (20 units): grid %.3f ms, linear %.2f ms, %zu mismatches, %.1f hits on average\n",
+                gridTime / queries, linearTime / queries, mismatches, found / double(queries));
+
+    gridTime = linearTime = 0.0;
+    mismatches = 0;
+    const size_t k = 8;
+    for (int q = 0; q < queries; q++)
+    {
+        const glm::vec3 point(position(rng), 0.0f, position(rng));
+        std::vector<uint32_t> nearest;
+        const auto gridStart = Clock::now();
+        grid.Nearest(point, k, nearest);
+        const auto linearStart = Clock::now();
+        std::vector<std::pair<float, uint32_t>> all(n);
+        for (size_t i = 0; i < n; i++)
+            all[i] = { DistanceSquared(boxes[i], point), static_cast<uint32_t>(i) };
+        std::partial_sort(all.begin(), all.begin() + k, all.end());
+        const auto end = Clock::now();
+        gridTime += Milliseconds(gridStart, linearStart);
+        linearTime += Milliseconds(linearStart, end);
+        // ties may come back in another order, so compare distances
+        bool same = nearest.size() == k;
+        for (size_t i = 0; same && i < k; i++)
+            same = DistanceSquared(boxes[nearest[i]], point) == all[i].first;
+        mismatches += !same;
+    }
+    Check(mismatches == 0, "SPATIAL_HASH::NEAREST_MISMATCH");
+    std::printf("%zu-nearest: grid %.3f ms, linear %.2f ms, %zu mismatches\n", k, gridTime / queries, linearTime / queries, mismatches);
+
+    gridTime = linearTime = 0.0;
+    mismatches = 0;
+    size_t rayHits = 0;
+    const float maxDistance = 500.0f;
+    for (int q = 0; q < queries; q++)
+    {
+        const glm::vec3 origin(position(rng), position(rng) * 0.1f, position(rng));
+        const glm::vec3 direction = glm::normalize(glm::vec3(jitter(rng), jitter(rng) * 0.2f, jitter(rng)));
+        uint32_t id;
+        float t;
+        const auto gridStart = Clock::now();
+        const bool hit = grid.Raycast(origin, direction, maxDistance, id, t);
+        const auto linearStart = Clock::now();
+        const glm::vec3 inverseDirection = 1.0f / direction;
+        float best = maxDistance;
+        bool expected = false;
+        for (size_t i = 0; i < n; i++)
+        {
+            float distance;
+            if (RayHit(boxes[i], origin, inverseDirection, best, distance))
+            {
+                best = distance;
+                expected = true;
+            }
+        }
+        const auto end = Clock::now();
+        gridTime += Milliseconds(gridStart, linearStart);
+        linearTime += Milliseconds(linearStart, end);
+        rayHits += hit;
+        mismatches += hit != expected || (hit && t != best);
+    }
+    Check(mismatches == 0, "SPATIAL_HASH::RAYCAST_MISMATCH");
+    std::printf("raycast (%.0f units): grid %.3f ms, linear %.2f ms, %zu mismatches, %zu hits\n", maxDistance,
+                gridTime / queries, linearTime / queries, mismatches, rayHits);
+
+    boxes.clear();
+    boxes.shrink_to_fit();
+    grid.Clear(4.0f);
+    EntityPath(n, width, queries, rng);
+    return Failures() != 0;
+}
@@ -0,0 +1,494 @@
+// TransformHierarchy on a 4-ary tree of random transforms:
+//   - against a replica of the Entity tree it replaced (std::list of children, recursive update, local matrix from
+//     three glm::rotate calls), with the root rotated so every node updates and with 1% of the nodes edited. World
+//     matrices must agree to within 1e-4 of the largest element.
+//   - quaternions with a cached local matrix against the flat euler version before them, which rebuilt the local
+//     matrix from the euler angles for every node it updated, with every local changed and with only the root
+//     changed. World matrices must agree to within 3.3e-5 of the largest element.
+//   - Update(jobs) against the serial Update(), with random sparse edits every frame and the root rotated every
+//     fourth. The world matrices and Changed() flags of both must be bitwise identical after every frame, and
+//     ChangedNodes() must hold the same nodes, exactly the ones Changed() is true for. The grain is kept small so
+//     every level below the first few is split over the pool's threads.
+//   - UpdateSubtree() of the root's first child against Update(), with edits inside that subtree applied to both and
+//     one edit outside it applied to the subtree side only. Inside the subtree the world matrices must be bitwise
+//     identical and both must report the same changed nodes; the edit outside has to stay dirty.
+#include "benchmark.h"
+
+#include <learnopengl/job_system.h>
+#include <learnopengl/transform_hierarchy.h>
+
+#include <glm/gtc/matrix_transform.hpp>
+
+#include <algorithm>
+#include <cmath>
+#include <cstdio>
+#include <list>
+#include <memory>
+#include <random>
+#include <thread>
+#include <vector>
+
+using namespace Benchmark;
+
+// a local transform per node of a 4-ary tree in breadth first order, node i under (i - 1) / 4
+struct TreeSource
+{
+    std::vector<glm::vec3> positions, rotations, scales;
+
+    TreeSource(size_t count, unsigned int seed) : positions(count), rotations(count), scales(count)
+    {
+        std::mt19937 rng(seed);
+        std::uniform_real_distribution<float> offset(-2.0f, 2.0f), angle(-180.0f, 180.0f), scale(0.9f, 1.1f);
+        for (size_t i = 0; i < count; i++)
+        {
+            positions[i] = glm::vec3(offset(rng), offset(rng), offset(rng));
+            rotations[i] = glm::vec3(angle(rng) * 0.5f, angle(rng), angle(rng));
+            scales[i] = glm::vec3(scale(rng), scale(rng), scale(rng));
+        }
+    }
+
+    static uint32_t Parent(size_t i) { return i == 0 ? TransformHierarchy::None : static_cast<uint32_t>((i - 1) / 4); }
+};
+
+// the Transform and Entity update before TransformHierarchy, reduced to what the update touches
+struct ListTransform
+{
+    glm::vec3 m_pos = { 0.0f, 0.0f, 0.0f };
+    glm::vec3 m_eulerRot = { 0.0f, 0.0f, 0.0f };
+    glm::vec3 m_scale = { 1.0f, 1.0f, 1.0f };
+    glm::mat4 m_modelMatrix = glm::mat4(1.0f);
+    bool m_isDirty = true;
+
+    glm::mat4 getLocalModelMatrix()
+    {
+        const glm::mat4 transformX = glm::rotate(glm::mat4(1.0f), glm::radians(m_eulerRot.x), glm::vec3(1.0f, 0.0f, 0.0f));
+        const glm::mat4 transformY = glm::rotate(glm::mat4(1.0f), glm::radians(m_eulerRot.y), glm::vec3(0.0f, 1.0f, 0.0f));
+        const glm::mat4 transformZ = glm::rotate(glm::mat4(1.0f), glm::radians(m_eulerRot.z), glm::vec3(0.0f, 0.0f, 1.0f));
+        const glm::mat4 rotationMatrix = transformY * transformX * transformZ;
+        return glm::translate(glm::mat4(1.0f), m_pos) * rotationMatrix * glm::scale(glm::mat4(1.0f), m_scale);
+    }
+
+    void computeModelMatrix()
+    {
+        m_modelMatrix = getLocalModelMatrix();
+        m_isDirty = false;
+    }
+
+    void computeModelMatrix(const glm::mat4& parentGlobalModelMatrix)
+    {
+        m_modelMatrix = parentGlobalModelMatrix * getLocalModelMatrix();
+        m_isDirty = false;
+    }
+};
+
+struct ListEntity
+{
+    std::list<std::unique_ptr<ListEntity>> children;
+    ListEntity* parent = nullptr;
+    ListTransform transform;
+
+    void updateSelfAndChild()
+    {
+        if (transform.m_isDirty) {
+            forceUpdateSelfAndChild();
+            return;
+        }
+        for (auto&& child : children)
+            child->updateSelfAndChild();
+    }
+
+    void forceUpdateSelfAndChild()
+    {
+        if (parent)
+            transform.computeModelMatrix(parent->transform.m_modelMatrix);
+        else
+            transform.computeModelMatrix();
+        for (auto&& child : children)
+            child->forceUpdateSelfAndChild();
+    }
+};
+
+// the same tree as entities; nodes[i] is node i of the hierarchy
+static std::unique_ptr<ListEntity> BuildList(const TreeSource &source, std::vector<ListEntity*> &nodes)
+{
+    std::unique_ptr<ListEntity> root(new ListEntity());
+    nodes.assign(1, root.get());
+    for (size_t i = 0; i < source.positions.size(); i++)
+    {
+        if (i > 0)
+        {
+            ListEntity *parent = nodes[TreeSource::Parent(i)];
+            parent->children.emplace_back(new ListEntity());
+            parent->children.back()->parent = parent;
+            nodes.push_back(parent->children.back().get());
+        }
+        nodes[i]->transform.m_pos = source.positions[i];
+        nodes[i]->transform.m_eulerRot = source.rotations[i];
+        nodes[i]->transform.m_scale = source.scales[i];
+    }
+    return root;
+}
+
+// TransformHierarchy before quaternions: euler angles, the local matrix recomputed whenever the world matrix is
+struct EulerHierarchy
+{
+    std::vector<glm::vec3> localPosition, localRotation, localScale;
+    std::vector<uint32_t> parent;
+    std::vector<glm::mat4> world;
+    std::vector<uint8_t> dirty, changed;
+
+    explicit EulerHierarchy(const TreeSource &source)
+        : localPosition(source.positions), localRotation(source.rotations), localScale(source.scales),
+          parent(source.positions.size()), world(source.positions.size()), dirty(source.positions.size(), 1), changed(source.positions.size())
+    {
+        for (size_t i = 0; i < parent.size(); i++)
+            parent[i] = TreeSource::Parent(i);
+    }
+
+    void Update()
+    {
+        const size_t count = parent.size();
+        for (size_t i = 0; i < count; i++)
+        {
+            const uint32_t p = parent[i];
+            const uint8_t update = dirty[i] | (p != TransformHierarchy::None ? changed[p] : 0);
+            changed[i] = update;
+            if (!update)
+                continue;
+            const glm::mat4 local = ComposeLocal(localPosition[i], localRotation[i], localScale[i]);
+            world[i] = p != TransformHierarchy::None ? world[p] * local : local;
+            dirty[i] = 0;
+        }
+    }
+
+    static glm::mat4 ComposeLocal(const glm::vec3 &position, const glm::vec3 &eulerDegrees, const glm::vec3 &scale)
+    {
+        const glm::vec3 angles = glm::radians(eulerDegrees);
+        const float cx = std::cos(angles.x), sx = std::sin(angles.x);
+        const float cy = std::cos(angles.y), sy = std::sin(angles.y);
+        const float cz = std::cos(angles.z), sz = std::sin(angles.z);
+
+        glm::mat4 m;
+        m[0] = glm::vec4(cy * cz + sy * sx * sz, cx * sz, cy * sx * sz - sy * cz, 0.0f) * scale.x;
+        m[1] = glm::vec4(sy * sx * cz - cy * sz, cx * cz, sy * sz + cy * sx * cz, 0.0f) * scale.y;
+        m[2] = glm::vec4(sy * cx, -sx, cy * cx, 0.0f) * scale.z;
+        m[3] = glm::vec4(position, 1.0f);
+        return m;
+    }
+};
+
+static void Build(TransformHierarchy &hierarchy, const TreeSource &source)
+{
+    hierarchy.Reserve(source.positions.size());
+    for (size_t i = 0; i < source.positions.size(); i++)
+    {
+        const uint32_t node = hierarchy.Create(TreeSource::Parent(i));
+        hierarchy.SetLocalPosition(node, source.positions[i]);
+        hierarchy.SetLocalRotation(node, source.rotations[i]);
+        hierarchy.SetLocalScale(node, source.scales[i]);
+    }
+}
+
+// a frame of edits: editCount random nodes get a new position, euler rotation, orientation or scale, and with
+// rotateRoot the root turns as well
+static void Edit(TransformHierarchy &hierarchy, std::mt19937 &rng, size_t editCount, bool rotateRoot)
+{
+    std::uniform_int_distribution<uint32_t> pick(0, static_cast<uint32_t>(hierarchy.Size() - 1));
+    std::uniform_real_distribution<float> unit(-1.0f, 1.0f);
+    for (size_t e = 0; e < editCount; e++)
+    {
+        const uint32_t node = pick(rng);
+        const glm::vec3 value(unit(rng), unit(rng), unit(rng));
+        switch (rng() % 4)
+        {
+        case 0: hierarchy.SetLocalPosition(node, value * 2.0f); break;
+        case 1: hierarchy.SetLocalRotation(node, value * 90.0f); break;
+        case 2: hierarchy.SetLocalOrientation(node, glm::quat(1.0f, value.x, value.y, value.z)); break;
+        default: hierarchy.SetLocalScale(node, glm::vec3(1.0f) + value * 0.1f); break;
+        }
+    }
+    if (rotateRoot)
+        hierarchy.SetLocalRotation(0, hierarchy.localRotation[0] + glm::vec3(0.0f, 1.5f, 0.0f));
+}
+
+static bool SameResult(const TransformHierarchy &a, const TransformHierarchy &b)
+{
+    if (std::memcmp(a.world.data(), b.world.data(), a.world.size() * sizeof(glm::mat4)) != 0 || a.dirty != b.dirty)
+        return false;
+    size_t changed = 0;
+    for (uint32_t i = 0; i < a.Size(); i++)
+    {
+        if (a.Changed(i) != b.Changed(i))
+            return false;
+        changed += a.Changed(i);
+    }
+    // the parallel list is in level order, the serial one in index order
+    std::vector<uint32_t> listA = a.ChangedNodes(), listB = b.ChangedNodes();
+    std::sort(listA.begin(), listA.end());
+    std::sort(listB.begin(), listB.end());
+    if (listA != listB || listA.size() != changed)
+        return false;
+    for (uint32_t node : listA)
+        if (!a.Changed(node))
+            return false;
+    return true;
+}
+
+// largest difference between two world matrices relative to the largest element of the reference
+static float MaxRelativeError(const std::vector<glm::mat4> &world, const std::vector<glm::mat4> &reference)
+{
+    float error = 0.0f;
+    for (size_t i = 0; i < world.size(); i++)
+    {
+        float difference = 0.0f, magnitude = 0.0f;
+        for (int c = 0; c < 4; c++)
+            for (int r = 0; r < 4; r++)
+            {
+                difference = std::max(difference, std::abs(world[i][c][r] - reference[i][c][r]));
+                magnitude = std::max(magnitude, std::abs(reference[i][c][r]));
+            }
+        error = std::max(error, difference / std::max(magnitude, 1e-6f));
+    }
+    return error;
+}
+
+static void ListAgainstFlat(size_t count, int frames)
+{
+    const TreeSource source(count, 1);
+    std::vector<ListEntity*> nodes;
+    std::unique_ptr<ListEntity> root = BuildList(source, nodes);
+    TransformHierarchy flat;
+    Build(flat, source);
+    root->forceUpdateSelfAndChild();
+    flat.Update();
+
+    std::vector<glm::mat4> listWorld(count);
+    auto compare = [&]()
+    {
+        for (size_t i = 0; i < count; i++)
+            listWorld[i] = nodes[i]->transform.m_modelMatrix;
+        return MaxRelativeError(flat.world, listWorld);
+    };
+    float error = compare();
+
+    // every node updates: the root turns
+    double listAll = 0.0, flatAll = 0.0;
+    for (int f = 0; f < frames; f++)
+    {
+        const glm::vec3 rotation = source.rotations[0] + glm::vec3(0.0f, 1.5f * (f + 1), 0.0f);
+        nodes[0]->transform.m_eulerRot = rotation;
+        nodes[0]->transform.m_isDirty = true;
+        flat.SetLocalRotation(0, rotation);
+        const auto listStart = Clock::now();
+        root->updateSelfAndChild();
+        const auto flatStart = Clock::now();
+        flat.Update();
+        const auto end = Clock::now();
+        listAll += Milliseconds(listStart, flatStart);
+        flatAll += Milliseconds(flatStart, end);
+    }
+    error = std::max(error, compare());
+
+    // 1% of the nodes get a new rotation
+    std::mt19937 rng(3);
+    std::uniform_int_distribution<size_t> pick(0, count - 1);
+    std::uniform_real_distribution<float> angle(-90.0f, 90.0f);
+    double listSparse = 0.0, flatSparse = 0.0;
+    for (int f = 0; f < frames; f++)
+    {
+        for (size_t e = 0; e < std::max<size_t>(count / 100, 1); e++)
+        {
+            const size_t node = pick(rng);
+            const glm::vec3 rotation(angle(rng), angle(rng), angle(rng));
+            nodes[node]->transform.m_eulerRot = rotation;
+            nodes[node]->transform.m_isDirty = true;
+            flat.SetLocalRotation(static_cast<uint32_t>(node), rotation);
+        }
+        const auto listStart = Clock::now();
+        root->updateSelfAndChild();
+        const auto flatStart = Clock::now();
+        flat.Update();
+        const auto end = Clock::now();
+        listSparse += Milliseconds(listStart, flatStart);
+        flatSparse += Milliseconds(flatStart, end);
+    }
+    error = std::max(error, compare());
+    Check(error <= 1e-4f, "TRANSFORM::LIST_MISMATCH");
+
+    std::printf("  %8zu nodes: root rotated %8.3f -> %8.3f ms (%5.1f M nodes/s), 1%% dirty %7.3f -> %7.3f ms, error %.1e\n", count,
+                listAll / frames, flatAll / frames, count / (flatAll / frames) / 1000.0, listSparse / frames, flatSparse / frames, error);
+}
+
+static void EulerAgainstQuaternion(size_t count, int frames)
+{
+    const TreeSource source(count, 1);
+    EulerHierarchy euler(source);
+    TransformHierarchy quaternion;
+    Build(quaternion, source);
+    euler.Update();
+    quaternion.Update();
+    float error = MaxRelativeError(quaternion.world, euler.world);
+
+    // every local changed: each node turns a little. The quaternion setter converts the angles, outside the timing.
+    double eulerAll = 0.0, quaternionAll = 0.0;
+    for (int f = 0; f < frames; f++)
+    {
+        for (uint32_t i = 0; i < count; i++)
+        {
+            const glm::vec3 rotation = source.rotations[i] + glm::vec3(0.5f * (f + 1), 1.0f * (f + 1), 0.0f);
+            euler.localRotation[i] = rotation;
+            euler.dirty[i] = 1;
+            quaternion.SetLocalRotation(i, rotation);
+        }
+        const auto eulerStart = Clock::now();
+        euler.Update();
+        const auto quaternionStart = Clock::now();
+        quaternion.Update();
+        const auto end = Clock::now();
+        eulerAll += Milliseconds(eulerStart, quaternionStart);
+        quaternionAll += Milliseconds(quaternionStart, end);
+    }
+    error = std::max(error, MaxRelativeError(quaternion.world, euler.world));
+
+    // only the root changed: the euler path rebuilds every local matrix, the cached one only redoes parent * local
+    double eulerRoot = 0.0, quaternionRoot = 0.0;
+    for (int f = 0; f < frames; f++)
+    {
+        const glm::vec3 rotation = euler.localRotation[0] + glm::vec3(0.0f, 1.5f, 0.0f);
+        euler.localRotation[0] = rotation;
+        euler.dirty[0] = 1;
+        quaternion.SetLocalRotation(0, rotation);
+        const auto eulerStart = Clock::now();
+        euler.Update();
+        const auto quaternionStart = Clock::now();
+        quaternion.Update();
+        const auto end = Clock::now();
+        eulerRoot += Milliseconds(eulerStart, quaternionStart);
+        quaternionRoot += Milliseconds(quaternionStart, end);
+    }
+    error = std::max(error, MaxRelativeError(quaternion.world, euler.world));
+    Check(error <= 3.3e-5f, "TRANSFORM::QUATERNION_MISMATCH");
+
+    const double perNode = 1e6 / (double(frames) * count);
+    std::printf("  %8zu nodes: every local changed %5.1f -> %5.1f ns, only the root changed %5.1f -> %5.1f ns, error %.1e\n", count,
+                eulerAll * perNode, quaternionAll * perNode, eulerRoot * perNode, quaternionRoot * perNode, error);
+}
+
+static void Parallel(JobSystem &jobs, size_t count, int frames, size_t grain)
+{
+    const TreeSource source(count, 1);
+    TransformHierarchy serial, parallel;
+    Build(serial, source);
+    Build(parallel, source);
+    serial.Update();
+    parallel.Update(jobs, false, grain);
+    bool identical = SameResult(serial, parallel);
+
+    std::mt19937 serialRng(2), parallelRng(2);
+    const size_t editCount = std::max<size_t>(count / 200, 1);
+    double serialTime = 0.0, parallelTime = 0.0;
+    for (int f = 0; f < frames; f++)
+    {
+        Edit(serial, serialRng, editCount, f % 4 == 0);
+        Edit(parallel, parallelRng, editCount, f % 4 == 0);
+        const auto serialStart = Clock::now();
+        serial.Update();
+        const auto parallelStart = Clock::now();
+        parallel.Update(jobs, false, grain);
+        const auto end = Clock::now();
+        serialTime += Milliseconds(serialStart, parallelStart);
+        parallelTime += Milliseconds(parallelStart, end);
+        identical = identical && SameResult(serial, parallel);
+    }
+    serial.Update(true);
+    parallel.Update(jobs, true, grain);
+    identical = identical && SameResult(serial, parallel);
+    Check(identical, "TRANSFORM::PARALLEL_MISMATCH");
+
+    std::printf("  %8zu nodes, depth %zu: serial %8.3f ms, parallel %8.3f ms per frame, %s\n", count, serial.Depth(),
+                serialTime / frames, parallelTime / frames, identical ? "identical" : "MISMATCH");
+}
+
+static void Subtree(size_t count, int frames)
+{
+    const TreeSource source(count, 1);
+    TransformHierarchy full, subtree;
+    Build(full, source);
+    Build(subtree, source);
+    full.Update();
+    subtree.Update();
+
+    const uint32_t root = 1;
+    std::vector<uint8_t> inside(count, 0);
+    std::vector<uint32_t> insideNodes, outsideNodes;
+    for (uint32_t i = 0; i < count; i++)
+    {
+        const uint32_t p = full.parent[i];
+        inside[i] = i == root || (p != TransformHierarchy::None && inside[p]);
+        (inside[i] ? insideNodes : outsideNodes).push_back(i);
+    }
+
+    std::mt19937 rng(3);
+    std::uniform_real_distribution<float> unit(-1.0f, 1.0f);
+    const size_t editCount = std::max<size_t>(insideNodes.size() / 200, 1);
+    double fullTime = 0.0, subtreeTime = 0.0;
+    bool identical = true;
+    for (int f = 0; f < frames; f++)
+    {
+        for (size_t e = 0; e < editCount; e++)
+        {
+            const uint32_t node = insideNodes[rng() % insideNodes.size()];
+            const glm::vec3 position(unit(rng), unit(rng), unit(rng));
+            full.SetLocalPosition(node, position);
+            subtree.SetLocalPosition(node, position);
+        }
+        const uint32_t outside = outsideNodes[rng() % outsideNodes.size()];
+        const glm::mat4 outsideWorld = subtree.world[outside];
+        subtree.SetLocalScale(outside, glm::vec3(1.5f));
+
+        const auto fullStart = Clock::now();
+        full.Update();
+        const auto subtreeStart = Clock::now();
+        subtree.UpdateSubtree(root);
+        const auto end = Clock::now();
+        fullTime += Milliseconds(fullStart, subtreeStart);
+        subtreeTime += Milliseconds(subtreeStart, end);
+
+        for (uint32_t node : insideNodes)
+            identical = identical && std::memcmp(&full.world[node], &subtree.world[node], sizeof(glm::mat4)) == 0 && !subtree.dirty[node];
+        identical = identical && full.ChangedNodes() == subtree.ChangedNodes();
+        identical = identical && subtree.dirty[outside] && !subtree.Changed(outside) && subtree.world[outside] == outsideWorld;
+    }
+    Check(identical, "TRANSFORM::SUBTREE_MISMATCH");
+
+    std::printf("  %8zu nodes, subtree of %zu: Update() %8.3f ms, UpdateSubtree() %8.3f ms per frame, %s\n", count, insideNodes.size(),
+                fullTime / frames, subtreeTime / frames, identical ? "identical" : "MISMATCH");
+}
+
+int main(int argc, char **argv)
+{
+    const bool quick = Quick(argc, argv);
+    const std::vector<size_t> sizes = quick ? std::vector<size_t>{ 10000, 100000 } : std::vector<size_t>{ 10000, 100000, 1000000 };
+    const int frames = quick ? 8 : 40;
+
+    std::printf("Entity list and recursion -> TransformHierarchy::Update(), per frame:\n");
+    for (size_t count : sizes)
+        ListAgainstFlat(count, quick ? 2 : 10);
+
+    std::printf("euler angles -> quaternion and cached local matrix, per node:\n");
+    for (size_t count : sizes)
+        EulerAgainstQuaternion(count, quick ? 2 : 10);
+
+    // at least three workers, so the levels are split even on a single core
+    JobSystem jobs(std::max(3u, std::thread::hardware_concurrency() - 1));
+    const size_t grain = 64;
+    std::printf("Update() vs Update(jobs) on %u threads, grain %zu, 0.5%% of the nodes edited per frame, root rotated every 4th:\n",
+                jobs.ThreadCount(), grain);
+    for (size_t count : sizes)
+        Parallel(jobs, count, frames, grain);
+
+    std::printf("Update() vs UpdateSubtree() of the root's first child, 0.5%% of the subtree edited per frame:\n");
+    for (size_t count : sizes)
+        Subtree(count, frames);
+    return Failures() != 0;
+}
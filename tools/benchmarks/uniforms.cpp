@@ -0,0 +1,129 @@
+// Cost of setting uniforms by name: the glGetUniformLocation + std::to_string path the setters used before,
+// a std::string hashed into a UniformName at run time, and constexpr UniformNames hashed at compile time. Each frame
+// sets the 21 uniforms of a multiple-lights style shader. UniformTable must give the driver's location for every
+// plain, array and name[i] uniform, and -1 for names the program doesn't have.
+#include "gl_context.h"
+#include "benchmark.h"
+
+#include <learnopengl/filesystem.h>
+#include <learnopengl/shader.h>
+
+#include <cstdio>
+#include <string>
+
+using namespace Benchmark;
+
+static const int LightCount = 4;
+
+static const glm::mat4 Identity(1.0f);
+static const glm::vec3 Color(0.8f, 0.7f, 0.6f);
+
+// the setters before the uniform table: one glGetUniformLocation per call, names built per light
+static void SetByQuery(GLuint program)
+{
+    glUniformMatrix4fv(glGetUniformLocation(program, std::string("model").c_str()), 1, GL_FALSE, &Identity[0][0]);
+    glUniformMatrix4fv(glGetUniformLocation(program, std::string("view").c_str()), 1, GL_FALSE, &Identity[0][0]);
+    glUniformMatrix4fv(glGetUniformLocation(program, std::string("projection").c_str()), 1, GL_FALSE, &Identity[0][0]);
+    glUniform3fv(glGetUniformLocation(program, std::string("viewPos").c_str()), 1, &Color[0]);
+    glUniform1f(glGetUniformLocation(program, std::string("shininess").c_str()), 1.0f);
+    for (int i = 0; i < LightCount; i++)
+    {
+        const std::string light = "pointLights[" + std::to_string(i) + "]";
+        glUniform3fv(glGetUniformLocation(program, (light + ".position").c_str()), 1, &Color[0]);
+        glUniform3fv(glGetUniformLocation(program, (light + ".color").c_str()), 1, &Color[0]);
+        glUniform1f(glGetUniformLocation(program, (light + ".linear").c_str()), 0.09f);
+        glUniform3fv(glGetUniformLocation(program, ("lightPositions[" + std::to_string(i) + "]").c_str()), 1, &Color[0]);
+    }
+}
+
+// the same names built as std::strings, hashed into a UniformName by the setters
+static void SetByString(const Shader &shader)
+{
+    shader.setMat4(std::string("model"), Identity);
+    shader.setMat4(std::string("view"), Identity);
+    shader.setMat4(std::string("projection"), Identity);
+    shader.setVec3(std::string("viewPos"), Color);
+    shader.setFloat(std::string("shininess"), 1.0f);
+    for (int i = 0; i < LightCount; i++)
+    {
+        const std::string light = "pointLights[" + std::to_string(i) + "]";
+        shader.setVec3(light + ".position", Color);
+        shader.setVec3(light + ".color", Color);
+        shader.setFloat(light + ".linear", 0.09f);
+        shader.setVec3("lightPositions[" + std::to_string(i) + "]", Color);
+    }
+}
+
+// names hashed at compile time
+static void SetByConstant(const Shader &shader)
+{
+    static constexpr UniformName positions[LightCount] = { "pointLights[0].position", "pointLights[1].position", "pointLights[2].position", "pointLights[3].position" };
+    static constexpr UniformName colors[LightCount] = { "pointLights[0].color", "pointLights[1].color", "pointLights[2].color", "pointLights[3].color" };
+    static constexpr UniformName linears[LightCount] = { "pointLights[0].linear", "pointLights[1].linear", "pointLights[2].linear", "pointLights[3].linear" };
+    static constexpr UniformName lightPositions[LightCount] = { "lightPositions[0]", "lightPositions[1]", "lightPositions[2]", "lightPositions[3]" };
+    shader.setMat4("model"_uniform, Identity);
+    shader.setMat4("view"_uniform, Identity);
+    shader.setMat4("projection"_uniform, Identity);
+    shader.setVec3("viewPos"_uniform, Color);
+    shader.setFloat("shininess"_uniform, 1.0f);
+    for (int i = 0; i < LightCount; i++)
+    {
+        shader.setVec3(positions[i], Color);
+        shader.setVec3(colors[i], Color);
+        shader.setFloat(linears[i], 0.09f);
+        shader.setVec3(lightPositions[i], Color);
+    }
+}
+
+int main(int argc, char **argv)
+{
+    const bool quick = Quick(argc, argv);
+    const int frames = quick ? 1000 : 100000;
+    if (!CreateContext())
+        return 1;
+    {
+        Shader shader(FileSystem::getPath("tools/benchmarks/uniforms.vs").c_str(), FileSystem::getPath("tools/benchmarks/uniforms.fs").c_str());
+        shader.use();
+
+        const char *names[] = { "model", "view", "projection", "viewPos", "shininess", "texture_diffuse1",
+                                "lightPositions", "lightPositions[0]", "lightPositions[1]", "lightPositions[2]", "lightPositions[3]",
+                                "pointLights[0].position", "pointLights[1].color", "pointLights[2].linear", "pointLights[3].position",
+                                "lightPositions[4]", "pointLights[4].color", "pointLights", "missing" };
+        int mismatches = 0;
+        for (const char *name : names)
+        {
+            const GLint expected = glGetUniformLocation(shader.ID, name);
+            const GLint byString = shader.uniforms.Location(std::string(name));
+            const GLint byLiteral = shader.uniforms.Location(UniformName(name));
+            if (byString != expected || byLiteral != expected)
+            {
+                std::printf("  %s: driver %d, table %d\n", name, expected, byString);
+                mismatches++;
+            }
+        }
+        std::printf("%zu names, %zu table entries, %d mismatches\n", sizeof(names) / sizeof(names[0]), shader.uniforms.Size(), mismatches);
+        Check(mismatches == 0, "UNIFORMS::LOCATION_MISMATCH");
+
+        const auto queryStart = Clock::now();
+        for (int f = 0; f < frames; f++)
+            SetByQuery(shader.ID);
+        const auto stringStart = Clock::now();
+        for (int f = 0; f < frames; f++)
+            SetByString(shader);
+        const auto constantStart = Clock::now();
+        for (int f = 0; f < frames; f++)
+            SetByConstant(shader);
+        glFinish();
+        const auto end = Clock::now();
+        Check(glGetError() == GL_NO_ERROR, "UNIFORMS::GL_ERROR");
+
+        const int setters = 5 + LightCount * 4;
+        std::printf("%d frames of %d setters, per setter:\n", frames, setters);
+        std::printf("  glGetUniformLocation + std::to_string %7.1f ns\n", Microseconds(queryStart, stringStart) * 1000.0 / (double(frames) * setters));
+        std::printf("  std::string -> UniformName            %7.1f ns\n", Microseconds(stringStart, constantStart) * 1000.0 / (double(frames) * setters));
+        std::printf("  constexpr UniformName                 %7.1f ns\n", Microseconds(constantStart, end) * 1000.0 / (double(frames) * setters));
+        glDeleteProgram(shader.ID);
+    }
+    DestroyContext();
+    return Failures() != 0;
+}
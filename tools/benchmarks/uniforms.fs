@@ -0,0 +1,27 @@
+#version 330 core
+out vec4 FragColor;
+
+struct PointLight {
+    vec3 position;
+    vec3 color;
+    float linear;
+};
+
+#define NR_POINT_LIGHTS 4
+
+uniform PointLight pointLights[NR_POINT_LIGHTS];
+uniform vec3 lightPositions[NR_POINT_LIGHTS];
+uniform vec3 viewPos;
+uniform float shininess;
+uniform sampler2D texture_diffuse1;
+
+void main()
+{
+    vec3 color = texture(texture_diffuse1, vec2(0.5)).rgb;
+    for (int i = 0; i < NR_POINT_LIGHTS; i++)
+    {
+        float distance = length(pointLights[i].position - viewPos) + length(lightPositions[i] - viewPos);
+        color += pointLights[i].color / (1.0 + pointLights[i].linear * distance);
+    }
+    FragColor = vec4(pow(color, vec3(shininess)), 1.0);
+}
@@ -0,0 +1,127 @@
+// VertexPacking batch encoders against encoding one value at a time (the scalar path), which must give the same bits,
+// and the PackingReport of both packed formats on a UV sphere with a full tangent frame. Needs a GL context because
+// Pack() returns an uploaded mesh.
+#include "gl_context.h"
+#include "benchmark.h"
+
+#include <learnopengl/vertex_packing.h>
+
+#include <cstdio>
+#include <iostream>
+#include <random>
+#include <vector>
+
+using namespace Benchmark;
+
+static void Encoders(bool quick)
+{
+    const size_t n = quick ? 10000 : 4000000;
+    std::mt19937 rng(1);
+    std::uniform_real_distribution<float> wide(-70000.0f, 70000.0f), unit(-1.0f, 1.0f);
+    std::vector<float> values(n);
+    for (size_t i = 0; i < n; i++)
+        values[i] = i % 3 == 0 ? wide(rng) : i % 3 == 1 ? unit(rng) * 1e-5f : unit(rng);
+    values[0] = NAN; values[1] = INFINITY; values[2] = -0.0f; values[3] = 65504.0f; values[4] = 65520.0f; values[5] = 6e-8f;
+    values[6] = 0.5f / 32767.0f; values[7] = 1.5f / 32767.0f; // snorm16 ties
+
+    std::vector<uint16_t> half(n), halfScalar(n);
+    const auto halfStart = Clock::now();
+    VertexPacking::FloatToHalf(values.data(), half.data(), n);
+    const auto halfScalarStart = Clock::now();
+    for (size_t i = 0; i < n; i++)
+        halfScalar[i] = VertexPacking::FloatToHalf(values[i]);
+    const auto halfEnd = Clock::now();
+    Check(half == halfScalar, "VERTEX_PACKING::HALF_MISMATCH");
+
+    std::vector<float> normals(n);
+    for (size_t i = 0; i < n; i++)
+        normals[i] = i < 8 ? values[i + 6] : unit(rng) * 1.1f;
+    std::vector<int16_t> snorm(n), snormScalar(n);
+    const auto snormStart = Clock::now();
+    VertexPacking::FloatToSnorm16(normals.data(), snorm.data(), n);
+    const auto snormScalarStart = Clock::now();
+    for (size_t i = 0; i < n; i++)
+        VertexPacking::FloatToSnorm16(&normals[i], &snormScalar[i], 1);
+    const auto snormEnd = Clock::now();
+    Check(snorm == snormScalar, "VERTEX_PACKING::SNORM16_MISMATCH");
+
+    // xyz_ quadruples as QuantizeUnorm16 reads them
+    const size_t points = n / 4;
+    std::vector<float> positions(points * 4);
+    for (size_t i = 0; i < points; i++)
+    {
+        positions[i * 4] = unit(rng) * 10.0f; positions[i * 4 + 1] = unit(rng) * 10.0f; positions[i * 4 + 2] = unit(rng) * 10.0f;
+        positions[i * 4 + 3] = 0.0f;
+    }
+    const glm::vec3 offset(-10.0f), scale(20.0f);
+    std::vector<uint16_t> unorm(points * 4), unormScalar(points * 4);
+    const auto unormStart = Clock::now();
+    VertexPacking::QuantizeUnorm16(positions.data(), unorm.data(), points, offset, scale);
+    const auto unormScalarStart = Clock::now();
+    for (size_t i = 0; i < points; i++)
+        VertexPacking::QuantizeUnorm16(&positions[i * 4], &unormScalar[i * 4], 1, offset, scale);
+    const auto unormEnd = Clock::now();
+    Check(unorm == unormScalar, "VERTEX_PACKING::UNORM16_MISMATCH");
+
+    std::printf("%zu values, batch vs one at a time:\n", n);
+    std::printf("  half     %7.2f ms vs %7.2f ms, %s\n", Milliseconds(halfStart, halfScalarStart), Milliseconds(halfScalarStart, halfEnd),
+                half == halfScalar ? "identical" : "MISMATCH");
+    std::printf("  snorm16  %7.2f ms vs %7.2f ms, %s\n", Milliseconds(snormStart, snormScalarStart), Milliseconds(snormScalarStart, snormEnd),
+                snorm == snormScalar ? "identical" : "MISMATCH");
+    std::printf("  unorm16  %7.2f ms vs %7.2f ms, %s (%zu positions)\n", Milliseconds(unormStart, unormScalarStart),
+                Milliseconds(unormScalarStart, unormEnd), unorm == unormScalar ? "identical" : "MISMATCH", points);
+}
+
+// latitude/longitude sphere with tangents along the longitude and the handedness flipped on one half
+static Mesh Sphere(int rings, int segments)
+{
+    vector<StaticVertex> vertices;
+    vector<unsigned int> indices;
+    const float pi = 3.14159265358979f;
+    for (int r = 0; r <= rings; r++)
+        for (int s = 0; s <= segments; s++)
+        {
+            const float theta = pi * r / rings, phi = 2.0f * pi * s / segments;
+            StaticVertex v{};
+            v.Normal = glm::vec3(std::sin(theta) * std::cos(phi), std::cos(theta), std::sin(theta) * std::sin(phi));
+            v.Position = v.Normal * 5.0f + glm::vec3(100.0f, 0.0f, -20.0f);
+            v.Tangent = glm::vec4(-std::sin(phi), 0.0f, std::cos(phi), s < segments / 2 ? 1.0f : -1.0f);
+            v.TexCoords = glm::vec2(float(s) / segments * 4.0f, float(r) / rings);
+            vertices.push_back(v);
+        }
+    for (int r = 0; r < rings; r++)
+        for (int s = 0; s < segments; s++)
+        {
+            const unsigned int a = r * (segments + 1) + s, b = a + segments + 1;
+            indices.insert(indices.end(), { a, b, a + 1, a + 1, b, b + 1 });
+        }
+    return Mesh(vertices, indices, {});
+}
+
+int main(int argc, char **argv)
+{
+    const bool quick = Quick(argc, argv);
+#if defined(LOGL_SSE2)
+    std::printf("SSE2 path\n");
+#else
+    std::printf("scalar path\n");
+#endif
+    Encoders(quick);
+
+    if (!CreateContext())
+        return 1;
+    {
+        const Mesh sphere = Sphere(quick ? 32 : 256, quick ? 64 : 512);
+        PackingReport packed, quantized;
+        VertexPacking::Pack<PackedVertex>(sphere, &packed);
+        VertexPacking::Pack<QuantizedVertex>(sphere, &quantized);
+        std::cout << "PackedVertex:    " << packed << "\n" << "QuantizedVertex: " << quantized << std::endl;
+        for (const PackingReport *report : { &packed, &quantized })
+        {
+            Check(report->handednessErrors == 0, "VERTEX_PACKING::HANDEDNESS");
+            Check(report->maxNormalError < 0.1f && report->maxTangentError < 0.1f, "VERTEX_PACKING::FRAME_ERROR");
+        }
+    }
+    DestroyContext();
+    return Failures() != 0;
+}